@@ -26,14 +26,14 @@ void fsk4_writebyte(uint8_t b) {
     uint8_t symbol = (b & 0xC0) >> 6;
     // Modulate
     si4063_set_frequency_offset(22 * symbol);
-    delay(10);
+    delay(FSK4_SYMBOL_MS);
     // Shift to next symbol.
     b = b << 2;
   }
 }
 
 void fsk4_write(char *buff, size_t len) {
-  for (int i = 0; i < len; i++) {
+  for (size_t i = 0; i < len; i++) {
     fsk4_writebyte(buff[i]);
   }
 }
@@ -20,9 +20,12 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <Arduino.h>
 #include "si4063.h"
-#include "delay_timer.h"
 #include <SPI.h>
 
+// Each symbol carries 2 bits, so a byte takes 4 symbols
+#define FSK4_SYMBOL_MS (1000 / FSK_BAUD)
+#define FSK4_BYTE_MS (4 * FSK4_SYMBOL_MS)
+
 void fsk4_writebyte(uint8_t b);
 void fsk4_write(char *buff, size_t len);
 void fsk4_preamble(uint8_t len);
@@ -31,10 +31,10 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <SPI.h>
 #include <ArduinoLowPower.h>
 #include <TinyGPSPlus.h>
-#include <TinyBME280.h>
 #include <Scheduler.h>
 #include <SD.h>
 #include "horus_l2.h"
+#include "packet.h"
 #include "config.h"
 #include "crc_calc.h"
 #include "voltage.h"
@@ -43,6 +43,20 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "morse.h"
 #include "utils.h"
 #include "shield.h"
+#include "cadence.h"
+#include "flight_log.h"
+#include "datalog_csv.h"
+#include "i2c_dma.h"
+#include "bme280.h"
+#include "energy.h"
+#include "power.h"
+#include "clock.h"
+#include "profile.h"
+#include "ram.h"
+#include "rate.h"
+#include "track.h"
+#include "ascent.h"
+#include "backfill.h"
 
 // **********************
 // || Native USB Setup ||
@@ -58,47 +72,51 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 // New GPS object
 TinyGPSPlus gps;
 
-// Horus Binary Structures & Variables
-
-// Horus v2 Structure of Packet
-// https://github.com/projecthorus/horusdemodlib/wiki/4-Packet-Format-Details#packet-formats
-struct HorusBinaryPacketV2
-{
-  uint16_t PayloadID;
-  uint16_t Counter;
-  uint8_t Hours;
-  uint8_t Minutes;
-  uint8_t Seconds;
-  float Latitude;
-  float Longitude;
-  uint16_t Altitude;
-  uint8_t Speed;
-  uint8_t Sats;
-  int8_t Temp;
-  uint8_t BattVoltage;
-  // The following bytes (up until the CRC) are user-customizable. These can be changed by using a custom field list (see horusdemodlib)
-  int16_t AscentRate; // Divide by 100
-  int16_t ExtTemp;    // Divide by 10
-  uint8_t Humidity;   // No post-processing
-  uint16_t ExtPress;  // Divide by 10
-  uint8_t dummy1;
-  uint8_t dummy2;
-  uint16_t Checksum;
-} __attribute__((packed));
+// Horus Binary Structures & Variables (struct layout in packet.h)
 
 // Horus Binary V2 Packet
 struct HorusBinaryPacketV2 BinaryPacketV2;
 
-// Buffers and counters.
-char rawbuffer[128];       // Buffer to temporarily store a raw binary packet.
-char codedbuffer[128];     // Buffer to store an encoded binary packet
-char debugbuffer[256];     // Buffer to store debug strings
+// Counters. The packet and text buffers are in the RAM arena (ram.h).
 uint16_t packet_count = 1; // Packet counter
-int call_count = 0;        // Counter to sense when to send callsign
+uint32_t last_call_ms = 0; // Time the callsign was last sent
+uint32_t first_packet_ms = 0; // Time from boot to the start of the first packet
+bool rate_changed = false; // The flight phase, rate or power changed with this packet
 
 // Make sure interval is at the legal limit!
 #if CALLSIGN_INTERVAL > 600000
-#error "Please set the CALLSIGN_INTERVAL to less than or equal to 10 minutes to keep this legal!
+#error "Please set the CALLSIGN_INTERVAL to less than or equal to 10 minutes to keep this legal!"
+#endif
+
+#if defined(GPS_TIME_SYNC) && TX_SLOT_OFFSET >= TX_SLOT_PERIOD
+#error "Please set TX_SLOT_OFFSET to less than TX_SLOT_PERIOD!"
+#endif
+
+// Time from the end of a packet to the next packet build, which reads the GPS
+#ifdef STATUS_LED
+#define STATUS_LED_MS 500
+#else
+#define STATUS_LED_MS 0
+#endif
+#ifdef GPS_TIME_SYNC
+#define AFTER_TX_MS STATUS_LED_MS
+#else
+#define AFTER_TX_MS (STATUS_LED_MS + PACKET_INTERVAL)
+#endif
+
+// Time between packets when every one is used, to pace the callsign
+#ifdef GPS_TIME_SYNC
+#define PACKET_PERIOD CADENCE_PERIOD_MS
+#else
+#define PACKET_PERIOD PACKET_INTERVAL
+#endif
+
+// Time to send one packet, preamble included
+#define PACKET_AIRTIME_MS ((8 + HORUS_L2_TX_BYTES(sizeof(HorusBinaryPacketV2))) * FSK4_BYTE_MS)
+
+// A slot has to hold a whole packet, or the next one starts on top of it
+#ifdef GPS_TIME_SYNC
+static_assert(CADENCE_PERIOD_MS >= PACKET_AIRTIME_MS, "Please set TX_SLOT_PERIOD to at least one packet airtime!");
 #endif
 
 void setup()
@@ -107,6 +125,28 @@ void setup()
   // || Runtime Initialization ||
   // ****************************
 
+  // Paint the free RAM, to find the deepest the stack goes
+  ram_begin();
+
+  // Crystal timebase for the cadence and the energy accounting, and a first measurement of the slow CPU clock
+  clock_begin();
+
+  // Time the hot paths, if PROFILE is set in config.h
+  profile_begin();
+
+  // Start on the pad, at the pad rate and power
+  rate_begin();
+
+  // No track until the GPS has fixes
+  track_begin();
+  ascent_begin();
+
+  // Nothing kept to send again yet
+  backfill_begin();
+
+  // Start counting where the charge goes, before anything is powered up
+  energy_begin();
+
   // Begin the Serial Monitor
 #ifdef DEV_MODE
   Serial.begin(9600);
@@ -120,6 +160,10 @@ void setup()
   pinMode(NSEL, OUTPUT);
   pinMode(SDN, OUTPUT);
 
+  // Battery voltage is measured in the background from here on
+  voltage_begin();
+  voltage_start();
+
   // ************************
   // || GPS Initialization ||
   // ************************
@@ -148,6 +192,11 @@ void setup()
   // Set to Airborne Mode (<1g) using CASIC11 command
   Serial1.write("$PCAS11,5*18\r\n");
 
+#ifdef GPS_TIME_SYNC
+  // Listen for the GPS time pulse to lock packets to GPS time
+  cadence_begin();
+#endif
+
 #ifdef STATUS_LED
   digitalWrite(SUCCESS_LED, HIGH);
   delay(1000);
@@ -166,31 +215,18 @@ void setup()
   // Initialize SPI for Si4063
   SPI.begin();
   configureSi4063();
+  morse_begin();
 
 #ifdef DEV_MODE
   Serial.println("Radio Initialized!");
 #endif
 
-  // ***********************
-  // || Initialize BME280 ||
-  // ***********************
-
-#ifdef DEV_MODE
-  Serial.println("Initializing BME280...");
-#endif
-
-  Wire.begin();
-  BME280setI2Caddress(0x76);
-  BME280setup();
-
-#ifdef DEV_MODE
-  Serial.println("BME280 initialized!");
-#endif
-
   // ************************
   // || Inititalize Shield ||
   // ************************
-  initialize_shield(); // If any external sensors are detected, initialize them
+  // I2C bus, shared by Wire and the DMA transfers of the OLED and BME280
+  i2c_dma_begin();
+  initialize_shield(); // Finds the BME280, IMU and OLED, and initializes each of them
 
   if (oled_found)
   {
@@ -200,7 +236,43 @@ void setup()
   }
   if (sd_found)
   {
-    sd_card_write_line("datalog.csv", "PayloadID,Counter,Hours,Minutes,Seconds,Latitude,Longitude,Altitude,Speed,Sats,Temp,BattVoltage,AscentRate,ExtTemp,Humidity,ExtPress");
+    // Keep the binary flight log open for the whole flight
+    if (flight_log_begin("FLIGHT.BIN"))
+    {
+      // After a reset mid-flight, carry on counting packets from the last one logged
+      flight_log_record last;
+      if (flight_log_last(&last))
+      {
+        packet_count = last.packet.Counter + 1;
+      }
+#ifdef DEV_MODE
+      Serial.print("Flight log resumed in ");
+      Serial.print(flight_log_get_stats()->resume_us);
+      Serial.print(" us, ");
+      Serial.print(flight_log_get_stats()->resume_reads);
+      Serial.print(" reads. Next packet: ");
+      Serial.println(packet_count);
+#endif
+    }
+    else
+    {
+#ifdef DEV_MODE
+      Serial.println("Could not open the flight log!");
+#endif
+    }
+    // The CSV logs stay open too. Only a new file gets a header row.
+#ifdef SD_CSV_LOG
+    sd_card_log_begin(SD_LOG_DATALOG, "datalog.csv", DATALOG_HEADER);
+#endif
+#ifdef CLOCK_SCALING
+    sd_card_log_begin(SD_LOG_CLOCK, "clock.csv", CLOCK_LOG_HEADER);
+#endif
+#ifdef PROFILE_SD_LOG
+    sd_card_log_begin(SD_LOG_PROFILE, "profile.csv", PROFILE_LOG_HEADER);
+#endif
+#ifdef ADAPTIVE_RATE
+    sd_card_log_begin(SD_LOG_RATE, "rate.csv", RATE_LOG_HEADER);
+#endif
   }
 
   // ******************************
@@ -210,7 +282,10 @@ void setup()
   sendCallsign();
 
 #ifdef DEV_MODE
-  Serial.println("Setup done! Beginning control flow.");
+  Serial.print("Setup done in ");
+  Serial.print(millis());
+  Serial.println(" ms! Beginning control flow.");
+  ram_print();
 #endif
 
 #ifdef STATUS_LED
@@ -222,6 +297,12 @@ void setup()
   // *************************
   // || Scheduler Execution ||
   // *************************
+  // The callsign goes out in the background, and has to be done before the radio is put to rest
+  morse_wait();
+
+  // Radio, GPS and display to their low power states, if ULTRA_LOW_POWER is set
+  power_begin();
+
   Scheduler.startLoop(gpsFeed);
 }
 
@@ -232,27 +313,90 @@ void loop()
   // *********************
   int coded_len;
   int pkt_len;
+  char *coded = arena.coded;
+
+#ifdef GPS_TIME_SYNC
+  // Sleep through the slots this packet skips, if the flight phase sends less often
+  cadence_wait_for_build();
+#endif
+
+  // Every so often the slot goes to a packet sent before, kept encoded and ready to go
+  bool backfill = backfill_due(cadence_millis());
+
+  // Start the BME280 conversion now, so it is ready by the time the packet is built
+  if (!backfill)
+  {
+    bme280_start();
+  }
 
   // ***************************
   // || Callsign Transmission ||
   // ***************************
 
-  // Check if it's the right time to send the callsign
-  if (call_count * PACKET_INTERVAL >= CALLSIGN_INTERVAL)
+  // Send the callsign now if waiting for the next packet would make it late. The time is measured, so
+  // slots that slip, or a packet held back behind the callsign, are counted too.
+  if (cadence_millis() - last_call_ms >= CALLSIGN_INTERVAL - (rate_slots() * PACKET_PERIOD + PACKET_AIRTIME_MS))
   {
-    // Send the callsign, and reset the counter
+    // Start the callsign. The packet is built while it is keyed.
     sendCallsign();
-    call_count = 0;
+    last_call_ms = cadence_millis();
   }
 
   // ***************************
   // || Generate Horus Packet ||
   // ***************************
+  // Full speed for building and encoding, then back to the slow clock for the wait and the symbols
+  if (backfill)
+  {
+    coded_len = backfill_take(&coded);
+#if defined(DEV_MODE) && defined(BACKFILL)
+    Serial.print(F("Sending a kept packet again, "));
+    Serial.print(backfill_get_stats()->pending);
+    Serial.println(F(" more kept"));
+#endif
+  }
+  else
+  {
+    clock_set(CLOCK_FAST);
+#ifdef DEV_MODE
+    Serial.println(F("Generating Horus Binary v2 Packet"));
+#endif
+    {
+      PROFILE_SCOPE(PROFILE_BUILD);
+      pkt_len = build_horus_binary_packet_v2(arena.raw);
+    }
+    {
+      PROFILE_SCOPE(PROFILE_ENCODE);
+      coded_len = horus_l2_encode_tx_packet((unsigned char *)arena.coded, (unsigned char *)arena.raw, pkt_len);
+    }
+    backfill_store(arena.raw, pkt_len, cadence_millis());
+    clock_set(CLOCK_SLOW);
+    // Blink for a packet built, outside the profiled build so the delay is not timed with it
+#ifdef STATUS_LED
+    digitalWrite(SUCCESS_LED, HIGH);
+    delay(500);
+    digitalWrite(SUCCESS_LED, LOW);
+#endif
+  }
+
+  // The radio is free once the callsign is out
+  morse_wait();
 #ifdef DEV_MODE
-  Serial.println(F("Generating Horus Binary v2 Packet"));
+  static uint32_t callsigns_reported = 0;
+  const morse_stats *morse = morse_get_stats();
+  if (morse->callsigns != callsigns_reported)
+  {
+    callsigns_reported = morse->callsigns;
+    Serial.print(F("Callsign key down (us): "));
+    Serial.print(morse->key_down_us);
+    Serial.print(F(", max: "));
+    Serial.print(morse->key_down_max_us);
+    Serial.print(F(", key up (us): "));
+    Serial.print(morse->key_up_us);
+    Serial.print(F(", max: "));
+    Serial.println(morse->key_up_max_us);
+  }
 #endif
-  pkt_len = build_horus_binary_packet_v2(rawbuffer);
-  coded_len = horus_l2_encode_tx_packet((unsigned char *)codedbuffer, (unsigned char *)rawbuffer, pkt_len);
 
   // *******************
   // || Transmit Time ||
@@ -261,18 +405,142 @@ void loop()
   Serial.println(F("Transmitting Horus Binary v2 Packet"));
 #endif
 
+#ifdef GPS_TIME_SYNC
+  // The fix for this packet is taken. The GPS can rest until shortly before the slot's time pulse.
+  if (gps_can_rest())
+  {
+    power_gps_rest(cadence_next_slot_ms());
+  }
+
+  // Wait (or sleep) until this tracker's slot starts
+  cadence_wait_for_slot();
+#endif
+
+  // The flight phase's power. Only changes take the few SPI transfers, which fall in the slot timing.
+  static uint8_t tx_power = OUTPUT_POWER;
+  if (rate_power() != tx_power)
+  {
+    tx_power = rate_power();
+    si4063_set_tx_power(tx_power);
+    energy_set_tx_power(tx_power);
+  }
+
   // Start sending out a continuous signal
   si4063_enable_tx();
+#ifdef GPS_TIME_SYNC
+  cadence_mark_tx_start();
+#endif
+  if (first_packet_ms == 0)
+  {
+    first_packet_ms = millis();
+  }
+
+  // The flight phase's rate from the next packet on
+#ifdef GPS_TIME_SYNC
+  cadence_set_slots(rate_slots());
+#endif
+
+  // Nothing needs the GPS until the next packet is built, right after this one ends or a period
+  // ahead of the next slot used
+  if (gps_can_rest())
+  {
+    uint32_t build_ms = cadence_millis() + (8 + coded_len) * FSK4_BYTE_MS + AFTER_TX_MS;
+#ifdef GPS_TIME_SYNC
+    if ((int32_t)(cadence_next_build_ms() - build_ms) > 0)
+    {
+      build_ms = cadence_next_build_ms();
+    }
+#endif
+    power_gps_rest(build_ms);
+  }
 
   // Take the buffer, convert to symbols 0-3, and send them by setting the frequency
   fsk4_preamble(8);
-  fsk4_write(codedbuffer, coded_len);
+  fsk4_write(coded, coded_len);
 
   // End the transmission
   si4063_inhibit_tx();
+  power_idle();
 
 #ifdef DEV_MODE
   Serial.println(F("Transmission complete!"));
+  static bool first_packet_reported = false;
+  if (!first_packet_reported)
+  {
+    Serial.print(F("Time to first packet (ms): "));
+    Serial.println(first_packet_ms);
+    first_packet_reported = true;
+  }
+#ifdef GPS_TIME_SYNC
+  Serial.print(F("Slot timing error (us): "));
+  Serial.print(cadence_get_stats()->last_error_us);
+  Serial.print(F(", min: "));
+  Serial.print(cadence_get_stats()->min_error_us);
+  Serial.print(F(", max: "));
+  Serial.println(cadence_get_stats()->max_error_us);
+#endif
+#ifdef CLOCK_SCALING
+  const clock_stats *clocks = clock_get_stats();
+  for (uint8_t i = 0; i < CLOCK_SPEEDS; i++)
+  {
+    Serial.print(i == CLOCK_FAST ? F("CPU fast (Hz): ") : F(", slow (Hz): "));
+    Serial.print(clocks->speed[i].hz);
+    Serial.print(F(", awake (ms): "));
+    Serial.print(clocks->speed[i].awake_ms);
+    Serial.print(F(", error (ppm): "));
+    Serial.print(clocks->speed[i].error_ppm);
+  }
+  Serial.print(F(", switch (us): "));
+  Serial.print(clocks->switch_us);
+  Serial.print(F(", max: "));
+  Serial.println(clocks->switch_max_us);
+#endif
+#ifdef ULTRA_LOW_POWER
+  const power_stats *power = power_get_stats();
+  Serial.print(F("Radio wake (us): "));
+  Serial.print(power->radio_wake_us);
+  Serial.print(F(", max: "));
+  Serial.print(power->radio_wake_max_us);
+  Serial.print(F(", GPS rests: "));
+  Serial.print(power->gps_rests);
+  Serial.print(F(" ("));
+  Serial.print(power->gps_rest_ms);
+  Serial.print(F(" ms), wake budget overruns: "));
+  Serial.println(power->overruns);
+#endif
+#endif
+#ifdef ENERGY_PROFILE
+  // Charge used since the last packet, by subsystem
+  energy_report energy;
+  energy_take_report(&energy);
+#ifdef DEV_MODE
+  Serial.print(F("Energy per packet (nAh) over "));
+  Serial.print(energy.duration_ms);
+  Serial.print(F(" ms:"));
+  for (uint8_t i = 0; i < ENERGY_SUBSYSTEMS; i++)
+  {
+    Serial.print(' ');
+    Serial.print(energy_subsystem_name((energy_subsystem)i));
+    Serial.print(' ');
+    Serial.print(energy.charge_nah[i]);
+  }
+  Serial.print(F(", total "));
+  Serial.print(energy.total_nah);
+  Serial.print(F(", since boot (uAh) "));
+  Serial.println(energy.since_boot_uah);
+#endif
+#endif
+#if defined(PROFILE) && defined(DEV_MODE)
+  if (packet_count % PROFILE_LOG_INTERVAL == 0)
+  {
+    profile_print();
+  }
+#endif
+#ifdef DEV_MODE
+  if (packet_count % RAM_REPORT_INTERVAL == 0)
+  {
+    ram_print();
+  }
 #endif
 #ifdef STATUS_LED
   digitalWrite(SUCCESS_LED, HIGH);
@@ -280,18 +548,24 @@ void loop()
   digitalWrite(SUCCESS_LED, LOW);
 #endif
 
-  // Increment packet counter
-  packet_count++;
-  call_count++;
+  // Increment packet counter. A packet sent again keeps the counter it had.
+  if (!backfill)
+  {
+    packet_count++;
+  }
 
   // **********************
   // || Sleep Mode Time! ||
   // **********************
+  // With GPS_TIME_SYNC, the sleep happens while waiting for the next slot instead
+#ifndef GPS_TIME_SYNC
 #ifndef DEV_MODE
-  LowPower.deepSleep(PACKET_INTERVAL);
+  power_deep_sleep(rate_slots() * PACKET_INTERVAL);
 #endif
 #ifdef DEV_MODE
-  delay(PACKET_INTERVAL);
+  delay(rate_slots() * PACKET_INTERVAL);
+#endif
+  power_wake();
 #endif
 }
 
@@ -306,30 +580,77 @@ void gpsFeed()
   {
     gps.encode(Serial1.read());
   }
+  // Move queued I2C transfers along and run their callbacks
+  bme280_service();
+  imu_service();
+  power_service();
+  voltage_service();
+  i2c_dma_service();
+  // Each new GGA fix goes into the dead reckoning track and the ascent rate
+  if (gps.altitude.isUpdated() && gps.location.isValid())
+  {
+    double altitude = gps.altitude.meters();
+    if (altitude > 0 && altitude < 50000)
+    {
+      track_add_fix(gps.location.lat(), gps.location.lng(), altitude, cadence_millis() - gps.location.age());
+      if (gps.time.isValid())
+      {
+        ascent_add(gps.time.hour(), gps.time.minute(), gps.time.second(), gps.time.centisecond(), altitude * 100);
+      }
+    }
+  }
+#ifdef GPS_TIME_SYNC
+  if (gps.time.isUpdated() && gps.time.isValid())
+  {
+    uint32_t age = gps.time.age();
+    cadence_update_time(gps.time.hour(), gps.time.minute(), gps.time.second(), gps.time.centisecond(), age);
+  }
+#endif
   yield();
 }
 
+// The GPS is only put in standby with a good fix, so it never stops in the middle of acquiring one
+bool gps_can_rest()
+{
+  return gps.location.isValid() && gps.location.age() < 2000;
+}
+
+// Sets the packet time to the GPS time moved forward to a local time, to the nearest second
+static void packet_time_at(uint32_t at_ms)
+{
+  uint32_t time_ms = cadence_millis() - gps.time.age();
+  int32_t seconds = gps.time.hour() * 3600L + gps.time.minute() * 60 + gps.time.second();
+  seconds = (seconds + ((int32_t)(at_ms - time_ms) + 500) / 1000) % 86400;
+  if (seconds < 0)
+  {
+    seconds += 86400;
+  }
+  BinaryPacketV2.Hours = seconds / 3600;
+  BinaryPacketV2.Minutes = seconds / 60 % 60;
+  BinaryPacketV2.Seconds = seconds % 60;
+}
+
 // Build the Horus v2 Packet. This is where the GPS positions and telemetry are organized to the struct.
 int build_horus_binary_packet_v2(char *buffer)
 {
-  static float prev_altitude = 0.0f;
-  static unsigned long prev_time = 0;
-  float ascent_rate = 0.0f;
+  bool fix = false;
+
+#ifdef DEAD_RECKONING
+  // The position is given for when the packet goes out
+#ifdef GPS_TIME_SYNC
+  uint32_t tx_ms = cadence_next_slot_ms();
+#else
+  uint32_t tx_ms = cadence_millis();
+#endif
+  uint32_t fix_age_ms = gps.location.isValid() ? gps.location.age() : UINT32_MAX;
+  uint32_t fix_ms = cadence_millis() - fix_age_ms;
+#endif
 
 // Fill with GPS readings, with a GPS sanity check
 #ifdef FLAG_BAD_PACKET
   if (gps.altitude.meters() > 0 && gps.altitude.meters() < 50000)
   {
-    if (prev_time != 0)
-    {
-      unsigned long time_diff = millis() - prev_time;
-      if (time_diff > 0)
-      {
-        ascent_rate = (gps.altitude.meters() - prev_altitude) / (time_diff / 1000.0f);
-      }
-    }
-    prev_altitude = gps.altitude.meters();
-    prev_time = millis();
+    fix = true;
 
     BinaryPacketV2.Hours = gps.time.hour();
     BinaryPacketV2.Minutes = gps.time.minute();
@@ -342,7 +663,6 @@ int build_horus_binary_packet_v2(char *buffer)
   }
   else
   {
-    prev_time = 0;
     BinaryPacketV2.Hours = 0;
     BinaryPacketV2.Minutes = 0;
     BinaryPacketV2.Seconds = 0;
@@ -354,6 +674,7 @@ int build_horus_binary_packet_v2(char *buffer)
   }
 #else
   // Or, if you prefer no sanity check, force GPS positions into struct
+  fix = gps.location.isValid();
   BinaryPacketV2.Hours = gps.time.hour();
   BinaryPacketV2.Minutes = gps.time.minute();
   BinaryPacketV2.Seconds = gps.time.second();
@@ -363,83 +684,206 @@ int build_horus_binary_packet_v2(char *buffer)
   BinaryPacketV2.Speed = gps.speed.kmph();
   BinaryPacketV2.Sats = gps.satellites.value();
 #endif
-#ifdef STATUS_LED
-  digitalWrite(SUCCESS_LED, HIGH);
-  delay(500);
-  digitalWrite(SUCCESS_LED, LOW);
+  BinaryPacketV2.dummy2 = 0;
+#ifdef DEAD_RECKONING
+  track_position track;
+  if (fix && fix_age_ms < TRACK_FIX_AGE_MS)
+  {
+    // Move the fix on by the filtered velocity, for as long as it is until the packet goes out
+    if (track_ahead(fix_ms, tx_ms, &track))
+    {
+      BinaryPacketV2.Latitude = gps.location.lat() + track.lat_e7 * 1e-7;
+      BinaryPacketV2.Longitude = gps.location.lng() + track.lon_e7 * 1e-7;
+      // The correction rounded to the metre, so a small one leaves the altitude as the GPS gave it
+      int32_t altitude = (int32_t)gps.altitude.meters() + lround(track.alt_cm / 100.0);
+      BinaryPacketV2.Altitude = altitude > 0 ? altitude : 0;
+      packet_time_at(tx_ms);
+    }
+  }
+  else if (track_coast(tx_ms, &track) && track.alt_cm > 0 && track.alt_cm < 5000000L)
+  {
+    // No fresh fix, so the track is carried on from the last one
+    fix = true;
+    BinaryPacketV2.Latitude = track.lat_e7 * 1e-7;
+    BinaryPacketV2.Longitude = track.lon_e7 * 1e-7;
+    BinaryPacketV2.Altitude = (track.alt_cm + 50) / 100;
+    if (gps.time.isValid())
+    {
+      packet_time_at(tx_ms);
+    }
+    BinaryPacketV2.dummy2 |= PACKET_FLAG_DEAD_RECKONED;
+  }
 #endif
 
   // Non-GPS values
   BinaryPacketV2.PayloadID = HORUS_ID;
   BinaryPacketV2.Counter = packet_count;
-  BinaryPacketV2.BattVoltage = (int)mapf((double)readVoltage(), 0.00, 5.00, 0, 255);
-  BinaryPacketV2.Temp = BME280temperature() / 100.00;
+  uint16_t battery_mv = voltage_mv();
+  BinaryPacketV2.BattVoltage = voltage_packet_byte(battery_mv);
+
+  // One burst read of the BME280 gives all three readings
+  bme280_wait();
+  const bme280_data *bme = bme280_get();
+  int32_t temperature = bme->temperature;
+  int32_t humidity = bme->humidity;
+  int32_t pressure = bme->pressure;
+  BinaryPacketV2.Temp = temperature / 100.00;
 
   // User-Customizable Fields
-  BinaryPacketV2.AscentRate = (int16_t)(ascent_rate * 100);
-  BinaryPacketV2.ExtTemp = (int16_t)(BME280temperature() / 10);
-  BinaryPacketV2.Humidity = (int8_t)(BME280humidity() / 100);
-  BinaryPacketV2.ExtPress = (int16_t)(BME280pressure() / 10);
+  BinaryPacketV2.AscentRate = ascent_cms();
+  BinaryPacketV2.ExtTemp = (int16_t)(temperature / 10);
+  BinaryPacketV2.Humidity = (int8_t)(humidity / 100);
+  BinaryPacketV2.ExtPress = (int16_t)(pressure / 10);
+
+  // Motion since the last packet, from the IMU FIFO
+  imu_summary motion;
+  imu_drain();
+  imu_take_summary(&motion);
+  BinaryPacketV2.dummy1 = motion.peak_accel_mg / 100 > 255 ? 255 : motion.peak_accel_mg / 100;
+
+  // Flight phase, which sets the rate and power from the next packet on
+  rate_changed = rate_update(fix, BinaryPacketV2.Altitude, BinaryPacketV2.AscentRate, battery_mv, cadence_millis());
 
   // End the packet off with a CRC checksum.
-  BinaryPacketV2.Checksum = (uint16_t)crc16((unsigned char *)&BinaryPacketV2, sizeof(BinaryPacketV2) - 2);
+  {
+    PROFILE_SCOPE(PROFILE_CRC);
+    BinaryPacketV2.Checksum = (uint16_t)crc16((unsigned char *)&BinaryPacketV2, sizeof(BinaryPacketV2) - 2);
+  }
 
   // Dump the sensor values to Serial Monitor
 #ifdef DEV_MODE
   Serial.print("Frame Count: ");
   Serial.print(packet_count);
-  Serial.print(", Latitude: ");
-  Serial.print(BinaryPacketV2.Latitude, 7);
-  Serial.print(", Longitude: ");
-  Serial.print(BinaryPacketV2.Longitude, 7);
-  Serial.print(", Altitude MSL: ");
-  Serial.print(BinaryPacketV2.Altitude);
-  Serial.print(", Sats: ");
-  Serial.print(BinaryPacketV2.Sats);
-  Serial.print(", Voltage: ");
-  Serial.print(readVoltage());
-  Serial.print(", Voltage (Scaled): ");
-  Serial.print(BinaryPacketV2.BattVoltage);
-  Serial.print(", Temperature: ");
-  Serial.print(BinaryPacketV2.Temp);
-  Serial.print(", Pressure: ");
-  Serial.print(BinaryPacketV2.ExtPress / 10.00);
-  Serial.print(", Humidity: ");
-  Serial.println(BinaryPacketV2.Humidity);
-#endif
-
-  // If OLED found, print the values
+  Serial.print(", Voltage (mV): ");
+  Serial.println(battery_mv);
+  datalog_text_row(arena.text, BinaryPacketV2);
+  Serial.println(arena.text);
+  if (imu_found)
+  {
+    Serial.print("IMU samples: ");
+    Serial.print(motion.samples);
+    Serial.print(", Peak accel (mg): ");
+    Serial.print(motion.peak_accel_mg);
+    Serial.print(", Vibration (mg RMS): ");
+    Serial.print(motion.vibration_mg);
+    Serial.print(", Spin (dps): ");
+    Serial.print(motion.spin_dps);
+    Serial.print(", FIFO overflows: ");
+    Serial.println(imu_get_stats()->overflows);
+  }
+#ifdef DEAD_RECKONING
+  const track_stats *track_now = track_get_stats();
+  Serial.print(BinaryPacketV2.dummy2 & PACKET_FLAG_DEAD_RECKONED ? "Dead reckoned, velocity N/E/Up (cm/s): " : "Velocity N/E/Up (cm/s): ");
+  Serial.print(track_now->north_cms);
+  Serial.print("/");
+  Serial.print(track_now->east_cms);
+  Serial.print("/");
+  Serial.print(track_now->ascent_cms);
+  Serial.print(", track restarts: ");
+  Serial.print(track_now->restarts);
+  Serial.print(", longest coast (ms): ");
+  Serial.println(track_now->max_coast_ms);
+#endif
+#ifdef ADAPTIVE_RATE
+  if (rate_changed)
+  {
+    const rate_stats *rate = rate_get_stats();
+    Serial.print("Flight phase: ");
+    Serial.print(rate_phase_name(rate->phase));
+    Serial.print(", packet every ");
+    Serial.print(rate->slots);
+    Serial.print(" periods at power ");
+    Serial.print(rate->power);
+    Serial.print(rate->conserve ? ", saving battery (mV): " : ", battery (mV): ");
+    Serial.print(rate->battery_mv);
+    Serial.print(", trend (mV/h): ");
+    Serial.println(rate->trend_mv_h);
+  }
+#endif
+#endif
+
+  // If OLED found, print the values. The low power profile keeps it switched off.
+#ifndef ULTRA_LOW_POWER
   if (oled_found)
   {
     oled_clearDisplay();
     oled_setCursor(0, 0);
-    oled_print_diagnostic("Sats", BinaryPacketV2.Sats, 0);
+    oled_print_fixed("Sats", BinaryPacketV2.Sats, 0);
     oled_print_diagnostic("Lat", BinaryPacketV2.Latitude, 6);
     oled_print_diagnostic("Lon", BinaryPacketV2.Longitude, 6);
-    oled_print_diagnostic("Alt", BinaryPacketV2.Altitude, 1);
+    oled_print_fixed("Alt", BinaryPacketV2.Altitude * 10L, 1);
     oled_display();
+#ifdef DEV_MODE
+    Serial.print("OLED bytes sent: ");
+    Serial.println(oled_bytes_sent());
+#endif
   }
+#endif
   if (sd_found)
   {
-    snprintf(debugbuffer, sizeof(debugbuffer),
-             "%u,%u,%u,%u,%u,%.7f,%.7f,%u,%u,%u,%d,%u,%d,%.2f,%u,%u",
-             BinaryPacketV2.PayloadID,
-             BinaryPacketV2.Counter,
-             BinaryPacketV2.Hours,
-             BinaryPacketV2.Minutes,
-             BinaryPacketV2.Seconds,
-             BinaryPacketV2.Latitude,
-             BinaryPacketV2.Longitude,
-             BinaryPacketV2.Altitude,
-             BinaryPacketV2.Speed,
-             BinaryPacketV2.Sats,
-             BinaryPacketV2.Temp,
-             BinaryPacketV2.BattVoltage,
-             BinaryPacketV2.AscentRate,
-             BinaryPacketV2.ExtTemp / 10,
-             BinaryPacketV2.Humidity,
-             BinaryPacketV2.ExtPress / 10);
-    sd_card_write_line("datalog.csv", debugbuffer);
+    // Raw packet plus the full resolution readings that did not fit in it
+    flight_log_record record;
+    memset(&record, 0, sizeof(record));
+    record.packet = BinaryPacketV2;
+    record.timestamp_ms = cadence_millis();
+    record.pressure_pa = pressure;
+    record.temperature_centi = temperature;
+    record.humidity_centi = humidity;
+    record.battery_mv = battery_mv;
+    record.slot_error_us = cadence_get_stats()->last_error_us;
+    record.peak_accel_mg = motion.peak_accel_mg;
+    record.vibration_mg = motion.vibration_mg;
+    record.spin_dps = motion.spin_dps;
+    flight_log_append(&record);
+#ifdef DEV_MODE
+    const flight_log_stats *log_stats = flight_log_get_stats();
+    if (log_stats->records > 0)
+    {
+      Serial.print("Flight log append (us): ");
+      Serial.print(log_stats->last_us);
+      Serial.print(", avg: ");
+      Serial.print(log_stats->total_us / log_stats->records);
+      Serial.print(", max: ");
+      Serial.println(log_stats->max_us);
+    }
+#endif
+
+#ifdef SD_CSV_LOG
+    datalog_csv_row(arena.text, BinaryPacketV2);
+    sd_card_log_line(SD_LOG_DATALOG, arena.text);
+#endif
+#ifdef ADAPTIVE_RATE
+    // Every change of phase, rate or power, with what it was decided on
+    if (rate_changed)
+    {
+      rate_log_row(arena.text, packet_count, BinaryPacketV2.Altitude, BinaryPacketV2.AscentRate, cadence_millis());
+      sd_card_log_line(SD_LOG_RATE, arena.text);
+    }
+#endif
+#ifdef CLOCK_SCALING
+    // Timing error and modelled current at each CPU speed, every few minutes
+    if (packet_count % CLOCK_LOG_INTERVAL == 0)
+    {
+      for (uint8_t i = 0; i < CLOCK_SPEEDS; i++)
+      {
+        clock_log_row(arena.text, (clock_speed)i);
+        sd_card_log_line(SD_LOG_CLOCK, arena.text);
+      }
+    }
+#endif
+#ifdef PROFILE_SD_LOG
+    // Time taken by each probe so far, every minute
+    if (packet_count % PROFILE_LOG_INTERVAL == 0)
+    {
+      for (uint8_t i = 0; i < PROFILE_PROBES; i++)
+      {
+        if (profile_log_row(arena.text, sizeof(arena.text), (profile_probe)i) > 0)
+        {
+          sd_card_log_line(SD_LOG_PROFILE, arena.text);
+        }
+      }
+    }
+#endif
   }
 
   // Copy the binary packet to the buffer
@@ -0,0 +1,200 @@
+/*
+ascent.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ascent.h"
+#include <string.h>
+
+#define ASCENT_DAY_CS 8640000L
+
+struct ascent_sample
+{
+  int32_t t_cs; // From the epoch
+  int32_t alt_cm;
+};
+
+static ascent_sample ring[ASCENT_WINDOW];
+static uint8_t oldest = 0;
+
+// The epoch, as GPS time of day and altitude
+static int32_t epoch_cs = 0;
+static int32_t epoch_alt_cm = 0;
+
+// Over the window
+static int64_t sum_t, sum_alt, sum_tt, sum_talt;
+
+static int16_t rate_cms = 0;
+
+// Fixes left out in a row, as GPS time of day and altitude
+static ascent_sample rejected[ASCENT_MAX_REJECTS];
+static uint8_t rejects = 0;
+static ascent_stats stats;
+
+void ascent_begin()
+{
+  memset(&stats, 0, sizeof(stats));
+  rate_cms = 0;
+  rejects = 0;
+}
+
+static void ascent_sum(const ascent_sample *s, int sign)
+{
+  sum_t += sign * (int64_t)s->t_cs;
+  sum_alt += sign * (int64_t)s->alt_cm;
+  sum_tt += sign * (int64_t)s->t_cs * s->t_cs;
+  sum_talt += sign * (int64_t)s->t_cs * s->alt_cm;
+}
+
+static ascent_sample *ascent_at(uint8_t i)
+{
+  return &ring[(oldest + i) % ASCENT_WINDOW];
+}
+
+// Empties the window, with this fix as the epoch
+static void ascent_restart(int32_t time_cs, int32_t altitude_cm)
+{
+  stats.window = 0;
+  stats.valid = false;
+  oldest = 0;
+  epoch_cs = time_cs;
+  epoch_alt_cm = altitude_cm;
+  sum_t = sum_alt = sum_tt = sum_talt = 0;
+  rejects = 0;
+}
+
+// Moves the epoch up to the oldest fix, and sums the window again from there
+static void ascent_rebase()
+{
+  ascent_sample base = *ascent_at(0);
+  epoch_cs = (epoch_cs + base.t_cs) % ASCENT_DAY_CS;
+  epoch_alt_cm += base.alt_cm;
+  sum_t = sum_alt = sum_tt = sum_talt = 0;
+  for (uint8_t i = 0; i < stats.window; i++)
+  {
+    ascent_sample *s = ascent_at(i);
+    s->t_cs -= base.t_cs;
+    s->alt_cm -= base.alt_cm;
+    ascent_sum(s, 1);
+  }
+}
+
+// A fix as time and altitude from the epoch, with the time carried across midnight
+static ascent_sample ascent_relative(int32_t time_cs, int32_t altitude_cm)
+{
+  ascent_sample sample;
+  sample.t_cs = time_cs - epoch_cs;
+  if (sample.t_cs < -ASCENT_DAY_CS / 2)
+  {
+    sample.t_cs += ASCENT_DAY_CS;
+  }
+  sample.alt_cm = altitude_cm - epoch_alt_cm;
+  return sample;
+}
+
+// Puts a fix in the window, dropping the oldest to make room and any too old for it, and works out
+// the slope again. The last fix is always kept, so fixes further apart than the window give the slope
+// between the two.
+static void ascent_push(int32_t time_cs, int32_t altitude_cm)
+{
+  if (stats.window == 0)
+  {
+    ascent_restart(time_cs, altitude_cm);
+  }
+  ascent_sample sample = ascent_relative(time_cs, altitude_cm);
+  while (stats.window == ASCENT_WINDOW || (stats.window > 1 && sample.t_cs - ascent_at(0)->t_cs > ASCENT_SPAN_CS))
+  {
+    ascent_sum(ascent_at(0), -1);
+    oldest = (oldest + 1) % ASCENT_WINDOW;
+    stats.window--;
+  }
+  *ascent_at(stats.window) = sample;
+  stats.window++;
+  stats.fixes++;
+  ascent_sum(&sample, 1);
+  if (sample.t_cs > ASCENT_REBASE_CS)
+  {
+    ascent_rebase();
+  }
+
+  // The slope, in cm per centisecond, times 100
+  const ascent_sample *newest = ascent_at(stats.window - 1);
+  stats.valid = stats.window >= ASCENT_MIN_FIXES && newest->t_cs - ascent_at(0)->t_cs >= ASCENT_MIN_SPAN_CS;
+  if (stats.valid)
+  {
+    int64_t n = stats.window;
+    int64_t rate = (n * sum_talt - sum_t * sum_alt) * 100 / (n * sum_tt - sum_t * sum_t);
+    rate_cms = rate > INT16_MAX ? INT16_MAX : rate < INT16_MIN ? INT16_MIN : rate;
+  }
+}
+
+// A new GGA fix. The time is the GPS time of the fix, so the rate does not depend on when it was read.
+void ascent_add(uint8_t hour, uint8_t minute, uint8_t second, uint8_t centisecond, int32_t altitude_cm)
+{
+  int32_t time_cs = ((hour * 60L + minute) * 60 + second) * 100 + centisecond;
+  if (stats.window > 0)
+  {
+    ascent_sample sample = ascent_relative(time_cs, altitude_cm);
+    const ascent_sample *newest = ascent_at(stats.window - 1);
+    int32_t dt_cs = sample.t_cs - newest->t_cs;
+    if (dt_cs <= 0 && dt_cs >= -ASCENT_GAP_CS)
+    {
+      return; // The same fix again
+    }
+    if (dt_cs > ASCENT_GAP_CS || dt_cs < 0)
+    {
+      stats.restarts++;
+      ascent_restart(time_cs, altitude_cm);
+    }
+    else if (stats.valid)
+    {
+      int32_t expected = newest->alt_cm + (int32_t)rate_cms * dt_cs / 100;
+      int32_t gate = ASCENT_GATE_CM + ASCENT_GATE_CMS * dt_cs / 100;
+      int32_t miss = sample.alt_cm - expected;
+      if (miss > gate || miss < -gate)
+      {
+        stats.rejected++;
+        rejected[rejects].t_cs = time_cs;
+        rejected[rejects].alt_cm = altitude_cm;
+        if (++rejects < ASCENT_MAX_REJECTS)
+        {
+          return;
+        }
+
+        // The fixes left out agree with each other, not with the window, so they start it again
+        stats.restarts++;
+        ascent_restart(rejected[0].t_cs, rejected[0].alt_cm);
+        for (uint8_t i = 0; i + 1 < ASCENT_MAX_REJECTS; i++)
+        {
+          ascent_push(rejected[i].t_cs, rejected[i].alt_cm);
+        }
+      }
+    }
+  }
+  rejects = 0;
+  ascent_push(time_cs, altitude_cm);
+}
+
+// cm/s, 0 until the first fixes span ASCENT_MIN_SPAN_CS, and the last rate after that
+int16_t ascent_cms()
+{
+  return rate_cms;
+}
+
+const ascent_stats *ascent_get_stats()
+{
+  return &stats;
+}
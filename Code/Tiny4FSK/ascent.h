@@ -0,0 +1,64 @@
+/*
+ascent.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// ASCENT RATE
+// The ascent rate is the least-squares slope of altitude against GPS time over the last ASCENT_WINDOW
+// fixes, no more than ASCENT_SPAN_CS apart. The sums the slope needs are kept as each fix comes in and
+// goes out of the window, in 64-bit integers (centiseconds and centimetres from the window's epoch), so
+// an update costs the same however long the window, and nothing is rounded away or drifts. The epoch is
+// moved up to the oldest fix every ASCENT_REBASE_CS, which keeps the sums far from overflowing.
+// A fix further from the line than ASCENT_GATE_CM, plus ASCENT_GATE_CMS for each second since the last
+// fix, is taken as a GPS glitch and left out. ASCENT_MAX_REJECTS of those in a row is a real change of
+// rate (a burst), and the window starts again from the fixes left out. After a gap of ASCENT_GAP_CS it
+// starts again from the next fix.
+// No hardware is touched here, so the same code runs in Tools/bench_ascent.
+#pragma once
+
+#include <stdint.h>
+
+// Fixes in the window, and the longest time they can span
+#define ASCENT_WINDOW 16
+#define ASCENT_SPAN_CS 3000
+
+// Fewest fixes, and shortest span, that give a rate
+#define ASCENT_MIN_FIXES 2
+#define ASCENT_MIN_SPAN_CS 200
+
+// A longer gap between fixes starts the window again
+#define ASCENT_GAP_CS 30000
+
+// Outlier gate
+#define ASCENT_GATE_CM 5000
+#define ASCENT_GATE_CMS 3000
+#define ASCENT_MAX_REJECTS 3
+
+#define ASCENT_REBASE_CS 360000L
+
+struct ascent_stats
+{
+  uint32_t fixes;    // Taken into the window
+  uint32_t rejected; // Left out by the gate
+  uint32_t restarts; // After a gap, or a change of rate
+  uint8_t window;    // Fixes in the window now
+  bool valid;        // The window spans enough to give a rate
+};
+
+void ascent_begin();
+void ascent_add(uint8_t hour, uint8_t minute, uint8_t second, uint8_t centisecond, int32_t altitude_cm);
+int16_t ascent_cms();
+const ascent_stats *ascent_get_stats();
@@ -0,0 +1,110 @@
+/*
+backfill.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "backfill.h"
+
+#ifdef BACKFILL
+#include <string.h>
+#include "crc_calc.h"
+
+static_assert(BACKFILL_EVERY >= 1, "BACKFILL_EVERY counts live packets between stored ones");
+static_assert(BACKFILL_FRAMES <= 255, "The ring is counted in bytes");
+
+struct backfill_frame
+{
+  uint32_t stored_ms;
+  uint8_t length;
+  char coded[BACKFILL_FRAME_BYTES];
+};
+
+static backfill_frame ring[BACKFILL_FRAMES];
+static uint8_t oldest = 0;
+static uint8_t live_count = 0; // Live packets since one was stored
+static uint8_t since_sent = 0; // Live packets since one was sent again
+static backfill_stats stats;
+
+void backfill_begin()
+{
+  memset(&stats, 0, sizeof(stats));
+  oldest = 0;
+  live_count = 0;
+  since_sent = 0;
+}
+
+// Call with every live packet as built, before it is sent
+void backfill_store(const char *packet, int length, uint32_t now_ms)
+{
+  if (since_sent < BACKFILL_EVERY)
+  {
+    since_sent++;
+  }
+  if (++live_count < BACKFILL_EVERY || length != (int)sizeof(HorusBinaryPacketV2))
+  {
+    return;
+  }
+  live_count = 0;
+
+  // A full ring loses its oldest
+  if (stats.pending == BACKFILL_FRAMES)
+  {
+    oldest = (oldest + 1) % BACKFILL_FRAMES;
+    stats.pending--;
+    stats.dropped++;
+  }
+  backfill_frame *frame = &ring[(oldest + stats.pending) % BACKFILL_FRAMES];
+
+  // The copy says what it is, so it needs its own CRC, and its own encoding
+  HorusBinaryPacketV2 copy;
+  memcpy(&copy, packet, sizeof(copy));
+  copy.dummy2 |= PACKET_FLAG_BACKFILL;
+  copy.Checksum = (uint16_t)crc16((unsigned char *)&copy, sizeof(copy) - 2);
+  frame->length = horus_l2_encode_tx_packet((unsigned char *)frame->coded, (unsigned char *)&copy, sizeof(copy));
+  frame->stored_ms = now_ms;
+  stats.pending++;
+  stats.stored++;
+}
+
+// True if the next slot should carry a kept packet instead of a live one
+bool backfill_due(uint32_t now_ms)
+{
+  if (stats.pending == 0 || since_sent < BACKFILL_EVERY)
+  {
+    return false;
+  }
+  return stats.pending == BACKFILL_FRAMES || now_ms - ring[oldest].stored_ms >= BACKFILL_DELAY_MS;
+}
+
+// The oldest kept packet, encoded, and its length. It stays where it is until the next
+// backfill_store(), so it can be sent straight from the ring.
+int backfill_take(char **frame)
+{
+  backfill_frame *f = &ring[oldest];
+  oldest = (oldest + 1) % BACKFILL_FRAMES;
+  stats.pending--;
+  stats.sent++;
+  since_sent = 0;
+  *frame = f->coded;
+  return f->length;
+}
+
+const backfill_stats *backfill_get_stats()
+{
+  return &stats;
+}
+
+#endif
@@ -0,0 +1,59 @@
+/*
+backfill.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// STORE AND FORWARD
+// One of every BACKFILL_EVERY packets is kept in a ring of BACKFILL_FRAMES, and sent again later in a
+// slot of its own, so a receiver that lost it behind terrain or in an antenna null gets a second
+// chance. The copy is kept encoded, with PACKET_FLAG_BACKFILL set and its CRC redone, so the only
+// work left when it goes out is the transmission. It keeps its counter and GPS time, so receivers
+// put it in its place in the track.
+// After every BACKFILL_EVERY live packets, the oldest kept packet goes out instead of a live one,
+// once it is BACKFILL_DELAY_MS old (long enough for whatever hid the tracker to have passed), or
+// straight away if the ring is full. Each one is sent again once.
+// Without BACKFILL in config.h, every slot carries a live packet.
+// No hardware is touched here, so the same code runs in Tools/replay.
+#pragma once
+
+#include <stdint.h>
+#include "config.h"
+#include "packet.h"
+#include "horus_l2.h"
+
+#define BACKFILL_FRAMES 24
+#define BACKFILL_FRAME_BYTES HORUS_L2_TX_BYTES(sizeof(HorusBinaryPacketV2))
+
+struct backfill_stats
+{
+  uint32_t stored;  // Packets kept
+  uint32_t sent;    // Sent again
+  uint32_t dropped; // Pushed out of a full ring before they were sent
+  uint8_t pending;  // In the ring now
+};
+
+#ifdef BACKFILL
+void backfill_begin();
+void backfill_store(const char *packet, int length, uint32_t now_ms);
+bool backfill_due(uint32_t now_ms);
+int backfill_take(char **frame);
+const backfill_stats *backfill_get_stats();
+#else
+inline void backfill_begin() {}
+inline void backfill_store(const char *packet, int length, uint32_t now_ms) {}
+inline bool backfill_due(uint32_t now_ms) { return false; }
+inline int backfill_take(char **frame) { return 0; }
+#endif
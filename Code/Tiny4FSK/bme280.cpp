@@ -0,0 +1,232 @@
+/*
+bme280.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "bme280.h"
+
+#define BME280_REG_CALIB_TP 0x88 // 26 bytes, dig_T1 to dig_H1
+#define BME280_REG_CHIP_ID 0xD0
+#define BME280_REG_CALIB_H 0xE1  // 7 bytes, dig_H2 to dig_H6
+#define BME280_REG_CTRL_HUM 0xF2
+#define BME280_REG_CTRL_MEAS 0xF4
+#define BME280_REG_CONFIG 0xF5
+#define BME280_REG_DATA 0xF7     // 8 bytes, pressure, temperature, humidity
+
+#define BME280_CHIP_ID 0x60
+#define BME280_OSRS_1X 1
+#define BME280_MODE_FORCED 1
+#define BME280_CTRL_MEAS_FORCED ((BME280_OSRS_1X << 5) | (BME280_OSRS_1X << 2) | BME280_MODE_FORCED)
+
+// Factory calibration, from the datasheet section 4.2.2
+static uint16_t dig_T1;
+static int16_t dig_T2, dig_T3;
+static uint16_t dig_P1;
+static int16_t dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7, dig_P8, dig_P9;
+static uint8_t dig_H1, dig_H3;
+static int16_t dig_H2, dig_H4, dig_H5;
+static int8_t dig_H6;
+
+enum bme280_state
+{
+  BME280_IDLE,
+  BME280_MEASURING,
+  BME280_READING
+};
+
+static uint8_t bme_address = 0;
+static bme280_state state = BME280_IDLE;
+static uint32_t started_ms = 0;
+static uint8_t raw[8];
+static bme280_data data;
+static bme280_stats stats;
+
+static bool bme280_write_register(uint8_t reg, uint8_t value)
+{
+  const uint8_t command[] = {reg, value};
+  return i2c_dma_write(bme_address, command, sizeof(command), NULL, 0);
+}
+
+// Blocking register read, only used during setup
+static bool bme280_read_registers(uint8_t reg, uint8_t *buffer, uint8_t length)
+{
+  bool ok = false;
+  i2c_dma_read_register(bme_address, reg, buffer, length, [](bool result, void *context)
+                        { *(bool *)context = result; }, &ok);
+  i2c_dma_flush();
+  return ok;
+}
+
+// Bosch's 32-bit integer compensation. Temperature comes first, as the other two need t_fine.
+static void bme280_compensate()
+{
+  int32_t adc_P = ((uint32_t)raw[0] << 12) | ((uint32_t)raw[1] << 4) | (raw[2] >> 4);
+  int32_t adc_T = ((uint32_t)raw[3] << 12) | ((uint32_t)raw[4] << 4) | (raw[5] >> 4);
+  int32_t adc_H = ((uint32_t)raw[6] << 8) | raw[7];
+
+  int32_t var1 = ((((adc_T >> 3) - ((int32_t)dig_T1 << 1))) * ((int32_t)dig_T2)) >> 11;
+  int32_t var2 = (((((adc_T >> 4) - ((int32_t)dig_T1)) * ((adc_T >> 4) - ((int32_t)dig_T1))) >> 12) * ((int32_t)dig_T3)) >> 14;
+  int32_t t_fine = var1 + var2;
+  data.temperature = (t_fine * 5 + 128) >> 8;
+
+  var1 = (t_fine >> 1) - 64000;
+  var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * ((int32_t)dig_P6);
+  var2 = var2 + ((var1 * ((int32_t)dig_P5)) << 1);
+  var2 = (var2 >> 2) + (((int32_t)dig_P4) << 16);
+  var1 = (((dig_P3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) + ((((int32_t)dig_P2) * var1) >> 1)) >> 18;
+  var1 = ((32768 + var1) * ((int32_t)dig_P1)) >> 15;
+  if (var1 == 0)
+  {
+    data.pressure = 0;
+  }
+  else
+  {
+    uint32_t p = (((uint32_t)(1048576 - adc_P)) - (var2 >> 12)) * 3125;
+    if (p < 0x80000000)
+    {
+      p = (p << 1) / ((uint32_t)var1);
+    }
+    else
+    {
+      p = (p / (uint32_t)var1) * 2;
+    }
+    var1 = (((int32_t)dig_P9) * ((int32_t)(((p >> 3) * (p >> 3)) >> 13))) >> 12;
+    var2 = (((int32_t)(p >> 2)) * ((int32_t)dig_P8)) >> 13;
+    data.pressure = (uint32_t)((int32_t)p + ((var1 + var2 + dig_P7) >> 4));
+  }
+
+  int32_t h = t_fine - 76800;
+  h = (((((adc_H << 14) - (((int32_t)dig_H4) << 20) - (((int32_t)dig_H5) * h)) + 16384) >> 15) *
+       (((((((h * ((int32_t)dig_H6)) >> 10) * (((h * ((int32_t)dig_H3)) >> 11) + 32768)) >> 10) + 2097152) *
+             ((int32_t)dig_H2) +
+         8192) >>
+        14));
+  h = h - (((((h >> 15) * (h >> 15)) >> 7) * ((int32_t)dig_H1)) >> 4);
+  h = h < 0 ? 0 : h;
+  h = h > 419430400 ? 419430400 : h;
+  data.humidity = ((uint32_t)(h >> 12) * 25) >> 8; // %RH * 1024 to %RH * 100
+}
+
+static void bme280_read_done(bool ok, void *context)
+{
+  state = BME280_IDLE;
+
+  // 0x80000 in the temperature means the conversion was skipped
+  if (!ok || (raw[3] == 0x80 && raw[4] == 0 && raw[5] == 0))
+  {
+    stats.errors++;
+    return;
+  }
+  bme280_compensate();
+  data.time_ms = millis();
+  data.valid = true;
+  stats.readings++;
+}
+
+bool bme280_begin(uint8_t address)
+{
+  uint8_t calib[26];
+  uint8_t id = 0;
+
+  bme_address = address;
+  state = BME280_IDLE;
+  data.valid = false;
+  if (!bme280_read_registers(BME280_REG_CHIP_ID, &id, 1) || id != BME280_CHIP_ID)
+  {
+    bme_address = 0;
+    return false;
+  }
+
+  if (!bme280_read_registers(BME280_REG_CALIB_TP, calib, 26))
+  {
+    bme_address = 0;
+    return false;
+  }
+  dig_T1 = calib[0] | (calib[1] << 8);
+  dig_T2 = calib[2] | (calib[3] << 8);
+  dig_T3 = calib[4] | (calib[5] << 8);
+  dig_P1 = calib[6] | (calib[7] << 8);
+  dig_P2 = calib[8] | (calib[9] << 8);
+  dig_P3 = calib[10] | (calib[11] << 8);
+  dig_P4 = calib[12] | (calib[13] << 8);
+  dig_P5 = calib[14] | (calib[15] << 8);
+  dig_P6 = calib[16] | (calib[17] << 8);
+  dig_P7 = calib[18] | (calib[19] << 8);
+  dig_P8 = calib[20] | (calib[21] << 8);
+  dig_P9 = calib[22] | (calib[23] << 8);
+  dig_H1 = calib[25];
+
+  if (!bme280_read_registers(BME280_REG_CALIB_H, calib, 7))
+  {
+    bme_address = 0;
+    return false;
+  }
+  dig_H2 = calib[0] | (calib[1] << 8);
+  dig_H3 = calib[2];
+  dig_H4 = ((int8_t)calib[3] * 16) | (calib[4] & 0x0F);
+  dig_H5 = ((int8_t)calib[5] * 16) | (calib[4] >> 4);
+  dig_H6 = calib[6];
+
+  // 1x oversampling everywhere, no IIR filter, and stay asleep until asked
+  bme280_write_register(BME280_REG_CTRL_HUM, BME280_OSRS_1X);
+  bme280_write_register(BME280_REG_CONFIG, 0x00);
+  bme280_write_register(BME280_REG_CTRL_MEAS, 0x00);
+  i2c_dma_flush();
+  return true;
+}
+
+// Start one conversion. The sensor goes back to sleep by itself afterwards.
+void bme280_start()
+{
+  if (!bme_address || state != BME280_IDLE)
+  {
+    return;
+  }
+  bme280_write_register(BME280_REG_CTRL_MEAS, BME280_CTRL_MEAS_FORCED);
+  started_ms = millis();
+  state = BME280_MEASURING;
+}
+
+// Fetch the conversion once it is done. Called from the gpsFeed task.
+void bme280_service()
+{
+  if (state == BME280_MEASURING && millis() - started_ms >= BME280_MEASURE_MS)
+  {
+    state = BME280_READING;
+    i2c_dma_read_register(bme_address, BME280_REG_DATA, raw, sizeof(raw), bme280_read_done, NULL);
+  }
+}
+
+// Wait for a conversion started with bme280_start() to be read out
+void bme280_wait()
+{
+  while (state != BME280_IDLE)
+  {
+    bme280_service();
+    i2c_dma_service();
+    yield();
+  }
+}
+
+const bme280_data *bme280_get()
+{
+  return &data;
+}
+
+const bme280_stats *bme280_get_stats()
+{
+  return &stats;
+}
@@ -0,0 +1,52 @@
+/*
+bme280.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// BME280 DRIVER
+// Runs the BME280 in forced mode: bme280_start() asks for one conversion of temperature, pressure
+// and humidity, and 10 ms later all three are fetched in a single 8-byte burst read (0xF7-0xFE).
+// The Bosch integer compensation runs once per reading, sharing t_fine, and the result is kept as
+// a snapshot until the next one. All I2C traffic goes through the i2c_dma queue.
+#pragma once
+
+#include <Arduino.h>
+#include "i2c_dma.h"
+
+// Longest conversion time with 1x oversampling on all three channels is 9.3 ms
+#define BME280_MEASURE_MS 10
+
+struct bme280_data
+{
+  int32_t temperature; // Hundredths of a degree C
+  uint32_t pressure;   // Pa
+  uint32_t humidity;   // Hundredths of a percent
+  uint32_t time_ms;    // millis() when it was read
+  bool valid;          // False until the first good reading
+};
+
+struct bme280_stats
+{
+  uint32_t readings; // Good readings
+  uint32_t errors;   // Failed I2C transfers or skipped conversions
+};
+
+bool bme280_begin(uint8_t address);
+void bme280_start();
+void bme280_service();
+void bme280_wait();
+const bme280_data *bme280_get();
+const bme280_stats *bme280_get_stats();
@@ -0,0 +1,268 @@
+/*
+cadence.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "cadence.h"
+#include "power.h"
+#include "clock.h"
+
+#define SECONDS_PER_DAY 86400UL
+
+typedef enum _slot_source
+{
+  SLOT_SOURCE_FREE = 0,
+  SLOT_SOURCE_NMEA,
+  SLOT_SOURCE_PPS,
+} slot_source;
+
+// Time pulse edges, written by the interrupt
+static volatile uint32_t pps_count = 0;
+static volatile uint32_t pps_edge_ms = 0;
+static volatile uint32_t pps_edge_us = 0;
+
+// GPS time reference: the local time (ref_ms) at which GPS second ref_sec started
+static bool ref_valid = false;
+static bool ref_from_pps = false;
+static uint32_t ref_ms = 0;
+static uint32_t ref_sec = 0;
+
+// Current slot
+static uint32_t target_ms = 0;
+static uint32_t last_start_ms = 0;
+static bool started = false;
+static slot_source source = SLOT_SOURCE_FREE;
+static bool edge_found = false;
+static uint32_t edge_us = 0;
+static uint8_t period_slots = 1; // Slots from one packet to the next
+
+static cadence_stats stats = {0, 0, 0, 0, 0, INT32_MAX, INT32_MIN};
+
+static void cadence_pps_isr()
+{
+  pps_edge_us = clock_micros();
+  pps_edge_ms = cadence_millis();
+  pps_count++;
+}
+
+void cadence_begin()
+{
+  pinMode(GPS_PPS_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(GPS_PPS_PIN), cadence_pps_isr, RISING);
+}
+
+// Local clock, on the crystal and including the time spent asleep
+uint32_t cadence_millis()
+{
+  return clock_millis();
+}
+
+// Feed in the latest NMEA time. Call whenever TinyGPSPlus reports an updated time.
+void cadence_update_time(uint8_t hour, uint8_t minute, uint8_t second, uint8_t centisecond, uint32_t age_ms)
+{
+  uint32_t seen_ms = cadence_millis() - age_ms;
+  uint32_t count, edge_ms;
+
+  noInterrupts();
+  count = pps_count;
+  edge_ms = pps_edge_ms;
+  interrupts();
+
+  ref_sec = (uint32_t)hour * 3600 + (uint32_t)minute * 60 + second;
+
+  // The NMEA sentence for a second follows the time pulse that started it
+  if (count > 0 && seen_ms - edge_ms < 1000)
+  {
+    ref_ms = edge_ms;
+    ref_from_pps = true;
+  }
+  else
+  {
+    ref_ms = seen_ms - CADENCE_NMEA_LATENCY - (uint32_t)centisecond * 10;
+    ref_from_pps = false;
+  }
+  ref_valid = true;
+}
+
+// Work out the local time of the next slot
+static uint32_t cadence_next_slot(uint32_t now)
+{
+  // Skipped slots: look from halfway between the last one skipped and the one wanted
+  uint32_t from = now;
+  if (started && period_slots > 1)
+  {
+    uint32_t skipped = last_start_ms + (period_slots - 1) * CADENCE_PERIOD_MS + CADENCE_PERIOD_MS / 2;
+    if ((int32_t)(skipped - now) > 0)
+    {
+      from = skipped;
+    }
+  }
+
+  if (ref_valid && now - ref_ms < CADENCE_HOLDOVER)
+  {
+    // First whole GPS second in the future, then round up to our slot
+    uint32_t sec = ref_sec + (from - ref_ms) / 1000 + 1;
+    sec += (TX_SLOT_OFFSET + TX_SLOT_PERIOD - (sec % SECONDS_PER_DAY) % TX_SLOT_PERIOD) % TX_SLOT_PERIOD;
+    source = ref_from_pps ? SLOT_SOURCE_PPS : SLOT_SOURCE_NMEA;
+    return ref_ms + (sec - ref_sec) * 1000;
+  }
+
+  // No GPS time yet. Keep the period on the local clock instead.
+  source = SLOT_SOURCE_FREE;
+  if (started && (int32_t)(last_start_ms + period_slots * CADENCE_PERIOD_MS - now) > 0)
+  {
+    return last_start_ms + period_slots * CADENCE_PERIOD_MS;
+  }
+  return now;
+}
+
+// Local time the next slot starts, for planning ahead
+uint32_t cadence_next_slot_ms()
+{
+  return cadence_next_slot(cadence_millis());
+}
+
+// Local time the packet for the next slot is built, one period ahead of it
+uint32_t cadence_next_build_ms()
+{
+  return cadence_next_slot_ms() - CADENCE_PERIOD_MS;
+}
+
+// Use only every slots-th slot from the last packet on. Call between packets.
+void cadence_set_slots(uint8_t slots)
+{
+  period_slots = slots > 0 ? slots : 1;
+}
+
+// Sleep through the slots being skipped, if any, and wake with time to take in a new fix before the build
+void cadence_wait_for_build()
+{
+  uint32_t now = cadence_millis();
+  uint32_t build_ms = cadence_next_build_ms();
+  int32_t remaining = (int32_t)(build_ms - now);
+  if (remaining <= 0)
+  {
+    return;
+  }
+#ifndef DEV_MODE
+  if (remaining > CADENCE_BUILD_MARGIN)
+  {
+    power_deep_sleep(remaining - CADENCE_BUILD_MARGIN);
+  }
+#endif
+  while ((int32_t)(cadence_millis() - build_ms) < 0)
+  {
+    yield();
+  }
+}
+
+// Block (while yielding to other tasks) until the next slot starts
+void cadence_wait_for_slot()
+{
+  uint32_t now = cadence_millis();
+  target_ms = cadence_next_slot(now);
+  edge_found = false;
+
+#ifndef DEV_MODE
+  // Sleep through most of the wait, and wake up a bit early to catch the edge
+  int32_t remaining = (int32_t)(target_ms - now);
+  if (remaining > CADENCE_WAKE_MARGIN)
+  {
+    power_deep_sleep(remaining - CADENCE_WAKE_MARGIN);
+  }
+#endif
+  // Radio and CPU back up within the wake margin, with the low power profile
+  power_wake();
+
+  uint32_t count = pps_count;
+  while (true)
+  {
+    now = cadence_millis();
+    if (source == SLOT_SOURCE_PPS)
+    {
+      // Start on the time pulse edge that begins the slot
+      if (pps_count != count)
+      {
+        uint32_t edge_ms;
+        noInterrupts();
+        count = pps_count;
+        edge_ms = pps_edge_ms;
+        edge_us = pps_edge_us;
+        interrupts();
+
+        if (edge_ms - (target_ms - 500) < 1000)
+        {
+          edge_found = true;
+          break;
+        }
+      }
+      if ((int32_t)(now - target_ms) > CADENCE_PPS_TIMEOUT)
+      {
+        break;
+      }
+    }
+    else if ((int32_t)(now - target_ms) >= 0)
+    {
+      break;
+    }
+    yield();
+  }
+}
+
+// Call right as the transmitter is keyed, to measure how well the slot was hit
+void cadence_mark_tx_start()
+{
+  uint32_t now_us = clock_micros();
+  uint32_t now = cadence_millis();
+  int32_t error_us;
+
+  if (edge_found)
+  {
+    error_us = (int32_t)(now_us - edge_us);
+    stats.pps_slots++;
+  }
+  else
+  {
+    error_us = (int32_t)(now - target_ms) * 1000;
+    if (source == SLOT_SOURCE_FREE)
+    {
+      stats.free_slots++;
+    }
+    else
+    {
+      stats.nmea_slots++;
+    }
+  }
+
+  stats.slots++;
+  stats.last_error_us = error_us;
+  if (error_us < stats.min_error_us)
+  {
+    stats.min_error_us = error_us;
+  }
+  if (error_us > stats.max_error_us)
+  {
+    stats.max_error_us = error_us;
+  }
+
+  last_start_ms = now;
+  started = true;
+}
+
+const cadence_stats *cadence_get_stats()
+{
+  return &stats;
+}
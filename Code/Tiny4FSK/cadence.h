@@ -0,0 +1,74 @@
+/*
+cadence.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// PACKET CADENCE CONTROLLER
+// Locks the start of each packet to the GPS second, so packets leave on a fixed period
+// no matter how long the transmit or the packet build took. Slots are defined in GPS time:
+// a slot starts on every second where (seconds of day) % TX_SLOT_PERIOD == TX_SLOT_OFFSET.
+// The GPS time pulse on GPS_PPS_PIN gives the exact second edge; without it the NMEA time is used.
+// Between slots the local clock is the 32.768 kHz crystal (clock_millis()), whatever speed the CPU runs at.
+// cadence_set_slots() makes each packet skip the slots before its next one (ADAPTIVE_RATE, see rate.h).
+// The packet is then built one period ahead of its slot, as with every slot used, after a sleep through
+// the skipped ones.
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+// Packet period in milliseconds, start to start
+#define CADENCE_PERIOD_MS ((uint32_t)TX_SLOT_PERIOD * 1000UL)
+
+// Wake up this long before the slot to give the GPS time pulse a chance to be caught
+#define CADENCE_WAKE_MARGIN 300
+
+// Give up waiting for a time pulse this long after the slot was expected
+#define CADENCE_PPS_TIMEOUT 200
+
+// The time pulse is considered lost if no edge has been seen for this long
+#define CADENCE_PPS_LOST 1500
+
+// Keep using the last GPS time reference for this long without a new one (local clock holdover)
+#define CADENCE_HOLDOVER 3600000UL
+
+// Typical delay between the start of a GPS second and the NMEA sentence describing it
+#define CADENCE_NMEA_LATENCY 100
+
+// When slots are skipped, wake this long before the packet is built, so a fresh fix comes in first
+#define CADENCE_BUILD_MARGIN 1200
+
+struct cadence_stats
+{
+  uint32_t slots;       // Slots used so far
+  uint32_t pps_slots;   // Slots started on a GPS time pulse edge
+  uint32_t nmea_slots;  // Slots timed from NMEA time only
+  uint32_t free_slots;  // Slots timed from the local clock only (no GPS time yet)
+  int32_t last_error_us; // Error of the last slot start against the expected edge
+  int32_t min_error_us;
+  int32_t max_error_us;
+};
+
+void cadence_begin();
+void cadence_update_time(uint8_t hour, uint8_t minute, uint8_t second, uint8_t centisecond, uint32_t age_ms);
+uint32_t cadence_millis();
+uint32_t cadence_next_slot_ms();
+uint32_t cadence_next_build_ms();
+void cadence_set_slots(uint8_t slots);
+void cadence_wait_for_build();
+void cadence_wait_for_slot();
+void cadence_mark_tx_start();
+const cadence_stats *cadence_get_stats();
@@ -0,0 +1,394 @@
+/*
+clock.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "clock.h"
+#include "energy.h"
+#include "i2c_dma.h"
+#include "fixed_format.h"
+
+#define CLOCK_MEASURE_TICKS (CLOCK_MEASURE_MS * CLOCK_TICKS_PER_SECOND / 1000)
+
+static const char *const speed_names[CLOCK_SPEEDS] = {"fast", "slow"};
+
+static clock_speed current = CLOCK_FAST;
+static clock_stats stats;
+
+// clock_millis() state
+static uint32_t last_ticks = 0;
+static uint32_t wraps = 0;
+
+// The stretch of time at the current speed, for measuring millis() against the crystal
+static uint32_t stretch_ticks = 0;
+static uint32_t stretch_us = 0;
+static uint32_t stretch_slept = 0;
+static uint32_t stretch_hz = CLOCK_FAST_HZ; // Frequency SysTick was set for
+
+static uint32_t clock_lock()
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  return primask;
+}
+
+static void clock_unlock(uint32_t primask)
+{
+  __set_PRIMASK(primask);
+}
+
+uint32_t clock_ticks()
+{
+  // Continuous read synchronization is on, so this does not wait for the 32 kHz clock domain
+  return TC4->COUNT32.COUNT.reg;
+}
+
+// Milliseconds on the crystal since clock_begin(), deep sleep included. Safe in interrupts.
+uint32_t clock_millis()
+{
+  uint32_t primask = clock_lock();
+  uint32_t ticks = clock_ticks();
+  if (ticks < last_ticks)
+  {
+    wraps++;
+  }
+  last_ticks = ticks;
+  uint64_t all = ((uint64_t)wraps << 32) | ticks;
+  clock_unlock(primask);
+  return all * 1000 / CLOCK_TICKS_PER_SECOND;
+}
+
+// Takes millis() and the SysTick count as one consistent pair. A reload that is pending but not yet
+// serviced counts as a whole millisecond.
+static uint32_t clock_systick(uint32_t *count)
+{
+  uint32_t ms, pending, value;
+  uint32_t ms2 = millis();
+  uint32_t pending2 = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+  uint32_t value2 = SysTick->VAL;
+  do
+  {
+    ms = ms2;
+    pending = pending2;
+    value = value2;
+    ms2 = millis();
+    pending2 = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+    value2 = SysTick->VAL;
+  } while (ms != ms2 || pending != pending2 || value < value2);
+
+  *count = value;
+  return ms + pending;
+}
+
+// Like micros(), but the core's version assumes SysTick runs at 48 MHz. This one takes the fraction of
+// the millisecond from the reload value, so it is right at either speed. Stops in deep sleep.
+uint32_t clock_micros()
+{
+  uint32_t count;
+  uint32_t ms = clock_systick(&count);
+  uint32_t load = SysTick->LOAD;
+  return ms * 1000 + (load - count) * 1000 / (load + 1);
+}
+
+// CPU cycles, from the same SysTick pair. Wraps about every 89 s at 48 MHz, so only short differences
+// mean anything, and only when the speed did not change in between.
+uint32_t clock_cycles()
+{
+  uint32_t count;
+  uint32_t ms = clock_systick(&count);
+  uint32_t load = SysTick->LOAD;
+  return ms * (load + 1) + (load - count);
+}
+
+// Deep sleep stops SysTick but not the crystal, so sleeps are left out of the measurement
+void clock_add_sleep(uint32_t ticks)
+{
+  stretch_slept += ticks;
+}
+
+static void clock_stretch_start()
+{
+  stretch_ticks = clock_ticks();
+  stretch_us = clock_micros();
+  stretch_slept = 0;
+}
+
+#if defined(CLOCK_SCALING) && !defined(DEV_MODE)
+static uint32_t slow_hz = CLOCK_SLOW_HZ; // OSC8M, as last measured
+static uint32_t dfll_ctrl;               // DFLLCTRL as the core set it up, closed loop on the crystal
+#endif
+
+// Compares the time millis() counted against the crystal over the stretch that just ended. At the
+// slow speed, that also gives the actual frequency of OSC8M for the next switch.
+static void clock_stretch_end()
+{
+  uint32_t ticks = clock_ticks() - stretch_ticks - stretch_slept;
+  uint32_t counted_us = clock_micros() - stretch_us;
+  clock_speed_stats *s = &stats.speed[current];
+  s->awake_ms += (uint64_t)ticks * 1000 / CLOCK_TICKS_PER_SECOND;
+  if (ticks < CLOCK_MEASURE_TICKS)
+  {
+    return;
+  }
+  uint64_t real_us = (uint64_t)ticks * 1000000 / CLOCK_TICKS_PER_SECOND;
+  s->error_ppm = ((int64_t)counted_us - (int64_t)real_us) * 1000000 / (int64_t)real_us;
+#if defined(CLOCK_SCALING) && !defined(DEV_MODE)
+  if (current == CLOCK_SLOW)
+  {
+    slow_hz = (uint64_t)stretch_hz * counted_us / real_us;
+  }
+#endif
+}
+
+#if defined(CLOCK_SCALING) && !defined(DEV_MODE)
+// Dividers the libraries set up for 48 MHz, kept for the way back
+static uint16_t fast_uart_baud;
+static uint8_t fast_spi_baud;
+static uint32_t fast_i2c_baud;
+
+// Switches GCLK0 to another source right after a SysTick reload, with the reload value for the new
+// frequency already in, so millis() keeps counting whole milliseconds at either speed. Interrupts
+// are only held off for the last sixteenth of the millisecond.
+static void clock_switch(uint32_t source, uint32_t hz)
+{
+  uint32_t end = SysTick->LOAD / 16;
+  uint32_t primask;
+  while (true)
+  {
+    while (SysTick->VAL > end)
+      ;
+    primask = clock_lock();
+    if (SysTick->VAL <= end)
+    {
+      break;
+    }
+    clock_unlock(primask);
+  }
+
+  uint32_t load = (hz + 500) / 1000;
+  SysTick->LOAD = load - 1;
+  uint32_t last = SysTick->VAL;
+  uint32_t now;
+  while ((now = SysTick->VAL) <= last)
+  {
+    last = now;
+  }
+  GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(0) | source | GCLK_GENCTRL_IDC | GCLK_GENCTRL_GENEN;
+  while (GCLK->STATUS.bit.SYNCBUSY)
+    ;
+  clock_unlock(primask);
+  stretch_hz = load * 1000;
+}
+
+// BAUD is enable-protected in every SERCOM mode, so each one is stopped for the write
+static void clock_uart_baud(uint16_t baud)
+{
+  bool enabled = CLOCK_UART_SERCOM->USART.CTRLA.bit.ENABLE;
+  CLOCK_UART_SERCOM->USART.CTRLA.bit.ENABLE = 0;
+  while (CLOCK_UART_SERCOM->USART.SYNCBUSY.bit.ENABLE)
+    ;
+  CLOCK_UART_SERCOM->USART.BAUD.reg = baud;
+  CLOCK_UART_SERCOM->USART.CTRLA.bit.ENABLE = enabled;
+  while (CLOCK_UART_SERCOM->USART.SYNCBUSY.bit.ENABLE)
+    ;
+}
+
+// The Morse interrupt keys the radio over SPI, so it is held off while the bus is stopped
+static void clock_spi_baud(uint8_t baud)
+{
+  uint32_t primask = clock_lock();
+  bool enabled = CLOCK_SPI_SERCOM->SPI.CTRLA.bit.ENABLE;
+  CLOCK_SPI_SERCOM->SPI.CTRLA.bit.ENABLE = 0;
+  while (CLOCK_SPI_SERCOM->SPI.SYNCBUSY.bit.ENABLE)
+    ;
+  CLOCK_SPI_SERCOM->SPI.BAUD.reg = baud;
+  CLOCK_SPI_SERCOM->SPI.CTRLA.bit.ENABLE = enabled;
+  while (CLOCK_SPI_SERCOM->SPI.SYNCBUSY.bit.ENABLE)
+    ;
+  clock_unlock(primask);
+}
+
+static void clock_i2c_baud(uint32_t baud)
+{
+  bool enabled = I2C_DMA_SERCOM->I2CM.CTRLA.bit.ENABLE;
+  I2C_DMA_SERCOM->I2CM.CTRLA.bit.ENABLE = 0;
+  while (I2C_DMA_SERCOM->I2CM.SYNCBUSY.bit.ENABLE)
+    ;
+  I2C_DMA_SERCOM->I2CM.BAUD.reg = baud;
+  if (enabled)
+  {
+    // The bus state is unknown after a restart, and nothing else is on it
+    I2C_DMA_SERCOM->I2CM.CTRLA.bit.ENABLE = 1;
+    while (I2C_DMA_SERCOM->I2CM.SYNCBUSY.bit.ENABLE)
+      ;
+    I2C_DMA_SERCOM->I2CM.STATUS.bit.BUSSTATE = 1;
+    while (I2C_DMA_SERCOM->I2CM.SYNCBUSY.bit.SYSOP)
+      ;
+  }
+}
+
+// Slow dividers are worked out from the fast ones, so each bus keeps its bit rate. Where that is not
+// possible, the divider is rounded towards the slower rate.
+static void clock_retime_slow()
+{
+  fast_uart_baud = CLOCK_UART_SERCOM->USART.BAUD.reg;
+  fast_spi_baud = CLOCK_SPI_SERCOM->SPI.BAUD.reg;
+  fast_i2c_baud = I2C_DMA_SERCOM->I2CM.BAUD.reg;
+
+  // UART, 16x oversampling: rate = f * (65536 - BAUD) / (16 * 65536)
+  uint32_t uart_step = ((uint64_t)(65536 - fast_uart_baud) * CLOCK_FAST_HZ + slow_hz / 2) / slow_hz;
+  clock_uart_baud(uart_step < 65536 ? 65536 - uart_step : 0);
+
+  // SPI: rate = f / (2 * (BAUD + 1))
+  uint32_t spi_div = ((uint32_t)(fast_spi_baud + 1) * (slow_hz / 1000) + CLOCK_FAST_HZ / 1000 - 1) / (CLOCK_FAST_HZ / 1000);
+  clock_spi_baud(spi_div > 1 ? spi_div - 1 : 0);
+
+  // I2C: the whole SCL period, 10 + 2 * BAUD plus the rise time, is counted in clocks
+  uint32_t i2c_period = ((10 + 2 * (fast_i2c_baud & 0xFF)) * (slow_hz / 1000) + CLOCK_FAST_HZ / 1000 - 1) / (CLOCK_FAST_HZ / 1000);
+  clock_i2c_baud(SERCOM_I2CM_BAUD_BAUD(i2c_period > 10 ? (i2c_period - 9) / 2 : 0));
+}
+
+static void clock_retime_fast()
+{
+  clock_uart_baud(fast_uart_baud);
+  clock_spi_baud(fast_spi_baud);
+  clock_i2c_baud(fast_i2c_baud);
+}
+#endif
+
+void clock_begin()
+{
+  PM->APBCMASK.reg |= PM_APBCMASK_TC4 | PM_APBCMASK_TC5;
+
+  // GCLK1 is the 32.768 kHz crystal. Keep both running in standby, so sleep is counted too.
+  SYSCTRL->XOSC32K.bit.RUNSTDBY = 1;
+  GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(1) | GCLK_GENCTRL_SRC_XOSC32K | GCLK_GENCTRL_GENEN | GCLK_GENCTRL_RUNSTDBY;
+  while (GCLK->STATUS.bit.SYNCBUSY)
+    ;
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_TC4_TC5 | GCLK_CLKCTRL_GEN_GCLK1 | GCLK_CLKCTRL_CLKEN;
+  while (GCLK->STATUS.bit.SYNCBUSY)
+    ;
+
+  // TC4 with TC5 as its upper half, free running from zero
+  TC4->COUNT32.CTRLA.reg = TC_CTRLA_SWRST;
+  while (TC4->COUNT32.CTRLA.bit.SWRST)
+    ;
+  TC4->COUNT32.CTRLA.reg = TC_CTRLA_MODE_COUNT32 | TC_CTRLA_PRESCALER_DIV1 | TC_CTRLA_RUNSTDBY;
+  TC4->COUNT32.READREQ.reg = TC_READREQ_RCONT | TC_READREQ_ADDR(TC_COUNT32_COUNT_OFFSET);
+  TC4->COUNT32.CTRLA.reg |= TC_CTRLA_ENABLE;
+  while (TC4->COUNT32.STATUS.bit.SYNCBUSY)
+    ;
+
+  stats.speed[CLOCK_FAST].hz = CLOCK_FAST_HZ;
+  stats.speed[CLOCK_FAST].current_ua = energy_current_ua(ENERGY_CPU_ACTIVE);
+  stats.speed[CLOCK_SLOW].hz = CLOCK_SLOW_HZ;
+  stats.speed[CLOCK_SLOW].current_ua = energy_current_ua(ENERGY_CPU_SLOW);
+  clock_stretch_start();
+
+#if defined(CLOCK_SCALING) && !defined(DEV_MODE)
+  dfll_ctrl = SYSCTRL->DFLLCTRL.reg;
+
+  // Measure OSC8M once, so the first packet is not paced on its factory trim
+  clock_set(CLOCK_SLOW);
+  uint32_t start = clock_ticks();
+  while (clock_ticks() - start < CLOCK_MEASURE_TICKS)
+    ;
+  clock_set(CLOCK_FAST);
+#endif
+}
+
+// Changes the CPU speed. The I2C queue is finished first, as its bus is stopped for the new divider.
+void clock_set(clock_speed speed)
+{
+#if defined(CLOCK_SCALING) && !defined(DEV_MODE)
+  if (speed == current)
+  {
+    return;
+  }
+  uint32_t start = clock_ticks();
+  clock_stretch_end();
+  i2c_dma_flush();
+
+  if (speed == CLOCK_SLOW)
+  {
+    clock_switch(GCLK_GENCTRL_SRC_OSC8M, slow_hz);
+    NVMCTRL->CTRLB.bit.RWS = 0;
+    while (!SYSCTRL->PCLKSR.bit.DFLLRDY)
+      ;
+    SYSCTRL->DFLLCTRL.reg = dfll_ctrl & ~SYSCTRL_DFLLCTRL_ENABLE;
+    clock_retime_slow();
+    energy_set(ENERGY_CPU_SLOW);
+  }
+  else
+  {
+    // The DFLL keeps its last tuning while stopped, so it locks again quickly
+    while (!SYSCTRL->PCLKSR.bit.DFLLRDY)
+      ;
+    SYSCTRL->DFLLCTRL.reg = dfll_ctrl;
+    while ((SYSCTRL->PCLKSR.reg & (SYSCTRL_PCLKSR_DFLLLCKC | SYSCTRL_PCLKSR_DFLLLCKF)) !=
+           (SYSCTRL_PCLKSR_DFLLLCKC | SYSCTRL_PCLKSR_DFLLLCKF))
+      ;
+    NVMCTRL->CTRLB.bit.RWS = 1; // One wait state above 24 MHz
+    clock_switch(GCLK_GENCTRL_SRC_DFLL48M, CLOCK_FAST_HZ);
+    clock_retime_fast();
+    energy_set(ENERGY_CPU_ACTIVE);
+  }
+
+  current = speed;
+  stats.speed[speed].hz = speed == CLOCK_SLOW ? slow_hz : CLOCK_FAST_HZ;
+  stats.speed[speed].switches++;
+  stats.switch_us = (uint64_t)(clock_ticks() - start) * 1000000 / CLOCK_TICKS_PER_SECOND;
+  if (stats.switch_us > stats.switch_max_us)
+  {
+    stats.switch_max_us = stats.switch_us;
+  }
+  clock_stretch_start();
+#endif
+}
+
+clock_speed clock_get()
+{
+  return current;
+}
+
+// Closes the measurement at the current speed too, so the figures are up to date
+const clock_stats *clock_get_stats()
+{
+  clock_stretch_end();
+  clock_stretch_start();
+  return &stats;
+}
+
+// One CLOCK.CSV row for a speed, with the columns of CLOCK_LOG_HEADER
+void clock_log_row(char *out, clock_speed speed)
+{
+  const clock_speed_stats *s = &clock_get_stats()->speed[speed];
+  out = fmt_uint(out, clock_millis());
+  *out++ = ',';
+  strcpy(out, speed_names[speed]);
+  out += strlen(out);
+  *out++ = ',';
+  out = fmt_uint(out, s->hz);
+  *out++ = ',';
+  out = fmt_uint(out, s->switches);
+  *out++ = ',';
+  out = fmt_uint(out, s->awake_ms);
+  *out++ = ',';
+  out = fmt_int(out, s->error_ppm);
+  *out++ = ',';
+  out = fmt_uint(out, s->current_ua);
+  *out = '\0';
+}
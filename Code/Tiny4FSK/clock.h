@@ -0,0 +1,88 @@
+/*
+clock.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// CLOCK MANAGER
+// Timebase: TC4 and TC5 run together as one 32-bit counter on the 32.768 kHz crystal (GCLK1). It keeps
+// counting in deep sleep and never needs an interrupt, and it wraps every 36 hours. clock_millis() extends
+// it to 32-bit milliseconds, as long as it is called at least once per wrap, which every packet does.
+//
+// CPU speed: with CLOCK_SCALING in config.h, GCLK0 (the CPU, its buses and the SERCOMs) runs at:
+//  - CLOCK_FAST: 48 MHz from the DFLL, locked to the crystal. Used while a packet is built and encoded.
+//  - CLOCK_SLOW: 8 MHz from OSC8M, with the DFLL stopped and no flash wait states. Used while waiting for
+//    the slot, and while the 4FSK symbols are paced out, which only takes one SPI command every 10 ms.
+// Each switch gives SysTick, the GPS UART, the SPI bus and the I2C bus new dividers, so millis(), delay()
+// and every bit rate stay the same. TC3, TC4 and TC5 count the crystal and are not touched. The ADC
+// converts more slowly at 8 MHz, which the background voltage measurement does not mind.
+// OSC8M is only trimmed to 2% over temperature, so its actual frequency is measured against the crystal
+// whenever the CPU runs slow, and the next switch uses that figure. The rate error of millis() and the
+// modelled current at each speed are kept in clock_stats, and logged to CLOCK.CSV on the SD card.
+// USB needs the 48 MHz clock, so DEV_MODE builds never leave CLOCK_FAST.
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+#define CLOCK_TICKS_PER_SECOND 32768UL
+
+#define CLOCK_FAST_HZ 48000000UL
+#define CLOCK_SLOW_HZ 8000000UL // OSC8M before it has been measured
+
+// Shortest stretch at one speed that counts as a measurement. The boot measurement takes this long.
+#define CLOCK_MEASURE_MS 250
+
+// SERCOMs on GCLK0 in the Arduino Zero variant, besides the I2C bus (I2C_DMA_SERCOM)
+#define CLOCK_UART_SERCOM SERCOM0 // Serial1, the GPS
+#define CLOCK_SPI_SERCOM SERCOM4  // SPI, the Si4063 and the SD card
+
+// Packets between rows of CLOCK.CSV, about 5 minutes at the default period
+#define CLOCK_LOG_INTERVAL 60
+#define CLOCK_LOG_HEADER "clock_ms,speed,hz,switches,awake_ms,error_ppm,model_ua"
+
+enum clock_speed
+{
+  CLOCK_FAST,
+  CLOCK_SLOW,
+  CLOCK_SPEEDS
+};
+
+struct clock_speed_stats
+{
+  uint32_t hz;         // Frequency the dividers were last set for
+  uint32_t switches;   // Times switched to this speed
+  uint32_t awake_ms;   // Time spent running at this speed, deep sleep left out
+  int32_t error_ppm;   // Rate of millis() against the crystal, over the last measurement
+  uint32_t current_ua; // Modelled CPU current at this speed, from energy.cpp
+};
+
+struct clock_stats
+{
+  clock_speed_stats speed[CLOCK_SPEEDS];
+  uint32_t switch_us;  // Last switch, including the DFLL lock and the wait for a SysTick reload
+  uint32_t switch_max_us;
+};
+
+void clock_begin();
+uint32_t clock_ticks();
+uint32_t clock_millis();
+uint32_t clock_micros();
+uint32_t clock_cycles();
+void clock_add_sleep(uint32_t ticks);
+void clock_set(clock_speed speed);
+clock_speed clock_get();
+const clock_stats *clock_get_stats();
+void clock_log_row(char *out, clock_speed speed);
@@ -56,12 +56,66 @@ Could I please get a Horus v2 ID for N0CALL? Thanks!
 // Spacing of FSK peaks. Adjust in the decoding program (e.g., Horus GUI, HorusDemodLib).
 #define FSK_SPACING 270
 
-// Delay between each packet, in milliseconds.
+// Delay between each packet, in milliseconds. Only used when GPS_TIME_SYNC is disabled.
 #define PACKET_INTERVAL 1000
 
+// Lock packet transmissions to GPS time, so packets leave on a fixed period receivers can predict.
+// A packet starts on every GPS second where (seconds of day) % TX_SLOT_PERIOD == TX_SLOT_OFFSET.
+// Several trackers can share one frequency by giving each its own TX_SLOT_OFFSET. A packet takes
+// about 3 seconds to send at 100 baud, so the offsets have to be whole packet airtimes apart, and the
+// period has to hold one packet from every tracker: at least the number of trackers times the airtime.
+// Packets then wait for GPS time before they go out. Uncomment to use.
+//#define GPS_TIME_SYNC
+
+// Packet period in seconds. At least the number of trackers on the frequency times the packet airtime.
+#define TX_SLOT_PERIOD 5
+
+// Offset of this tracker's slot within the period, in seconds.
+#define TX_SLOT_OFFSET 0
+
 // Si4063 Transmit Power Level
 #define OUTPUT_POWER 127
 
+// Adaptive packet rate. The flight phase is worked out from the ascent rate and altitude, and each phase
+// sends a packet every so many packet periods (TX_SLOT_PERIOD, or PACKET_INTERVAL without GPS_TIME_SYNC),
+// at its own power. A low or falling battery halves every rate. Changes are logged to RATE.CSV.
+// Tools/energy_model -f shows what a recorded flight would have saved. Uncomment to use. See rate.h.
+//#define ADAPTIVE_RATE
+
+// Packet periods between packets in each phase
+#define RATE_PAD_SLOTS 6
+#define RATE_ASCENT_SLOTS 1
+#define RATE_FLOAT_SLOTS 2
+#define RATE_DESCENT_SLOTS 1
+#define RATE_LANDED_SLOTS 12
+
+// Longest gap between packets in packet periods, battery saving included
+#define RATE_MAX_SLOTS 24
+
+// Battery voltages, for a single lithium AA behind the boost converter. Below RATE_LOW_MV, or when the
+// battery is on course to reach RATE_EMPTY_MV within the hour, every phase sends half as often.
+#define RATE_LOW_MV 1100
+#define RATE_EMPTY_MV 900
+
+// Transmit power level in each phase. On the pad the receivers are close, and 40 is about 10 dB down.
+#define RATE_PAD_POWER 40
+#define RATE_ASCENT_POWER OUTPUT_POWER
+#define RATE_FLOAT_POWER OUTPUT_POWER
+#define RATE_DESCENT_POWER OUTPUT_POWER
+#define RATE_LANDED_POWER OUTPUT_POWER
+
+// Dead reckoning. Each packet's position is moved forward from the last fix to the moment the packet
+// goes out, and through GPS outages of up to a minute the track is carried on from the filtered
+// velocity, with PACKET_FLAG_DEAD_RECKONED set in the packet. Uncomment to use. See track.h.
+//#define DEAD_RECKONING
+
+// Store and forward. One of every BACKFILL_EVERY packets is kept, and sent again in place of a live
+// packet once BACKFILL_DELAY_MS old, so receivers can fill gaps in the track. These packets have
+// PACKET_FLAG_BACKFILL set, and keep their counter and time. Uncomment to use. See backfill.h.
+//#define BACKFILL
+#define BACKFILL_EVERY 4
+#define BACKFILL_DELAY_MS 300000UL
+
 // If the GPS position seems to be a bad position (altitude less than zero, GPS reports bad fix),
 // then transmit all zeros.
 #define FLAG_BAD_PACKET
@@ -70,7 +124,19 @@ Could I please get a Horus v2 ID for N0CALL? Thanks!
 // || General Board Settings ||
 // ****************************
 
-// SD card headers
+// SD card logging. Every packet is appended to a preallocated binary log (FLIGHT.BIN).
+// Convert it to CSV on a computer with Tools/flightlog2csv.
+// Size of the log in 512-byte sectors, 8 packets per sector. 2048 sectors (1 MB) is about
+// 23 hours at a 5 second period. The file is created once, which takes a few seconds on a new card.
+#define FLIGHT_LOG_SECTORS 2048
+
+// Write out buffered log records every this many packets, so a reset loses at most this many. The
+// CSV logs (datalog.csv, rate.csv, clock.csv, profile.csv) are flushed every this many rows.
+#define FLIGHT_LOG_SYNC_INTERVAL 4
+
+// Also keep the old human-readable datalog.csv. It stays open like the flight log, but its text rows
+// take more room and time on the card than the binary records.
+//#define SD_CSV_LOG
 
 
 // Enable status mode LEDs for information on GPS initialization and issues.
@@ -81,8 +147,26 @@ Could I please get a Horus v2 ID for N0CALL? Thanks!
 // Disable for flights to conserve power.
 #define DEV_MODE
 
-// EXPERIMENTAL - optimise for EXTREMELY low power draw
-// Does not do anything yet!
+// Count the time each subsystem (CPU, radio, GPS, SD card, OLED) spends in each power state, and
+// print the modelled charge used per packet. Tools/energy_model runs the same accounting on a computer.
+#define ENERGY_PROFILE
+
+// Run the CPU at 8 MHz from its internal oscillator while waiting for a slot and sending the packet,
+// and at 48 MHz only while the packet is built. The GPS UART, SPI and I2C follow every change, and the
+// oscillator is measured against the crystal so timing holds. USB needs 48 MHz, so DEV_MODE builds
+// stay at full speed. See clock.h.
+#define CLOCK_SCALING
+
+// Time the packet build, CRC, encoder, OLED refresh and SD card writes in CPU cycles, and print a
+// histogram for each over USB every minute in DEV_MODE. Costs nothing when left out. See profile.h.
+//#define PROFILE
+
+// With PROFILE, also append the histograms to PROFILE.CSV on the SD card
+//#define PROFILE_SD_LOG
+
+// Optimise for EXTREMELY low power draw. Between packets the radio sleeps and the GPS goes into standby
+// whenever its fix is not needed. The OLED is switched off after setup. See power.h, and
+// Tools/energy_model for what each step saves.
 //#define ULTRA_LOW_POWER
 
 // *********************
@@ -99,6 +183,9 @@ Could I please get a Horus v2 ID for N0CALL? Thanks!
 // GPS External interrupt Pin. In junction with UART pins.
 #define EXTINT_GPS 8
 
+// GPS time pulse (PPS) input used by GPS_TIME_SYNC. If no pulses arrive, NMEA time is used instead.
+#define GPS_PPS_PIN EXTINT_GPS
+
 // Status LED Pins
 #define ERROR_LED 5
 #define SUCCESS_LED 4
@@ -121,5 +208,11 @@ Could I please get a Horus v2 ID for N0CALL? Thanks!
 // || Tiny4FSK Shield Config ||
 //*****************************
 
+// I2C addresses. Only these are probed at boot. The BME280 is looked for at both of its addresses.
 #define BME_ADDRESS 0x77
-#define IMU_ADDRESS 0x68
\ No newline at end of file
+#define BME_ADDRESS_ALT 0x76
+#define IMU_ADDRESS 0x68
+
+// Remember which I2C devices were found, in flash, so a reset in flight can skip probing.
+// A power-on or reset button boot always probes again.
+#define SHIELD_CACHE
\ No newline at end of file
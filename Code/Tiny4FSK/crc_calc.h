@@ -23,7 +23,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
 #include <stdint.h>
+#ifdef ARDUINO
 #include <Arduino.h>
+#endif
 
 uint16_t crc_xmodem_update(uint16_t crc, uint8_t data);
 unsigned int crc16(unsigned char *string, unsigned int len);
\ No newline at end of file
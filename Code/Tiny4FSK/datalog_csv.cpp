@@ -0,0 +1,67 @@
+/*
+datalog_csv.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "datalog_csv.h"
+#include <string.h>
+
+// One writer per scaling. The unscaled writer is picked by the field's type when the code is compiled.
+static inline char *datalog_write_NONE(char *out, uint32_t value) { return fmt_uint(out, value); }
+static inline char *datalog_write_NONE(char *out, uint16_t value) { return fmt_uint(out, value); }
+static inline char *datalog_write_NONE(char *out, uint8_t value) { return fmt_uint(out, value); }
+static inline char *datalog_write_NONE(char *out, int16_t value) { return fmt_int(out, value); }
+static inline char *datalog_write_NONE(char *out, int8_t value) { return fmt_int(out, value); }
+static inline char *datalog_write_NONE(char *out, float value) { return fmt_float(out, value, 7); }
+static inline char *datalog_write_DIV10(char *out, int32_t value) { return fmt_fixed(out, value, 1); }
+static inline char *datalog_write_DIV100(char *out, int32_t value) { return fmt_fixed(out, value, 2); }
+
+// Hundredths of a volt, rounded to nearest
+static inline char *datalog_write_BATT5V(char *out, uint32_t value)
+{
+  return fmt_fixed(out, (value * 500 + 127) / 255, 2);
+}
+
+#define DATALOG_WRITE_COLUMN(name, type, scale, unit, column) \
+  out = datalog_write_##scale(out, p.name);                   \
+  *out++ = ',';
+
+int datalog_csv_row(char *out, const HorusBinaryPacketV2 &p)
+{
+  char *start = out;
+  HORUS_PACKET_FIELDS(DATALOG_WRITE_COLUMN)
+
+  // Replace the last separator with the terminator
+  *--out = '\0';
+  return out - start;
+}
+
+#define DATALOG_WRITE_TEXT(name, type, scale, unit, column)     \
+  memcpy(out, #name ": ", sizeof(#name) + 1);                   \
+  out = datalog_write_##scale(out + sizeof(#name) + 1, p.name); \
+  memcpy(out, " " unit ", ", sizeof(unit) + 2);                 \
+  out += sizeof(unit) + 2;
+
+int datalog_text_row(char *out, const HorusBinaryPacketV2 &p)
+{
+  char *start = out;
+  HORUS_PACKET_FIELDS(DATALOG_WRITE_TEXT)
+
+  // Drop the last separator
+  out -= 2;
+  *out = '\0';
+  return out - start;
+}
@@ -0,0 +1,47 @@
+/*
+datalog_csv.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// DATALOG.CSV WRITER
+// One column per packet field, generated from the packet schema in packet.h, so the header row and
+// the row writer can never disagree with the packet. Values are written in the schema's units:
+// integers as they are, floats with 7 decimals like printf("%.7f"), and scaled fields with as many
+// decimals as their scaling has (DIV10 one, DIV100 and BATT5V two).
+// The same writer gives the DEV_MODE dump, as "name: value unit" pairs.
+#pragma once
+
+#include <stdint.h>
+#include "packet.h"
+#include "fixed_format.h"
+
+// Header row, without a line ending
+#define DATALOG_HEADER_NAME(name, type, scale, unit, column) "," #name
+#define DATALOG_HEADER (HORUS_PACKET_FIELDS(DATALOG_HEADER_NAME) + 1)
+
+// Longest possible row, NUL included
+#define DATALOG_COLUMN_CHARS(name, type, scale, unit, column) +FMT_MAX_CHARS + 1
+#define DATALOG_MAX_ROW (0 HORUS_PACKET_FIELDS(DATALOG_COLUMN_CHARS) + 1)
+
+// Longest possible dump line, NUL included
+#define DATALOG_TEXT_CHARS(name, type, scale, unit, column) +sizeof(#name) + 1 + FMT_MAX_CHARS + sizeof(unit) + 2
+#define DATALOG_MAX_TEXT (0 HORUS_PACKET_FIELDS(DATALOG_TEXT_CHARS) + 1)
+
+// Writes one NUL terminated row (no line ending) for the packet. Returns the row length.
+int datalog_csv_row(char *out, const HorusBinaryPacketV2 &p);
+
+// Writes the packet as "PayloadID: 380 -, Counter: 12 -, ..." for the DEV_MODE dump. Returns the length.
+int datalog_text_row(char *out, const HorusBinaryPacketV2 &p);
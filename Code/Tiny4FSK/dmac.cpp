@@ -0,0 +1,87 @@
+/*
+dmac.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "dmac.h"
+
+// The DMAC reads the first descriptor of each channel from here, and writes channel state back
+static DmacDescriptor descriptors[DMAC_CHANNELS] __attribute__((aligned(16)));
+static DmacDescriptor writeback[DMAC_CHANNELS] __attribute__((aligned(16)));
+static bool dmac_started = false;
+
+void dmac_begin()
+{
+  if (dmac_started)
+  {
+    return;
+  }
+
+  PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+  PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+
+  DMAC->CTRL.reg &= ~DMAC_CTRL_DMAENABLE;
+  DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+  while (DMAC->CTRL.reg & DMAC_CTRL_SWRST)
+    ;
+
+  memset(descriptors, 0, sizeof(descriptors));
+  memset(writeback, 0, sizeof(writeback));
+  DMAC->BASEADDR.reg = (uint32_t)descriptors;
+  DMAC->WRBADDR.reg = (uint32_t)writeback;
+  DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+  dmac_started = true;
+}
+
+DmacDescriptor *dmac_descriptor(uint8_t channel)
+{
+  return &descriptors[channel];
+}
+
+// Start a channel with its descriptor already filled in. One beat is moved per trigger.
+void dmac_start(uint8_t channel, uint8_t trigger)
+{
+  DMAC->CHID.reg = DMAC_CHID_ID(channel);
+  DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+  DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+  while (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_SWRST)
+    ;
+  DMAC->CHCTRLB.reg = DMAC_CHCTRLB_TRIGSRC(trigger) | DMAC_CHCTRLB_TRIGACT_BEAT | DMAC_CHCTRLB_LVL(0);
+  DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+  DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+}
+
+void dmac_stop(uint8_t channel)
+{
+  DMAC->CHID.reg = DMAC_CHID_ID(channel);
+  DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+  while (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_ENABLE)
+    ;
+  DMAC->CHINTFLAG.reg = DMAC_CHINTFLAG_MASK;
+}
+
+// The whole descriptor chain has been moved
+bool dmac_done(uint8_t channel)
+{
+  DMAC->CHID.reg = DMAC_CHID_ID(channel);
+  return DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL;
+}
+
+bool dmac_error(uint8_t channel)
+{
+  DMAC->CHID.reg = DMAC_CHID_ID(channel);
+  return DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TERR;
+}
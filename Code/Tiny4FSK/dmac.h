@@ -0,0 +1,36 @@
+/*
+dmac.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// DMA CONTROLLER
+// Owns the SAMD21 DMAC descriptor tables. Each user of DMA gets a fixed channel number here,
+// fills in that channel's first descriptor, then starts the channel with its peripheral trigger.
+// Channels are polled for completion, there is no DMAC interrupt handler.
+#pragma once
+
+#include <Arduino.h>
+
+// Channel numbers. Raise DMAC_CHANNELS when adding one, each costs 32 bytes of RAM.
+#define DMAC_CHANNEL_I2C 0
+#define DMAC_CHANNELS 1
+
+void dmac_begin();
+DmacDescriptor *dmac_descriptor(uint8_t channel);
+void dmac_start(uint8_t channel, uint8_t trigger);
+void dmac_stop(uint8_t channel);
+bool dmac_done(uint8_t channel);
+bool dmac_error(uint8_t channel);
@@ -0,0 +1,230 @@
+/*
+energy.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "energy.h"
+#include <Arduino.h>
+#ifdef ARDUINO
+#include "clock.h"
+#endif
+
+// Modelled current of each state at the 3.3 V rail, in microamps. Typical datasheet figures,
+// measure the board and update these if better numbers are known.
+static const uint32_t current_ua[ENERGY_STATES] = {
+    6500,  // CPU active, 48 MHz from the DFLL, with USB and the SERCOMs clocked
+    1500,  // CPU at 8 MHz from OSC8M, the DFLL stopped, no flash wait states
+    50,    // CPU in standby, with the crystal, RTC and timebase running
+    0,     // Si4063 shut down
+    1,     // Si4063 sleep
+    1800,  // Si4063 ready, crystal and regulators on
+    75000, // Si4063 transmitting at full power, see energy_set_tx_power()
+    25000, // GPS tracking
+    50,    // GPS standby
+    0,     // No SD card
+    500,   // SD card idle in SPI mode, varies a lot between cards
+    30000, // SD card writing
+    10,    // OLED display off
+    8000,  // OLED showing a few lines of text, charge pump on
+    8300,  // OLED on, plus the I2C pull-ups while a refresh is sent
+};
+
+static const uint8_t state_subsystem[ENERGY_STATES] = {
+    ENERGY_CPU, ENERGY_CPU, ENERGY_CPU,
+    ENERGY_RADIO, ENERGY_RADIO, ENERGY_RADIO, ENERGY_RADIO,
+    ENERGY_GPS, ENERGY_GPS,
+    ENERGY_SD, ENERGY_SD, ENERGY_SD,
+    ENERGY_OLED, ENERGY_OLED, ENERGY_OLED};
+
+static const char *const subsystem_names[ENERGY_SUBSYSTEMS] = {"CPU", "Radio", "GPS", "SD", "OLED"};
+
+static const char *const state_names[ENERGY_STATES] = {
+    "CPU active", "CPU slow", "CPU sleep",
+    "Radio off", "Radio sleep", "Radio ready", "Radio TX",
+    "GPS on", "GPS standby",
+    "SD off", "SD idle", "SD busy",
+    "OLED off", "OLED on", "OLED push"};
+
+energy_subsystem energy_state_subsystem(energy_state state)
+{
+  return (energy_subsystem)state_subsystem[state];
+}
+
+// Transmit current at the PA level in use. The PA draws roughly in proportion to its level, on top of
+// what the synthesizer and the PA bias take at the lowest level.
+#define ENERGY_TX_FLOOR_UA 18000
+static uint32_t tx_current_ua = current_ua[ENERGY_RADIO_TX];
+
+void energy_set_tx_power(uint8_t level)
+{
+  tx_current_ua = ENERGY_TX_FLOOR_UA + (current_ua[ENERGY_RADIO_TX] - ENERGY_TX_FLOOR_UA) * (level & 0x7F) / 127;
+}
+
+uint32_t energy_current_ua(energy_state state)
+{
+  return state == ENERGY_RADIO_TX ? tx_current_ua : current_ua[state];
+}
+
+const char *energy_subsystem_name(energy_subsystem subsystem)
+{
+  return subsystem_names[subsystem];
+}
+
+const char *energy_state_name(energy_state state)
+{
+  return state_names[state];
+}
+
+#ifdef ENERGY_PROFILE
+
+// Microamp ticks in one microamp hour
+#define ENERGY_UA_TICKS_PER_UAH ((uint64_t)ENERGY_TICKS_PER_SECOND * 3600)
+
+static bool started = false;
+static uint8_t current[ENERGY_SUBSYSTEMS]; // State each subsystem is in
+static uint32_t since[ENERGY_SUBSYSTEMS];  // Tick it went into that state
+static uint32_t state_ticks[ENERGY_STATES]; // Time in each state since the last report
+static uint32_t report_start = 0;
+static uint64_t since_boot_ua_ticks = 0;
+
+#ifdef ARDUINO
+static_assert(ENERGY_TICKS_PER_SECOND == CLOCK_TICKS_PER_SECOND, "Energy is counted on the clock timebase");
+
+static uint32_t energy_ticks()
+{
+  return clock_ticks();
+}
+
+// State changes can come from interrupts too
+static uint32_t energy_lock()
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  return primask;
+}
+
+static void energy_unlock(uint32_t primask)
+{
+  __set_PRIMASK(primask);
+}
+#else
+// Host builds count on micros(), which the tool drives
+static uint32_t energy_ticks()
+{
+  return (uint32_t)((uint64_t)micros() * ENERGY_TICKS_PER_SECOND / 1000000);
+}
+
+static uint32_t energy_lock() { return 0; }
+static void energy_unlock(uint32_t primask) {}
+#endif
+
+void energy_begin()
+{
+  // Where everything is at boot, before the drivers report in
+  current[ENERGY_CPU] = ENERGY_CPU_ACTIVE;
+  current[ENERGY_RADIO] = ENERGY_RADIO_OFF;
+  current[ENERGY_GPS] = ENERGY_GPS_ON;
+  current[ENERGY_SD] = ENERGY_SD_OFF;
+  current[ENERGY_OLED] = ENERGY_OLED_OFF;
+  uint32_t now = energy_ticks();
+  for (uint8_t i = 0; i < ENERGY_SUBSYSTEMS; i++)
+  {
+    since[i] = now;
+  }
+  memset(state_ticks, 0, sizeof(state_ticks));
+  report_start = now;
+  since_boot_ua_ticks = 0;
+  started = true;
+}
+
+// Books the time spent in the subsystem's old state, then moves it to the new one
+void energy_set(energy_state state)
+{
+  if (!started)
+  {
+    return;
+  }
+  uint8_t subsystem = state_subsystem[state];
+  uint32_t primask = energy_lock();
+  uint32_t now = energy_ticks();
+  state_ticks[current[subsystem]] += now - since[subsystem];
+  since[subsystem] = now;
+  current[subsystem] = state;
+  energy_unlock(primask);
+}
+
+// For changes noticed late, like a GPS waking itself up: the change happened ms milliseconds ago
+void energy_set_ago(energy_state state, uint32_t ms)
+{
+  if (!started)
+  {
+    return;
+  }
+  uint8_t subsystem = state_subsystem[state];
+  uint32_t primask = energy_lock();
+  uint32_t now = energy_ticks();
+  uint32_t ago = (uint64_t)ms * ENERGY_TICKS_PER_SECOND / 1000;
+  uint32_t at = ago < now - since[subsystem] ? now - ago : since[subsystem];
+  state_ticks[current[subsystem]] += at - since[subsystem];
+  state_ticks[state] += now - at;
+  since[subsystem] = now;
+  current[subsystem] = state;
+  energy_unlock(primask);
+}
+
+// Everything since the last report. Call once per packet.
+void energy_take_report(energy_report *report)
+{
+  memset(report, 0, sizeof(*report));
+  if (!started)
+  {
+    return;
+  }
+
+  uint32_t ticks[ENERGY_STATES];
+  uint32_t primask = energy_lock();
+  uint32_t now = energy_ticks();
+  for (uint8_t i = 0; i < ENERGY_SUBSYSTEMS; i++)
+  {
+    state_ticks[current[i]] += now - since[i];
+    since[i] = now;
+  }
+  memcpy(ticks, state_ticks, sizeof(ticks));
+  memset(state_ticks, 0, sizeof(state_ticks));
+  uint32_t duration = now - report_start;
+  report_start = now;
+  energy_unlock(primask);
+
+  // Charge is time multiplied by current, summed per subsystem in microamp ticks
+  uint64_t ua_ticks[ENERGY_SUBSYSTEMS] = {0};
+  for (uint8_t i = 0; i < ENERGY_STATES; i++)
+  {
+    report->state_ms[i] = (uint64_t)ticks[i] * 1000 / ENERGY_TICKS_PER_SECOND;
+    ua_ticks[state_subsystem[i]] += (uint64_t)ticks[i] * energy_current_ua((energy_state)i);
+  }
+  uint64_t total = 0;
+  for (uint8_t i = 0; i < ENERGY_SUBSYSTEMS; i++)
+  {
+    report->charge_nah[i] = ua_ticks[i] * 1000 / ENERGY_UA_TICKS_PER_UAH;
+    report->total_nah += report->charge_nah[i];
+    total += ua_ticks[i];
+  }
+  report->duration_ms = (uint64_t)duration * 1000 / ENERGY_TICKS_PER_SECOND;
+  since_boot_ua_ticks += total;
+  report->since_boot_uah = since_boot_ua_ticks / ENERGY_UA_TICKS_PER_UAH;
+}
+
+#endif
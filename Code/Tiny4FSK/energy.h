@@ -0,0 +1,92 @@
+/*
+energy.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// ENERGY ACCOUNTING
+// Each subsystem reports its state changes with energy_set(), and the time spent in every state is
+// counted on the 32.768 kHz crystal timebase (clock.h), which keeps running in deep sleep. Time is
+// turned into charge with a table of modelled currents (energy.cpp), so the figures are only as good
+// as that table, but they show where the charge goes. energy_take_report() closes the books once per packet.
+// Without ENERGY_PROFILE in config.h every call here compiles to nothing.
+// On a computer the counter follows micros(), see Tools/energy_model.cpp.
+#pragma once
+
+#include <stdint.h>
+#include "config.h"
+
+#define ENERGY_TICKS_PER_SECOND 32768UL
+
+// Currents are modelled at the 3.3 V rail. The boost converter draws more than this from the cell.
+#define ENERGY_RAIL_MV 3300
+
+enum energy_subsystem
+{
+  ENERGY_CPU,
+  ENERGY_RADIO,
+  ENERGY_GPS,
+  ENERGY_SD,
+  ENERGY_OLED,
+  ENERGY_SUBSYSTEMS
+};
+
+// Every state belongs to one subsystem, and each subsystem is in exactly one of its states
+enum energy_state
+{
+  ENERGY_CPU_ACTIVE,
+  ENERGY_CPU_SLOW,    // Running at 8 MHz, see clock.h
+  ENERGY_CPU_SLEEP,
+  ENERGY_RADIO_OFF,   // SDN high
+  ENERGY_RADIO_SLEEP,
+  ENERGY_RADIO_READY,
+  ENERGY_RADIO_TX,
+  ENERGY_GPS_ON,
+  ENERGY_GPS_STANDBY,
+  ENERGY_SD_OFF,      // No card
+  ENERGY_SD_IDLE,
+  ENERGY_SD_BUSY,
+  ENERGY_OLED_OFF,
+  ENERGY_OLED_ON,
+  ENERGY_OLED_PUSH,   // Panel on, with a refresh on the I2C bus
+  ENERGY_STATES
+};
+
+struct energy_report
+{
+  uint32_t duration_ms;                   // Time covered by this report
+  uint32_t state_ms[ENERGY_STATES];       // Time spent in each state
+  uint32_t charge_nah[ENERGY_SUBSYSTEMS]; // Charge drawn by each subsystem, nanoamp hours
+  uint32_t total_nah;                     // All subsystems together
+  uint32_t since_boot_uah;                // Running total over every report so far, microamp hours
+};
+
+energy_subsystem energy_state_subsystem(energy_state state);
+uint32_t energy_current_ua(energy_state state);
+void energy_set_tx_power(uint8_t level);
+const char *energy_subsystem_name(energy_subsystem subsystem);
+const char *energy_state_name(energy_state state);
+
+#ifdef ENERGY_PROFILE
+void energy_begin();
+void energy_set(energy_state state);
+void energy_set_ago(energy_state state, uint32_t ms);
+void energy_take_report(energy_report *report);
+#else
+inline void energy_begin() {}
+inline void energy_set(energy_state state) {}
+inline void energy_set_ago(energy_state state, uint32_t ms) {}
+inline void energy_take_report(energy_report *report) {}
+#endif
@@ -0,0 +1,159 @@
+/*
+fixed_format.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "fixed_format.h"
+#include <string.h>
+
+static const uint32_t powers_of_ten[] = {
+    1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL};
+
+// Divide by 10 without a divide instruction (Hacker's Delight, 10-17)
+static inline uint32_t div10(uint32_t n, uint8_t *rem)
+{
+  uint32_t q = (n >> 1) + (n >> 2);
+  q += q >> 4;
+  q += q >> 8;
+  q += q >> 16;
+  q >>= 3;
+  uint32_t r = n - ((q << 2) + q) * 2;
+  if (r > 9)
+  {
+    q++;
+    r -= 10;
+  }
+  *rem = r;
+  return q;
+}
+
+// Writes at least min_digits digits, zero padded
+static char *fmt_digits(char *out, uint32_t value, uint8_t min_digits)
+{
+  char digits[10];
+  uint8_t count = 0;
+  uint8_t rem;
+
+  do
+  {
+    value = div10(value, &rem);
+    digits[count++] = '0' + rem;
+  } while (value);
+
+  while (count < min_digits)
+  {
+    digits[count++] = '0';
+  }
+  while (count)
+  {
+    *out++ = digits[--count];
+  }
+  return out;
+}
+
+char *fmt_uint(char *out, uint32_t value)
+{
+  return fmt_digits(out, value, 1);
+}
+
+char *fmt_int(char *out, int32_t value)
+{
+  if (value < 0)
+  {
+    *out++ = '-';
+    return fmt_digits(out, 0U - (uint32_t)value, 1);
+  }
+  return fmt_digits(out, value, 1);
+}
+
+char *fmt_fixed(char *out, int32_t value, uint8_t decimals, bool negative_zero)
+{
+  uint32_t magnitude = value;
+  if (value < 0 || (value == 0 && negative_zero))
+  {
+    *out++ = '-';
+    magnitude = 0U - (uint32_t)value;
+  }
+  if (decimals == 0)
+  {
+    return fmt_digits(out, magnitude, 1);
+  }
+
+  // Print all digits, then slide the decimals over to make room for the point
+  char *start = out;
+  out = fmt_digits(out, magnitude, decimals + 1);
+  memmove(out - decimals + 1, out - decimals, decimals);
+  start[out - start - decimals] = '.';
+  return out + 1;
+}
+
+int32_t float_to_fixed(float value, uint8_t decimals)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  bool negative = bits >> 31;
+  int exponent = (bits >> 23) & 0xFF;
+  if (exponent == 0)
+  {
+    // Zero or denormal, far too small to show
+    return 0;
+  }
+  if (exponent == 0xFF)
+  {
+    // Inf or NaN
+    return negative ? INT32_MIN : INT32_MAX;
+  }
+
+  // value = mantissa * 2^-shift, so value * 10^decimals = product * 2^-shift
+  uint64_t mantissa = (bits & 0x7FFFFF) | 0x800000;
+  uint64_t product = mantissa * powers_of_ten[decimals];
+  int shift = 150 - exponent;
+  uint64_t result;
+
+  if (shift <= 0)
+  {
+    result = shift > -8 ? product << -shift : UINT64_MAX;
+  }
+  else if (shift >= 64)
+  {
+    result = 0;
+  }
+  else
+  {
+    // Round half to even on the exact binary value, the same as printf
+    uint64_t remainder = product & ((1ULL << shift) - 1);
+    uint64_t half = 1ULL << (shift - 1);
+    result = product >> shift;
+    if (remainder > half || (remainder == half && (result & 1)))
+    {
+      result++;
+    }
+  }
+
+  if (result > INT32_MAX)
+  {
+    return negative ? INT32_MIN : INT32_MAX;
+  }
+  return negative ? -(int32_t)result : (int32_t)result;
+}
+
+char *fmt_float(char *out, float value, uint8_t decimals)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return fmt_fixed(out, float_to_fixed(value, decimals), decimals, bits >> 31);
+}
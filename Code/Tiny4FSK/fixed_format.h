@@ -0,0 +1,43 @@
+/*
+fixed_format.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// INTEGER NUMBER FORMATTING
+// Small replacements for printf number formatting that never touch floating point printf.
+// The Cortex-M0+ has no divide instruction, so division by 10 is done with shifts and adds.
+// Each function writes at the given pointer and returns a pointer just past the last character.
+// Nothing is NUL terminated. Shared with the host tools, so no Arduino includes.
+#pragma once
+
+#include <stdint.h>
+
+// Longest output of any function below, sign included
+#define FMT_MAX_CHARS 12
+
+char *fmt_uint(char *out, uint32_t value);
+char *fmt_int(char *out, int32_t value);
+
+// Prints value / 10^decimals with exactly that many decimals, e.g. (1234, 2) -> "12.34"
+// negative_zero prints a "-" for a zero value, like printf does for a small negative float.
+char *fmt_fixed(char *out, int32_t value, uint8_t decimals, bool negative_zero = false);
+
+// Rounds a float to an integer number of 10^-decimals units, exactly like printf("%.Nf") rounds.
+// Values too large for an int32 are clamped.
+int32_t float_to_fixed(float value, uint8_t decimals);
+
+// Prints a float like printf("%.Nf") would, for decimals up to 9
+char *fmt_float(char *out, float value, uint8_t decimals);
@@ -0,0 +1,286 @@
+/*
+flight_log.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "flight_log.h"
+#include "energy.h"
+#include "morse.h"
+
+// Records in the whole ring
+#define FLIGHT_LOG_CAPACITY ((uint32_t)FLIGHT_LOG_SECTORS * FLIGHT_LOG_RECORDS_PER_SECTOR)
+
+static File log_file;
+static bool log_open = false;
+
+// Sector being filled, and where it goes in the file
+static uint8_t sector[FLIGHT_LOG_SECTOR_SIZE] __attribute__((aligned(4)));
+static uint32_t sector_index = 0;
+static uint16_t sector_fill = 0;
+static uint16_t unsynced = 0;
+static uint32_t next_sequence = 0;
+
+static flight_log_stats stats;
+
+static bool flight_log_write_sector()
+{
+  energy_set(ENERGY_SD_BUSY);
+  bool ok = log_file.seek(sector_index * FLIGHT_LOG_SECTOR_SIZE) &&
+            log_file.write(sector, FLIGHT_LOG_SECTOR_SIZE) == FLIGHT_LOG_SECTOR_SIZE;
+  energy_set(ENERGY_SD_IDLE);
+  return ok;
+}
+
+static bool flight_log_read_record(uint32_t index, uint8_t slot, flight_log_record *record)
+{
+  stats.resume_reads++;
+  if (!log_file.seek(index * FLIGHT_LOG_SECTOR_SIZE + slot * sizeof(*record)) ||
+      log_file.read(record, sizeof(*record)) != sizeof(*record))
+  {
+    return false;
+  }
+  return flight_log_record_valid(record);
+}
+
+// Sequence of the first record in a sector, if it is valid and belongs in that sector
+static bool flight_log_sector_start(uint32_t index, uint32_t *sequence)
+{
+  flight_log_record record;
+  if (!flight_log_read_record(index, 0, &record) ||
+      record.sequence % FLIGHT_LOG_CAPACITY != index * FLIGHT_LOG_RECORDS_PER_SECTOR)
+  {
+    return false;
+  }
+  *sequence = record.sequence;
+  return true;
+}
+
+// Binary search for the sector holding the newest record
+static bool flight_log_find_newest(uint32_t *newest)
+{
+  uint32_t first;
+  if (!flight_log_sector_start(0, &first))
+  {
+    // Either a new log, or sector 0 was being rewritten when the power went
+    if (flight_log_sector_start(FLIGHT_LOG_SECTORS - 1, &first))
+    {
+      *newest = FLIGHT_LOG_SECTORS - 1;
+      return true;
+    }
+    return false;
+  }
+
+  // Sectors 0 to newest hold the current lap of the ring. Anything after is older or unused.
+  uint32_t lap = first / FLIGHT_LOG_CAPACITY;
+  uint32_t low = 0;
+  uint32_t high = FLIGHT_LOG_SECTORS - 1;
+  while (low < high)
+  {
+    uint32_t mid = (low + high + 1) / 2;
+    uint32_t sequence;
+    if (flight_log_sector_start(mid, &sequence) && sequence / FLIGHT_LOG_CAPACITY == lap)
+    {
+      low = mid;
+    }
+    else
+    {
+      high = mid - 1;
+    }
+  }
+  *newest = low;
+  return true;
+}
+
+// Load the newest sector back into RAM and carry on right after its last good record
+static void flight_log_resume()
+{
+  uint32_t newest;
+  memset(sector, 0, sizeof(sector));
+  sector_index = 0;
+  sector_fill = 0;
+  next_sequence = 0;
+
+  if (!flight_log_find_newest(&newest))
+  {
+    return;
+  }
+
+  log_file.seek(newest * FLIGHT_LOG_SECTOR_SIZE);
+  log_file.read(sector, FLIGHT_LOG_SECTOR_SIZE);
+  stats.resume_reads++;
+
+  flight_log_record *records = (flight_log_record *)sector;
+  uint32_t first = records[0].sequence;
+  uint8_t count = 0;
+  while (count < FLIGHT_LOG_RECORDS_PER_SECTOR && flight_log_record_valid(&records[count]) &&
+         records[count].sequence == first + count)
+  {
+    count++;
+  }
+
+  // Drop anything after the last good record, it is torn or from an older lap
+  memset(sector + count * sizeof(flight_log_record), 0, FLIGHT_LOG_SECTOR_SIZE - count * sizeof(flight_log_record));
+  sector_index = newest;
+  sector_fill = count * sizeof(flight_log_record);
+  next_sequence = first + count;
+
+  if (sector_fill >= FLIGHT_LOG_SECTOR_SIZE)
+  {
+    sector_index = (sector_index + 1) % FLIGHT_LOG_SECTORS;
+    sector_fill = 0;
+    memset(sector, 0, sizeof(sector));
+  }
+}
+
+bool flight_log_begin(const char *filename)
+{
+  // Not FILE_WRITE, that forces every write to the end of the file
+  log_file = SD.open(filename, O_READ | O_WRITE | O_CREAT);
+  if (!log_file)
+  {
+    return false;
+  }
+
+  // Preallocate the whole log on first use, so the FAT is never touched again during the flight
+  memset(sector, 0, sizeof(sector));
+  if (log_file.size() < (uint32_t)FLIGHT_LOG_SECTORS * FLIGHT_LOG_SECTOR_SIZE)
+  {
+    log_file.seek(log_file.size());
+    while (log_file.size() < (uint32_t)FLIGHT_LOG_SECTORS * FLIGHT_LOG_SECTOR_SIZE)
+    {
+      if (log_file.write(sector, FLIGHT_LOG_SECTOR_SIZE) != FLIGHT_LOG_SECTOR_SIZE)
+      {
+        log_file.close();
+        return false;
+      }
+    }
+    log_file.flush();
+  }
+
+  uint32_t start = micros();
+  flight_log_resume();
+  stats.resume_us = micros() - start;
+
+  unsynced = 0;
+  log_open = true;
+  return true;
+}
+
+// The newest record in the log, for picking up where the last boot left off
+bool flight_log_last(flight_log_record *record)
+{
+  if (!log_open || next_sequence == 0)
+  {
+    return false;
+  }
+
+  uint32_t slot = (next_sequence - 1) % FLIGHT_LOG_CAPACITY;
+  uint32_t index = slot / FLIGHT_LOG_RECORDS_PER_SECTOR;
+  uint8_t position = slot % FLIGHT_LOG_RECORDS_PER_SECTOR;
+  if (index == sector_index && sector_fill > 0)
+  {
+    memcpy(record, sector + position * sizeof(*record), sizeof(*record));
+    return true;
+  }
+  return flight_log_read_record(index, position, record);
+}
+
+// Writes a full sector and moves on around the ring, or syncs the partial one when it is due
+static bool flight_log_write_out()
+{
+  if (sector_fill >= FLIGHT_LOG_SECTOR_SIZE)
+  {
+    bool ok = flight_log_write_sector();
+    sector_index = (sector_index + 1) % FLIGHT_LOG_SECTORS;
+    sector_fill = 0;
+    unsynced = 0;
+    memset(sector, 0, sizeof(sector));
+    stats.sectors++;
+    return ok;
+  }
+  if (unsynced >= FLIGHT_LOG_SYNC_INTERVAL)
+  {
+    return flight_log_sync();
+  }
+  return true;
+}
+
+// Stamps the record with its sequence number and CRC, then queues it
+bool flight_log_append(flight_log_record *record)
+{
+  if (!log_open)
+  {
+    return false;
+  }
+
+  uint32_t start = micros();
+  bool ok = true;
+
+  // A sector left full by a held off write goes out first
+  if (sector_fill >= FLIGHT_LOG_SECTOR_SIZE)
+  {
+    ok = flight_log_write_out();
+  }
+
+  record->magic = FLIGHT_LOG_MAGIC;
+  record->sequence = next_sequence++;
+  record->crc = crc16((unsigned char *)record, sizeof(*record) - sizeof(record->crc));
+  memcpy(sector + sector_fill, record, sizeof(*record));
+  sector_fill += sizeof(*record);
+  stats.records++;
+  unsynced++;
+
+  // The card shares the SPI bus with the radio, which is keyed from an interrupt while the callsign
+  // goes out. The record then waits in the sector buffer, and is written with the next one.
+  if (!morse_busy())
+  {
+    ok = flight_log_write_out() && ok;
+  }
+
+  stats.last_us = micros() - start;
+  stats.total_us += stats.last_us;
+  if (stats.last_us > stats.max_us)
+  {
+    stats.max_us = stats.last_us;
+  }
+  return ok;
+}
+
+// Write out the partially filled sector. It gets written again once more records land in it.
+bool flight_log_sync()
+{
+  if (!log_open)
+  {
+    return false;
+  }
+
+  bool ok = true;
+  if (sector_fill > 0)
+  {
+    ok = flight_log_write_sector();
+  }
+  energy_set(ENERGY_SD_BUSY);
+  log_file.flush();
+  energy_set(ENERGY_SD_IDLE);
+  unsynced = 0;
+  stats.syncs++;
+  return ok;
+}
+
+const flight_log_stats *flight_log_get_stats()
+{
+  return &stats;
+}
@@ -0,0 +1,89 @@
+/*
+flight_log.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// BINARY FLIGHT LOGGER
+// Keeps one preallocated log file open for the whole flight and appends fixed-size records into a
+// 512-byte RAM sector. Only whole sectors are written to the card, plus a padded partial sector
+// every FLIGHT_LOG_SYNC_INTERVAL records so a crash loses at most that many records.
+// The file is a journaled ring: record number N (its sequence) always lives in slot
+// N % (FLIGHT_LOG_SECTORS * FLIGHT_LOG_RECORDS_PER_SECTOR), and carries a CRC. After a reset the
+// newest record is found with a binary search over the sectors, so resuming takes the same time
+// however full the log is. When the ring is full the oldest records are overwritten.
+// Use Tools/flightlog2csv to turn the log into a CSV file.
+// The record layout is shared with the host tools, so the Arduino parts are kept behind ARDUINO.
+#pragma once
+
+#include <stdint.h>
+#include "packet.h"
+#include "crc_calc.h"
+
+#define FLIGHT_LOG_SECTOR_SIZE 512
+#define FLIGHT_LOG_MAGIC 0x4A54 // "TJ"
+
+// One log entry per packet. Must divide the sector size evenly.
+struct flight_log_record
+{
+  uint16_t magic;               // FLIGHT_LOG_MAGIC, zero for unused space
+  HorusBinaryPacketV2 packet;   // Packet exactly as transmitted
+  uint32_t timestamp_ms;        // Local time of the packet
+  int32_t pressure_pa;          // Full resolution BME280 pressure
+  int16_t temperature_centi;    // BME280 temperature, hundredths of a degree C
+  uint16_t humidity_centi;      // BME280 humidity, hundredths of a percent
+  uint16_t battery_mv;          // Battery voltage in millivolts
+  int32_t slot_error_us;        // Packet start error against the GPS time slot
+  uint32_t sequence;            // Record number, counting up from the first record ever written
+  uint16_t peak_accel_mg;       // IMU summary since the last packet, zero without an IMU
+  uint16_t vibration_mg;
+  int16_t spin_dps;
+  uint16_t crc;                 // crc16() of everything above
+} __attribute__((packed));
+
+#define FLIGHT_LOG_RECORDS_PER_SECTOR (FLIGHT_LOG_SECTOR_SIZE / sizeof(flight_log_record))
+
+static_assert(FLIGHT_LOG_SECTOR_SIZE % sizeof(flight_log_record) == 0, "Flight log records must not straddle sectors");
+
+// A record is only trusted if both the magic and the CRC match
+inline bool flight_log_record_valid(const flight_log_record *record)
+{
+  return record->magic == FLIGHT_LOG_MAGIC &&
+         (uint16_t)crc16((unsigned char *)record, sizeof(*record) - sizeof(record->crc)) == record->crc;
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <SD.h>
+#include "config.h"
+
+struct flight_log_stats
+{
+  uint32_t records;  // Records appended since boot
+  uint32_t sectors;  // Full sectors written
+  uint32_t syncs;    // Partial sector syncs
+  uint32_t last_us;  // Cost of the last append, including any card writes
+  uint32_t max_us;   // Worst append so far
+  uint32_t total_us; // Sum of all appends, for the average
+  uint32_t resume_us;    // Time taken to find the newest record at boot
+  uint32_t resume_reads; // Card reads needed to find it
+};
+
+bool flight_log_begin(const char *filename);
+bool flight_log_last(flight_log_record *record);
+bool flight_log_append(flight_log_record *record);
+bool flight_log_sync();
+const flight_log_stats *flight_log_get_stats();
+#endif
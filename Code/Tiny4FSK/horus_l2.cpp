@@ -469,7 +469,7 @@ void horus_l2_decode_rx_packet(unsigned char *output_payload_data,
 
 #ifdef INTERLEAVER
 
-uint16_t primes[] = {
+static const uint16_t primes[] = {
     2,      3,      5,      7,      11,     13,     17,     19,     23,     29, 
     31,     37,     41,     43,     47,     53,     59,     61,     67,     71, 
     73,     79,     83,     89,     97,     101,    103,    107,    109,    113, 
@@ -485,9 +485,9 @@ void interleave(unsigned char *inout, int nbytes, int dir)
     uint16_t nbits = (uint16_t)nbytes*8;
     uint32_t i, j, n, ibit, ibyte, ishift, jbyte, jshift;
     uint32_t b;
-    unsigned char out[nbytes];
-
+    unsigned char out[HORUS_L2_TX_BYTES(HORUS_L2_MAX_PAYLOAD_BYTES)];
 
+    assert(nbytes <= (int)sizeof(out));
     memset(out, 0, nbytes);
            
     /* b chosen to be co-prime with nbits, I'm cheating by just finding the 
@@ -8,6 +8,14 @@
 
 #pragma once
 
+/* Largest payload the encoder takes (a Horus Binary v2 packet), and the
+   same sum as horus_l2_get_num_tx_data_bytes() for sizing buffers at
+   compile time: unique word, payload and 11 parity bits per 12 bit
+   Golay codeword, rounded up to whole bytes */
+#define HORUS_L2_MAX_PAYLOAD_BYTES 32
+#define HORUS_L2_TX_BYTES(payload_bytes) \
+    ((16 + (payload_bytes)*8 + ((payload_bytes)*8 + 11)/12*11 + 7)/8)
+
 int horus_l2_get_num_tx_data_bytes(int num_payload_data_bytes);
 
 /* returns number of output bytes in output_tx_data */
@@ -0,0 +1,273 @@
+/*
+i2c_dma.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "i2c_dma.h"
+
+struct i2c_dma_job
+{
+  DmacDescriptor link; // Descriptor for the data after the prefix, so it must stay first (16-byte aligned)
+  uint8_t *data;
+  i2c_dma_callback callback;
+  void *context;
+  uint8_t address;
+  uint8_t length;
+  uint8_t prefix_length;
+  bool read;
+  uint8_t prefix[I2C_DMA_PREFIX];
+} __attribute__((aligned(16)));
+
+// Jobs run in order from tail to head
+static i2c_dma_job queue[I2C_DMA_QUEUE];
+static uint8_t queue_head = 0;
+static uint8_t queue_tail = 0;
+static uint8_t queue_count = 0;
+
+static bool active = false;
+static uint32_t started_ms = 0;
+static i2c_dma_stats stats;
+
+// Sets up a descriptor that feeds bytes into the SERCOM data register
+static void i2c_dma_describe_tx(DmacDescriptor *descriptor, const uint8_t *source, uint8_t length, DmacDescriptor *next)
+{
+  descriptor->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_SRCINC;
+  descriptor->BTCNT.reg = length;
+  descriptor->SRCADDR.reg = (uint32_t)(source + length); // The DMAC wants the end address when incrementing
+  descriptor->DSTADDR.reg = (uint32_t)&I2C_DMA_SERCOM->I2CM.DATA.reg;
+  descriptor->DESCADDR.reg = (uint32_t)next;
+}
+
+static void i2c_dma_start(i2c_dma_job *job)
+{
+  DmacDescriptor *first = dmac_descriptor(DMAC_CHANNEL_I2C);
+  uint8_t total = job->prefix_length + job->length;
+
+  if (job->read)
+  {
+    first->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_DSTINC;
+    first->BTCNT.reg = job->length;
+    first->SRCADDR.reg = (uint32_t)&I2C_DMA_SERCOM->I2CM.DATA.reg;
+    first->DSTADDR.reg = (uint32_t)(job->data + job->length);
+    first->DESCADDR.reg = 0;
+  }
+  else if (job->prefix_length)
+  {
+    // Prefix from the job itself, then the caller's data from a linked descriptor
+    i2c_dma_describe_tx(first, job->prefix, job->prefix_length, job->length ? &job->link : NULL);
+    if (job->length)
+    {
+      i2c_dma_describe_tx(&job->link, job->data, job->length, NULL);
+    }
+  }
+  else
+  {
+    i2c_dma_describe_tx(first, job->data, job->length, NULL);
+  }
+
+  dmac_start(DMAC_CHANNEL_I2C, job->read ? I2C_DMA_TRIGGER_RX : I2C_DMA_TRIGGER_TX);
+
+  // Writing ADDR sends the START and address. With LENEN the SERCOM ends the transaction itself.
+  I2C_DMA_SERCOM->I2CM.ADDR.reg = SERCOM_I2CM_ADDR_ADDR((job->address << 1) | job->read) |
+                                  SERCOM_I2CM_ADDR_LENEN | SERCOM_I2CM_ADDR_LEN(total);
+  while (I2C_DMA_SERCOM->I2CM.SYNCBUSY.bit.SYSOP)
+    ;
+
+  started_ms = millis();
+  active = true;
+}
+
+// Takes the next free job, waiting for room if the queue is full
+static i2c_dma_job *i2c_dma_reserve(uint8_t jobs)
+{
+  while (queue_count > I2C_DMA_QUEUE - jobs)
+  {
+    i2c_dma_service();
+  }
+  i2c_dma_job *job = &queue[queue_head];
+  memset(job, 0, sizeof(*job));
+  return job;
+}
+
+static void i2c_dma_push()
+{
+  queue_head = (queue_head + 1) % I2C_DMA_QUEUE;
+  queue_count++;
+  if (!active)
+  {
+    i2c_dma_start(&queue[queue_tail]);
+  }
+}
+
+void i2c_dma_begin()
+{
+  Wire.begin(); // Pin muxing and master mode, with smart mode on so DMA reads ACK by themselves
+  Wire.setClock(I2C_DMA_CLOCK);
+  dmac_begin();
+}
+
+// Queues a write of prefix then data in one transaction. The prefix is copied, data must stay
+// untouched until the job is done.
+bool i2c_dma_write(uint8_t address, const uint8_t *prefix, uint8_t prefix_length, const uint8_t *data, uint8_t length,
+                   i2c_dma_callback callback, void *context)
+{
+  if (prefix_length > I2C_DMA_PREFIX || prefix_length + length == 0 || prefix_length + length > 255)
+  {
+    return false;
+  }
+  i2c_dma_job *job = i2c_dma_reserve(1);
+  job->address = address;
+  memcpy(job->prefix, prefix, prefix_length);
+  job->prefix_length = prefix_length;
+  job->data = (uint8_t *)data;
+  job->length = length;
+  job->callback = callback;
+  job->context = context;
+  i2c_dma_push();
+  return true;
+}
+
+bool i2c_dma_read(uint8_t address, uint8_t *data, uint8_t length, i2c_dma_callback callback, void *context)
+{
+  if (length == 0)
+  {
+    return false;
+  }
+  i2c_dma_job *job = i2c_dma_reserve(1);
+  job->address = address;
+  job->read = true;
+  job->data = data;
+  job->length = length;
+  job->callback = callback;
+  job->context = context;
+  i2c_dma_push();
+  return true;
+}
+
+// Sets the register pointer, then reads length bytes from there. The callback comes after the read.
+bool i2c_dma_read_register(uint8_t address, uint8_t reg, uint8_t *data, uint8_t length,
+                           i2c_dma_callback callback, void *context)
+{
+  if (length == 0)
+  {
+    return false;
+  }
+  // Both halves go in together so nothing else can land between them
+  i2c_dma_reserve(2);
+  i2c_dma_write(address, &reg, 1, NULL, 0);
+  return i2c_dma_read(address, data, length, callback, context);
+}
+
+// Sends just the address and checks for an ACK, with a short timeout. Runs outside the queue,
+// so it empties the queue first.
+bool i2c_dma_probe(uint8_t address)
+{
+  i2c_dma_flush();
+
+  SercomI2cm *i2c = &I2C_DMA_SERCOM->I2CM;
+  i2c->ADDR.reg = SERCOM_I2CM_ADDR_ADDR(address << 1);
+  while (i2c->SYNCBUSY.bit.SYSOP)
+    ;
+
+  bool answered = false;
+  uint32_t start = micros();
+  while (micros() - start < I2C_DMA_PROBE_TIMEOUT_US)
+  {
+    if (i2c->INTFLAG.reg & (SERCOM_I2CM_INTFLAG_MB | SERCOM_I2CM_INTFLAG_SB | SERCOM_I2CM_INTFLAG_ERROR))
+    {
+      answered = !i2c->STATUS.bit.RXNACK && !i2c->INTFLAG.bit.ERROR;
+      break;
+    }
+  }
+
+  i2c->CTRLB.bit.CMD = 3; // STOP
+  while (i2c->SYNCBUSY.bit.SYSOP)
+    ;
+  i2c->STATUS.reg = SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_ARBLOST | SERCOM_I2CM_STATUS_LOWTOUT;
+  i2c->INTFLAG.reg = SERCOM_I2CM_INTFLAG_ERROR;
+  return answered;
+}
+
+// Finishes the running job if it is done, and starts the next one
+void i2c_dma_service()
+{
+  if (!active)
+  {
+    return;
+  }
+
+  SercomI2cm *i2c = &I2C_DMA_SERCOM->I2CM;
+  bool failed = i2c->INTFLAG.bit.ERROR || (i2c->INTFLAG.bit.MB && i2c->STATUS.bit.RXNACK) ||
+                dmac_error(DMAC_CHANNEL_I2C) || millis() - started_ms > I2C_DMA_TIMEOUT;
+  bool finished = dmac_done(DMAC_CHANNEL_I2C) && i2c->STATUS.bit.BUSSTATE == 1; // Idle after the STOP
+  if (!failed && !finished)
+  {
+    return;
+  }
+
+  i2c_dma_job *job = &queue[queue_tail];
+  if (finished)
+  {
+    stats.jobs++;
+    stats.bytes += job->prefix_length + job->length;
+  }
+  else
+  {
+    // Release the bus and clear the error bits
+    dmac_stop(DMAC_CHANNEL_I2C);
+    i2c->CTRLB.bit.CMD = 3;
+    while (i2c->SYNCBUSY.bit.SYSOP)
+      ;
+    i2c->STATUS.reg = SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_ARBLOST | SERCOM_I2CM_STATUS_LOWTOUT;
+    i2c->INTFLAG.reg = SERCOM_I2CM_INTFLAG_ERROR;
+    stats.errors++;
+  }
+
+  i2c_dma_callback callback = job->callback;
+  void *context = job->context;
+  queue_tail = (queue_tail + 1) % I2C_DMA_QUEUE;
+  queue_count--;
+  active = false;
+
+  // Keep the bus busy before handing the result over
+  if (queue_count)
+  {
+    i2c_dma_start(&queue[queue_tail]);
+  }
+  if (callback)
+  {
+    callback(finished, context);
+  }
+}
+
+// Runs the queue until it is empty
+void i2c_dma_flush()
+{
+  while (queue_count)
+  {
+    i2c_dma_service();
+  }
+}
+
+bool i2c_dma_idle()
+{
+  return queue_count == 0;
+}
+
+const i2c_dma_stats *i2c_dma_get_stats()
+{
+  return &stats;
+}
@@ -0,0 +1,72 @@
+/*
+i2c_dma.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// ASYNCHRONOUS I2C
+// Queues I2C transactions and runs them on the Wire SERCOM with DMA, so the CPU does not wait on
+// the bus. Each job is a single transaction with the length set in ADDR.LEN, so the SERCOM sends
+// the STOP (and NACKs the last byte of a read) by itself.
+// i2c_dma_service() moves the queue along and runs completion callbacks. It is called from the
+// gpsFeed scheduler task, so callbacks run there and not in an interrupt.
+// Wire shares the same SERCOM: call i2c_dma_flush() before using Wire directly.
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "dmac.h"
+
+// SERCOM behind Wire on the Arduino Zero pinout (SDA PA22, SCL PA23)
+#define I2C_DMA_SERCOM SERCOM3
+#define I2C_DMA_TRIGGER_TX SERCOM3_DMAC_ID_TX
+#define I2C_DMA_TRIGGER_RX SERCOM3_DMAC_ID_RX
+
+// Bus speed. The BME280, SSD1306 and MPU-6050 all run at 400 kHz.
+#define I2C_DMA_CLOCK 400000
+
+// Jobs that can be waiting at once. A full OLED refresh of a 128x32 panel is 8 jobs.
+#define I2C_DMA_QUEUE 12
+
+// Bytes that are copied into the job and sent ahead of the data, such as a control or register byte
+#define I2C_DMA_PREFIX 8
+
+// Give up on a transaction after this many milliseconds
+#define I2C_DMA_TIMEOUT 20
+
+// Wait this long for a device to answer its address when probing
+#define I2C_DMA_PROBE_TIMEOUT_US 500
+
+// ok is false if the device did not answer or the bus failed
+typedef void (*i2c_dma_callback)(bool ok, void *context);
+
+struct i2c_dma_stats
+{
+  uint32_t jobs;   // Transactions finished
+  uint32_t errors; // Transactions that failed or timed out
+  uint32_t bytes;  // Bytes moved, address bytes not included
+};
+
+void i2c_dma_begin();
+bool i2c_dma_write(uint8_t address, const uint8_t *prefix, uint8_t prefix_length, const uint8_t *data, uint8_t length,
+                   i2c_dma_callback callback = NULL, void *context = NULL);
+bool i2c_dma_read(uint8_t address, uint8_t *data, uint8_t length, i2c_dma_callback callback = NULL, void *context = NULL);
+bool i2c_dma_read_register(uint8_t address, uint8_t reg, uint8_t *data, uint8_t length,
+                           i2c_dma_callback callback = NULL, void *context = NULL);
+bool i2c_dma_probe(uint8_t address);
+void i2c_dma_service();
+void i2c_dma_flush();
+bool i2c_dma_idle();
+const i2c_dma_stats *i2c_dma_get_stats();
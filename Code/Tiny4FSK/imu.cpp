@@ -0,0 +1,279 @@
+/*
+imu.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "imu.h"
+
+#define IMU_REG_SMPLRT_DIV 0x19
+#define IMU_REG_CONFIG 0x1A
+#define IMU_REG_GYRO_CONFIG 0x1B
+#define IMU_REG_ACCEL_CONFIG 0x1C
+#define IMU_REG_FIFO_EN 0x23
+#define IMU_REG_USER_CTRL 0x6A
+#define IMU_REG_PWR_MGMT_1 0x6B
+#define IMU_REG_FIFO_COUNT 0x72
+#define IMU_REG_FIFO_R_W 0x74
+#define IMU_REG_WHO_AM_I 0x75
+
+#define IMU_WHO_AM_I 0x68
+#define IMU_FIFO_SIZE 1024
+#define IMU_SAMPLE_BYTES 12                                      // Accel XYZ then gyro XYZ, big endian
+#define IMU_BURST_SAMPLES (255 / IMU_SAMPLE_BYTES)               // Most samples in one I2C read
+#define IMU_DLPF_10HZ 5                                          // Low pass filter below half the sample rate
+#define IMU_ACCEL_16G 0x18                                       // 2048 LSB per g
+#define IMU_GYRO_2000DPS 0x18                                    // 16.4 LSB per degree per second
+#define IMU_MEAN_SHIFT 4                                         // Running mean time constant, 16 samples
+
+static_assert(IMU_SLEEP_MAX_MS < 1000UL * IMU_FIFO_SIZE / IMU_SAMPLE_BYTES / IMU_RATE_HZ,
+              "The FIFO must not fill up during one piece of a deep sleep");
+
+enum imu_state
+{
+  IMU_IDLE,
+  IMU_COUNTING,
+  IMU_READING
+};
+
+static uint8_t imu_address = 0;
+static imu_state state = IMU_IDLE;
+static uint32_t last_drain_ms = 0;
+static uint16_t fifo_left = 0;
+static uint8_t fifo_count[2];
+static uint8_t burst[IMU_BURST_SAMPLES * IMU_SAMPLE_BYTES];
+
+// Filter state and the running totals for the summary
+static int32_t mean_q8 = 0; // Running mean of the acceleration magnitude, raw units * 256
+static bool mean_valid = false;
+static uint16_t samples = 0;
+static uint32_t peak = 0;
+static uint64_t vibration_sum = 0;
+static int32_t spin_sum = 0;
+static imu_stats stats;
+
+static void imu_write_register(uint8_t reg, uint8_t value)
+{
+  const uint8_t command[] = {reg, value};
+  i2c_dma_write(imu_address, command, sizeof(command), NULL, 0);
+}
+
+static uint32_t isqrt(uint32_t n)
+{
+  uint32_t root = 0;
+  uint32_t bit = 1UL << 30;
+  while (bit > n)
+  {
+    bit >>= 2;
+  }
+  while (bit)
+  {
+    if (n >= root + bit)
+    {
+      n -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else
+    {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+// Raw accelerometer units (2048 per g) to milli-g
+static inline uint32_t imu_raw_to_mg(uint32_t raw)
+{
+  return (raw * 125) >> 8;
+}
+
+static void imu_add_sample(const uint8_t *sample)
+{
+  int32_t ax = (int16_t)((sample[0] << 8) | sample[1]);
+  int32_t ay = (int16_t)((sample[2] << 8) | sample[3]);
+  int32_t az = (int16_t)((sample[4] << 8) | sample[5]);
+  int32_t gz = (int16_t)((sample[10] << 8) | sample[11]);
+
+  // Total acceleration, so the result does not depend on how the payload hangs
+  uint32_t magnitude = isqrt((uint32_t)(ax * ax) + (uint32_t)(ay * ay) + (uint32_t)(az * az));
+  if (magnitude > peak)
+  {
+    peak = magnitude;
+  }
+
+  // Vibration is what is left after taking out the slowly changing part (gravity and swinging)
+  if (!mean_valid)
+  {
+    mean_q8 = magnitude << 8;
+    mean_valid = true;
+  }
+  mean_q8 += ((int32_t)(magnitude << 8) - mean_q8) >> IMU_MEAN_SHIFT;
+  int32_t ac = (int32_t)magnitude - (mean_q8 >> 8);
+  vibration_sum += (uint32_t)(ac * ac);
+
+  spin_sum += gz;
+  samples++;
+  stats.samples++;
+}
+
+static void imu_read_burst();
+
+static void imu_burst_done(bool ok, void *context)
+{
+  uint16_t count = (uint16_t)(uintptr_t)context;
+  if (!ok)
+  {
+    stats.errors++;
+    state = IMU_IDLE;
+    return;
+  }
+  for (uint16_t i = 0; i < count; i++)
+  {
+    imu_add_sample(&burst[i * IMU_SAMPLE_BYTES]);
+  }
+  stats.bursts++;
+  imu_read_burst();
+}
+
+// Reads the next burst of whole samples, or finishes the drain
+static void imu_read_burst()
+{
+  uint16_t count = fifo_left / IMU_SAMPLE_BYTES;
+  if (count == 0)
+  {
+    state = IMU_IDLE;
+    return;
+  }
+  if (count > IMU_BURST_SAMPLES)
+  {
+    count = IMU_BURST_SAMPLES;
+  }
+  fifo_left -= count * IMU_SAMPLE_BYTES;
+  i2c_dma_read_register(imu_address, IMU_REG_FIFO_R_W, burst, count * IMU_SAMPLE_BYTES, imu_burst_done,
+                        (void *)(uintptr_t)count);
+}
+
+static void imu_count_done(bool ok, void *context)
+{
+  if (!ok)
+  {
+    stats.errors++;
+    state = IMU_IDLE;
+    return;
+  }
+  uint16_t count = (fifo_count[0] << 8) | fifo_count[1];
+  if (count >= IMU_FIFO_SIZE)
+  {
+    // Full, so samples were dropped and the byte alignment is lost. Start again.
+    stats.overflows++;
+    imu_write_register(IMU_REG_USER_CTRL, 0x44); // FIFO_EN | FIFO_RESET
+    state = IMU_IDLE;
+    return;
+  }
+  fifo_left = count;
+  state = IMU_READING;
+  imu_read_burst();
+}
+
+static void imu_start_drain()
+{
+  state = IMU_COUNTING;
+  last_drain_ms = millis();
+  i2c_dma_read_register(imu_address, IMU_REG_FIFO_COUNT, fifo_count, 2, imu_count_done, NULL);
+}
+
+bool imu_begin(uint8_t address)
+{
+  uint8_t id = 0;
+  bool ok = false;
+  imu_address = address;
+  i2c_dma_read_register(address, IMU_REG_WHO_AM_I, &id, 1, [](bool result, void *context)
+                        { *(bool *)context = result; }, &ok);
+  i2c_dma_flush();
+  if (!ok || id != IMU_WHO_AM_I)
+  {
+    imu_address = 0;
+    return false;
+  }
+
+  imu_write_register(IMU_REG_PWR_MGMT_1, 0x80); // Reset
+  i2c_dma_flush();
+  delay(100);
+  imu_write_register(IMU_REG_PWR_MGMT_1, 0x01);                    // Awake, clocked from the X gyro
+  imu_write_register(IMU_REG_CONFIG, IMU_DLPF_10HZ);                // Internal rate is now 1 kHz
+  imu_write_register(IMU_REG_SMPLRT_DIV, 1000 / IMU_RATE_HZ - 1);
+  imu_write_register(IMU_REG_GYRO_CONFIG, IMU_GYRO_2000DPS);
+  imu_write_register(IMU_REG_ACCEL_CONFIG, IMU_ACCEL_16G);
+  imu_write_register(IMU_REG_FIFO_EN, 0x78);                        // Accel and all three gyro axes
+  imu_write_register(IMU_REG_USER_CTRL, 0x44);                      // FIFO_EN | FIFO_RESET
+  i2c_dma_flush();
+
+  state = IMU_IDLE;
+  last_drain_ms = millis();
+  return true;
+}
+
+// Drains the FIFO every IMU_DRAIN_MS. Called from the gpsFeed task.
+void imu_service()
+{
+  if (imu_address && state == IMU_IDLE && millis() - last_drain_ms >= IMU_DRAIN_MS)
+  {
+    imu_start_drain();
+  }
+}
+
+// Reads everything in the FIFO right now, for the packet builder
+void imu_drain()
+{
+  if (!imu_address)
+  {
+    return;
+  }
+  while (state != IMU_IDLE)
+  {
+    i2c_dma_service();
+    yield();
+  }
+  imu_start_drain();
+  while (state != IMU_IDLE)
+  {
+    i2c_dma_service();
+    yield();
+  }
+}
+
+// Summary of the samples since the last call, then starts a new one
+void imu_take_summary(imu_summary *summary)
+{
+  memset(summary, 0, sizeof(*summary));
+  if (samples)
+  {
+    uint32_t peak_mg = imu_raw_to_mg(peak);
+    summary->samples = samples;
+    summary->peak_accel_mg = peak_mg > UINT16_MAX ? UINT16_MAX : peak_mg;
+    summary->vibration_mg = imu_raw_to_mg(isqrt(vibration_sum / samples));
+    summary->spin_dps = (spin_sum * 10) / (164 * (int32_t)samples); // 16.4 LSB per degree per second
+  }
+  samples = 0;
+  peak = 0;
+  vibration_sum = 0;
+  spin_sum = 0;
+}
+
+const imu_stats *imu_get_stats()
+{
+  return &stats;
+}
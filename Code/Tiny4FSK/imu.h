@@ -0,0 +1,61 @@
+/*
+imu.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// IMU DRIVER
+// MPU-6050 style IMU on the shield. The sensor samples accelerometer and gyro at a fixed rate into
+// its own 1 KB FIFO, so the MCU is not woken for every sample. The FIFO is drained in bursts
+// through the i2c_dma queue, about once a second from the gpsFeed task, again at packet time, and
+// between the pieces of a deep sleep longer than IMU_SLEEP_MAX_MS (power.cpp).
+// Each sample goes through an integer filter chain, and the packet builder takes a summary of
+// everything since the last packet.
+// The spin rate is about the sensor's Z axis, which points up when the shield is mounted flat.
+#pragma once
+
+#include <Arduino.h>
+#include "i2c_dma.h"
+
+// Sample rate. The FIFO holds 85 samples, so it has to be drained at least every 3.4 s.
+#define IMU_RATE_HZ 25
+
+// Drain the FIFO this often between packets
+#define IMU_DRAIN_MS 1000
+
+// Longest the MCU may sleep without draining it, with room to spare before it fills
+#define IMU_SLEEP_MAX_MS 2500
+
+struct imu_summary
+{
+  uint16_t samples;         // Samples behind this summary
+  uint16_t peak_accel_mg;   // Largest total acceleration
+  uint16_t vibration_mg;    // RMS of the total acceleration around its running mean
+  int16_t spin_dps;         // Mean rotation rate about Z, degrees per second
+};
+
+struct imu_stats
+{
+  uint32_t samples;   // Samples read since boot
+  uint32_t bursts;    // FIFO reads
+  uint32_t overflows; // Times the FIFO filled up and samples were lost
+  uint32_t errors;    // Failed I2C transfers
+};
+
+bool imu_begin(uint8_t address);
+void imu_service();
+void imu_drain();
+void imu_take_summary(imu_summary *summary);
+const imu_stats *imu_get_stats();
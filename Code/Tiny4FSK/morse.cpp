@@ -17,57 +17,207 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include "morse.h"
+#include "clock.h"
 
-// Morse code definitions
-const char* morseTable[36] = {
-  ".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..", ".---",                    // A-J
-  "-.-", ".-..", "--", "-.", "---", ".--.", "--.-", ".-.", "...", "-",                      // K-T
-  "..-", "...-", ".--", "-..-", "-.--", "--..",                                             // U-Z
-  "-----", ".----", "..---", "...--", "....-", ".....", "-....", "--...", "---..", "----."  // 0-9
+// Morse code definitions: A-Z, 0-9, then /
+constexpr const char *morse_table[37] = {
+    ".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..", ".---",                   // A-J
+    "-.-", ".-..", "--", "-.", "---", ".--.", "--.-", ".-.", "...", "-",                     // K-T
+    "..-", "...-", ".--", "-..-", "-.--", "--..",                                            // U-Z
+    "-----", ".----", "..---", "...--", "....-", ".....", "-....", "--...", "---..", "----.", // 0-9
+    "-..-."};                                                                                // /
+
+// The schedule is built by the compiler, so everything down to morse_run() has to be a C++11
+// constexpr function: a single return statement, with recursion instead of loops.
+
+// Index into morse_table, or -1 for a character without a code (those are skipped)
+constexpr int morse_index(char c)
+{
+  return c >= 'A' && c <= 'Z'   ? c - 'A'
+         : c >= 'a' && c <= 'z' ? c - 'a'
+         : c >= '0' && c <= '9' ? c - '0' + 26
+         : c == '/'             ? 36
+                                : -1;
+}
+
+constexpr const char *morse_code(char c)
+{
+  return morse_index(c) < 0 ? "" : morse_table[morse_index(c)];
+}
+
+constexpr unsigned morse_length(const char *code)
+{
+  return *code ? 1 + morse_length(code + 1) : 0;
+}
+
+// Dots and dashes in the whole string
+constexpr unsigned morse_elements(const char *s)
+{
+  return *s ? morse_length(morse_code(*s)) + morse_elements(s + 1) : 0;
+}
+
+// Whether a space comes before the next character with a code
+constexpr bool morse_space_next(const char *s)
+{
+  return *s == ' ' ? true : (!*s || morse_index(*s) >= 0) ? false : morse_space_next(s + 1);
+}
+
+// Length in dots of element k of the string, and of the gap after it
+constexpr uint8_t morse_element(const char *s, unsigned k)
+{
+  return k < morse_length(morse_code(*s)) ? (morse_code(*s)[k] == '-' ? 3 : 1)
+                                          : morse_element(s + 1, k - morse_length(morse_code(*s)));
+}
+
+constexpr uint8_t morse_gap(const char *s, unsigned k)
+{
+  return k + 1 < morse_length(morse_code(*s))    ? 1
+         : k + 1 == morse_length(morse_code(*s)) ? (morse_space_next(s + 1) ? 7 : 3)
+                                                 : morse_gap(s + 1, k - morse_length(morse_code(*s)));
+}
+
+// Even runs are the elements (key down), odd runs the gaps between them (key up)
+constexpr uint8_t morse_run(const char *s, unsigned i)
+{
+  return i % 2 == 0 ? morse_element(s, i / 2) : morse_gap(s, i / 2);
+}
+
+#define MORSE_RUNS (2 * morse_elements(CALLSIGN) - 1)
+static_assert(morse_elements(CALLSIGN) > 0, "CALLSIGN has nothing that can be sent in Morse");
+
+// Expands to morse_run(CALLSIGN, 0), morse_run(CALLSIGN, 1), ... in an array initializer
+template <unsigned... I>
+struct morse_indices
+{
+};
+
+template <unsigned N, unsigned... I>
+struct morse_make_indices : morse_make_indices<N - 1, N - 1, I...>
+{
+};
+
+template <unsigned... I>
+struct morse_make_indices<0, I...>
+{
+  typedef morse_indices<I...> type;
 };
 
-// Function to send a Morse code character
-void sendMorseChar(char c) {
-  if (c >= 'A' && c <= 'Z') {
-    const char* morse = morseTable[c - 'A'];
-    while (*morse) {
-      if (*morse == '.') {
-        si4063_enable_tx();
-        delay(DOT_DURATION);
-      } else if (*morse == '-') {
-        si4063_enable_tx();
-        delay(DASH_DURATION);
-      }
-      si4063_inhibit_tx();
-      morse++;
-      if (*morse) delay(SPACE_DURATION);
+template <typename Indices>
+struct morse_schedule;
+
+template <unsigned... I>
+struct morse_schedule<morse_indices<I...>>
+{
+  static constexpr uint8_t runs[sizeof...(I)] = {morse_run(CALLSIGN, I)...};
+};
+
+template <unsigned... I>
+constexpr uint8_t morse_schedule<morse_indices<I...>>::runs[sizeof...(I)];
+
+typedef morse_schedule<morse_make_indices<MORSE_RUNS>::type> callsign;
+
+static volatile uint16_t next_run = 0;
+static volatile bool keying = false;
+static morse_stats stats;
+
+// Changes the radio state and waits for the Si4063 to take it
+static void morse_key(bool down)
+{
+  uint32_t start = clock_micros();
+  si4063_set_state(down ? SI4063_STATE_TX : SI4063_STATE_READY);
+  si4063_wait_for_cts();
+  uint32_t latency = clock_micros() - start;
+  if (down)
+  {
+    stats.key_down_us = latency;
+    if (latency > stats.key_down_max_us)
+    {
+      stats.key_down_max_us = latency;
     }
-  } else if (c >= '0' && c <= '9') {
-    const char* morse = morseTable[c - '0' + 26];
-    while (*morse) {
-      if (*morse == '.') {
-        si4063_enable_tx();
-        delay(DOT_DURATION);
-      } else if (*morse == '-') {
-        si4063_enable_tx();
-        delay(DASH_DURATION);
-      }
-      si4063_inhibit_tx();
-      morse++;
-      if (*morse) delay(SPACE_DURATION);
+  }
+  else
+  {
+    stats.key_up_us = latency;
+    if (latency > stats.key_up_max_us)
+    {
+      stats.key_up_max_us = latency;
     }
   }
 }
 
-// Function to send a Morse code string
-void sendMorseString(const char* str) {
-  while (*str) {
-    if (*str == ' ') {
-      delay(WORD_SPACE_DURATION);
-    } else {
-      sendMorseChar(toupper(*str));
-      delay(LETTER_SPACE_DURATION);
-    }
-    str++;
+// Start of each run. The length of the run is loaded first, so the next edge does not depend on
+// how long the radio takes.
+void TC3_Handler()
+{
+  TC3->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+  uint16_t run = next_run;
+  if (run < MORSE_RUNS)
+  {
+    TC3->COUNT16.CC[0].reg = callsign::runs[run] * MORSE_DOT_TICKS - 1;
+    next_run = run + 1;
+    morse_key(run % 2 == 0);
+  }
+  else
+  {
+    // The last element is over
+    TC3->COUNT16.CTRLA.bit.ENABLE = 0;
+    morse_key(false);
+    stats.callsigns++;
+    keying = false;
   }
 }
+
+// TC3 counts the crystal (GCLK1, set up by clock_begin()) and restarts at CC0, the length of the run
+void morse_begin()
+{
+  PM->APBCMASK.reg |= PM_APBCMASK_TC3;
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_TCC2_TC3 | GCLK_CLKCTRL_GEN_GCLK1 | GCLK_CLKCTRL_CLKEN;
+  while (GCLK->STATUS.bit.SYNCBUSY)
+    ;
+
+  TC3->COUNT16.CTRLA.reg = TC_CTRLA_SWRST;
+  while (TC3->COUNT16.CTRLA.bit.SWRST)
+    ;
+  TC3->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER_DIV1;
+  TC3->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+  NVIC_EnableIRQ(TC3_IRQn);
+}
+
+// Starts sending the callsign and returns straight away. The radio needs to be in READY.
+void morse_start()
+{
+  if (keying)
+  {
+    return;
+  }
+  next_run = 0;
+  keying = true;
+
+  // The first edge comes two ticks from now
+  TC3->COUNT16.COUNT.reg = 0;
+  TC3->COUNT16.CC[0].reg = 1;
+  while (TC3->COUNT16.STATUS.bit.SYNCBUSY)
+    ;
+  TC3->COUNT16.CTRLA.bit.ENABLE = 1;
+  while (TC3->COUNT16.STATUS.bit.SYNCBUSY)
+    ;
+}
+
+bool morse_busy()
+{
+  return keying;
+}
+
+// Yields to the other tasks until the callsign is out
+void morse_wait()
+{
+  while (keying)
+  {
+    yield();
+  }
+}
+
+const morse_stats *morse_get_stats()
+{
+  return &stats;
+}
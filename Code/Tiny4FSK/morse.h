@@ -17,6 +17,14 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 // Morse Code callsign sending routines
+// CALLSIGN is turned into a keying schedule at compile time: runs of key down and key up, counted in
+// dots, starting and ending with key down. TC3 plays the schedule out on the 32.768 kHz crystal, and its
+// interrupt changes the Si4063 between READY and TX at the start of each run, so GPS data and the packet
+// build carry on while the callsign goes out. Run lengths are counted from timer edge to timer edge, so
+// the time the radio takes to change state never adds up over the callsign. That time is measured for
+// every key down and key up, and kept in morse_stats.
+// The interrupt talks to the radio over the SPI bus, which the SD card shares. Nothing else may use the
+// bus while morse_busy(), so the SD writers hold off and the packet waits for morse_wait().
 
 #pragma once
 
@@ -31,5 +39,21 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #define LETTER_SPACE_DURATION (3 * DOT_DURATION)
 #define WORD_SPACE_DURATION (7 * DOT_DURATION)
 
-void sendMorseChar(char c);
-void sendMorseString(const char *s);
\ No newline at end of file
+// One dot in 32.768 kHz timer ticks. The longest run, a word space, has to fit in the 16-bit timer.
+#define MORSE_DOT_TICKS ((1200UL * 32768 / CALLSIGN_WPM + 500) / 1000)
+static_assert(7 * MORSE_DOT_TICKS <= 65536, "CALLSIGN_WPM must be at least 5");
+
+struct morse_stats
+{
+  uint32_t callsigns;       // Callsigns sent
+  uint32_t key_down_us;     // Last key down, from the timer interrupt until the Si4063 took the command
+  uint32_t key_down_max_us;
+  uint32_t key_up_us;       // Same for the last key up
+  uint32_t key_up_max_us;
+};
+
+void morse_begin();
+void morse_start();
+bool morse_busy();
+void morse_wait();
+const morse_stats *morse_get_stats();
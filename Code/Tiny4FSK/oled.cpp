@@ -18,96 +18,173 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "oled.h"
 #include "font.h"
+#include "fixed_format.h"
+#include "i2c_dma.h"
+#include "energy.h"
+#include "profile.h"
 
 // Module-level variables
 static int16_t _width;
 static int16_t _height;
-static uint8_t *buffer = NULL;
+static uint8_t buffer[OLED_BUFFER_BYTES];
+static uint8_t shadow[OLED_BUFFER_BYTES]; // What the panel is showing right now
+static bool shadow_valid = false;
+static uint16_t bytes_sent = 0;
+static uint8_t pages_pending = 0; // Page transfers queued and not finished yet
+static uint8_t init_commands[32]; // Sent from here by DMA, so it has to outlive oled_begin()
 static uint8_t textSize = 1;
 static uint16_t textColor = 1;
 static int16_t cursor_x = 0;
 static int16_t cursor_y = 0;
 
+// Dirty column range of each page (8 pixel rows). dirty_min > dirty_max means the page is clean.
+#define OLED_MAX_PAGES (OLED_MAX_HEIGHT / 8)
+static uint8_t dirty_min[OLED_MAX_PAGES];
+static uint8_t dirty_max[OLED_MAX_PAGES];
+
 // Forward declarations for local functions
-static void sendCommand(uint8_t cmd);
+static void markDirty(uint8_t page, uint8_t x);
+static void markClean();
+static void sendCommands(const uint8_t *cmds, uint8_t count);
+static void pageSent(bool ok, void *context);
+static void blitColumn(int16_t x, int16_t y, uint32_t bits, uint16_t color);
 static void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint8_t size);
 
 bool oled_begin(int16_t width, int16_t height, uint8_t i2c_addr)
 {
+    // The framebuffers are static, sized for the largest panel in oled.h
+    if (width > OLED_MAX_WIDTH || height > OLED_MAX_HEIGHT)
+    {
+        return false;
+    }
     _width = width;
     _height = height;
-    if ((buffer = (uint8_t *)malloc(_width * _height / 8)))
-    {
-        //Wire.begin();
-        memset(buffer, 0, _width * _height / 8);
-        sendCommand(0xAE); // Display Off
-        sendCommand(0xD5); // Set Display Clock Divide Ratio/Oscillator Frequency
-        sendCommand(0x80);
-        sendCommand(0xA8); // Set MUX Ratio
-        sendCommand(height - 1);
-        sendCommand(0xD3); // Set Display Offset
-        sendCommand(0x00);
-        sendCommand(0x40); // Set Display Start Line
-        sendCommand(0x8D); // Charge Pump Setting
-        sendCommand(0x14); // Enable Charge Pump
-        sendCommand(0x20); // Memory Addressing Mode
-        sendCommand(0x00); // Horizontal Addressing Mode
-        sendCommand(0xA1); // Set Segment Re-map
-        sendCommand(0xC8); // Set COM Output Scan Direction
-        sendCommand(0xDA); // Set COM Pins Hardware Configuration
-        if (height == 32)
-        {
-            sendCommand(0x02);
-        }
-        else
-        {
-            sendCommand(0x12);
-        }
-        sendCommand(0x81); // Contrast Control
-        sendCommand(0xCF);
-        sendCommand(0xD9); // Set Pre-charge Period
-        sendCommand(0xF1);
-        sendCommand(0xDB); // Set VCOMH Deselect Level
-        sendCommand(0x40);
-        sendCommand(0xA4); // Display ON
-        sendCommand(0xA6); // Normal Display
-        sendCommand(0xAF); // Display On
-        return true;
-    }
-    return false;
+    //Wire.begin();
+    memset(buffer, 0, _width * _height / 8);
+    // Panel RAM is random after power up, so the first refresh sends everything
+    shadow_valid = false;
+    markClean();
+    // The whole setup goes out as one command list
+    uint8_t *cmd = init_commands;
+    uint8_t n = 0;
+    cmd[n++] = 0xAE; // Display Off
+    cmd[n++] = 0xD5; // Set Display Clock Divide Ratio/Oscillator Frequency
+    cmd[n++] = 0x80;
+    cmd[n++] = 0xA8; // Set MUX Ratio
+    cmd[n++] = height - 1;
+    cmd[n++] = 0xD3; // Set Display Offset
+    cmd[n++] = 0x00;
+    cmd[n++] = 0x40; // Set Display Start Line
+    cmd[n++] = 0x8D; // Charge Pump Setting
+    cmd[n++] = 0x14; // Enable Charge Pump
+    cmd[n++] = 0x20; // Memory Addressing Mode
+    cmd[n++] = 0x00; // Horizontal Addressing Mode
+    cmd[n++] = 0xA1; // Set Segment Re-map
+    cmd[n++] = 0xC8; // Set COM Output Scan Direction
+    cmd[n++] = 0xDA; // Set COM Pins Hardware Configuration
+    cmd[n++] = height == 32 ? 0x02 : 0x12;
+    cmd[n++] = 0x81; // Contrast Control
+    cmd[n++] = 0xCF;
+    cmd[n++] = 0xD9; // Set Pre-charge Period
+    cmd[n++] = 0xF1;
+    cmd[n++] = 0xDB; // Set VCOMH Deselect Level
+    cmd[n++] = 0x40;
+    cmd[n++] = 0xA4; // Display ON
+    cmd[n++] = 0xA6; // Normal Display
+    cmd[n++] = 0xAF; // Display On
+    sendCommands(init_commands, n);
+    energy_set(ENERGY_OLED_ON);
+    return true;
+}
+
+// Switches the panel and its charge pump off (false) or back on (true). The picture is kept.
+void oled_power(bool on)
+{
+    static const uint8_t off_commands[] = {0xAE, 0x8D, 0x10}; // Display Off, Charge Pump Off
+    static const uint8_t on_commands[] = {0x8D, 0x14, 0xAF};  // Charge Pump On, Display On
+    sendCommands(on ? on_commands : off_commands, 3);
+    energy_set(on ? ENERGY_OLED_ON : ENERGY_OLED_OFF);
 }
 
 void oled_clearDisplay()
 {
-    memset(buffer, 0, _width * _height / 8);
+    // Only columns that had something lit need to go out again
+    for (uint8_t page = 0; page < _height / 8; page++)
+    {
+        uint8_t *row = &buffer[page * _width];
+        for (int16_t x = 0; x < _width; x++)
+        {
+            if (row[x])
+            {
+                row[x] = 0;
+                markDirty(page, x);
+            }
+        }
+    }
 }
 
+// Sends only the columns that changed since the last refresh, page by page.
+// The transfers are queued and run by DMA, so this returns before the panel is updated.
 void oled_display()
 {
-    sendCommand(0x21); // Set Column Address
-    sendCommand(0);
-    sendCommand(_width - 1);
-    sendCommand(0x22); // Set Page Address
-    sendCommand(0);
-    sendCommand(_height / 8 - 1);
-
-    uint16_t bufferSize = _width * _height / 8;
-    uint8_t wireBufferSize = 32; // BUFFER_LENGTH in Wire.h
-    for (uint16_t i = 0; i < bufferSize; i += (wireBufferSize - 1))
-    {
-        Wire.beginTransmission(SSD1306_I2C_ADDRESS);
-        Wire.write(0x40);
-        uint16_t end = i + (wireBufferSize - 1);
-        if (end > bufferSize)
+    PROFILE_SCOPE(PROFILE_OLED);
+    static const uint8_t data_control = 0x40; // Co = 0, D/C = 1
+    bytes_sent = 0;
+
+    // The last refresh may still be reading from the shadow
+    i2c_dma_flush();
+
+    for (uint8_t page = 0; page < _height / 8; page++)
+    {
+        int16_t first = shadow_valid ? dirty_min[page] : 0;
+        int16_t last = shadow_valid ? dirty_max[page] : _width - 1;
+        uint8_t *row = &buffer[page * _width];
+        uint8_t *shown = &shadow[page * _width];
+
+        // Columns drawn over with the same pixels do not need sending
+        if (shadow_valid)
         {
-            end = bufferSize;
+            while (first <= last && row[first] == shown[first])
+            {
+                first++;
+            }
+            while (last >= first && row[last] == shown[last])
+            {
+                last--;
+            }
         }
-        for (uint16_t j = i; j < end; j++)
+        if (first > last)
         {
-            Wire.write(buffer[j]);
+            continue;
         }
-        Wire.endTransmission();
+
+        // Column and page window in one transaction, then the columns in another
+        const uint8_t window[] = {
+            0x00,                                // Co = 0, D/C = 0
+            0x21, (uint8_t)first, (uint8_t)last, // Set Column Address
+            0x22, page, page};                   // Set Page Address
+        i2c_dma_write(SSD1306_I2C_ADDRESS, window, sizeof(window), NULL, 0);
+
+        // The shadow is what the panel will show, and the DMA reads the columns from there
+        uint8_t count = last - first + 1;
+        memcpy(&shown[first], &row[first], count);
+        energy_set(ENERGY_OLED_PUSH);
+        pages_pending++;
+        if (!i2c_dma_write(SSD1306_I2C_ADDRESS, &data_control, 1, &shown[first], count, pageSent))
+        {
+            pageSent(false, NULL);
+        }
+        bytes_sent += sizeof(window) + 1 + count;
     }
+
+    shadow_valid = true;
+    markClean();
+}
+
+// Bytes put on the I2C bus (control bytes included) by the last oled_display()
+uint16_t oled_bytes_sent()
+{
+    return bytes_sent;
 }
 
 void oled_drawPixel(int16_t x, int16_t y, uint16_t color)
@@ -116,15 +193,21 @@ void oled_drawPixel(int16_t x, int16_t y, uint16_t color)
     {
         return;
     }
+    uint8_t *cell = &buffer[x + (y / 8) * _width];
+    uint8_t old = *cell;
     switch (color)
     {
     case 1:
-        buffer[x + (y / 8) * _width] |= (1 << (y & 7));
+        *cell |= (1 << (y & 7));
         break;
     case 0:
-        buffer[x + (y / 8) * _width] &= ~(1 << (y & 7));
+        *cell &= ~(1 << (y & 7));
         break;
     }
+    if (*cell != old)
+    {
+        markDirty(y / 8, x);
+    }
 }
 
 void oled_setTextSize(uint8_t s) { textSize = s; }
@@ -149,11 +232,11 @@ void oled_print(const char *str)
     }
 }
 
-void oled_print_diagnostic(const char* name, float value, int decimals) {
-    char buf[16];
-    char fmt[8];
-    snprintf(fmt, sizeof(fmt), "%%.%df", decimals);
-    snprintf(buf, sizeof(buf), fmt, value);
+// Prints "name: value" on its own line, with value / 10^decimals shown to that many decimals
+void oled_print_fixed(const char *name, int32_t value, uint8_t decimals, bool negative_zero)
+{
+    char buf[FMT_MAX_CHARS + 1];
+    *fmt_fixed(buf, value, decimals, negative_zero) = '\0';
     oled_setCursor(0, cursor_y);
     oled_print(name);
     oled_print(": ");
@@ -162,32 +245,131 @@ void oled_print_diagnostic(const char* name, float value, int decimals) {
     cursor_y += textSize * 8;
 }
 
-static void sendCommand(uint8_t cmd)
+void oled_print_diagnostic(const char *name, float value, int decimals)
+{
+    oled_print_fixed(name, float_to_fixed(value, decimals), decimals, signbit(value));
+}
+
+// The refresh is over once the last page has gone out
+static void pageSent(bool ok, void *context)
+{
+    if (--pages_pending == 0)
+    {
+        energy_set(ENERGY_OLED_ON);
+    }
+}
+
+static void markDirty(uint8_t page, uint8_t x)
+{
+    if (x < dirty_min[page])
+    {
+        dirty_min[page] = x;
+    }
+    if (x > dirty_max[page])
+    {
+        dirty_max[page] = x;
+    }
+}
+
+static void markClean()
 {
-    Wire.beginTransmission(SSD1306_I2C_ADDRESS);
-    Wire.write(0x00); // Co = 0, D/C = 0
-    Wire.write(cmd);
-    Wire.endTransmission();
+    memset(dirty_min, 0xFF, sizeof(dirty_min));
+    memset(dirty_max, 0x00, sizeof(dirty_max));
+}
+
+// Queues a command list as a single transaction. cmds must stay untouched until it is sent.
+static void sendCommands(const uint8_t *cmds, uint8_t count)
+{
+    static const uint8_t command_control = 0x00; // Co = 0, D/C = 0
+    i2c_dma_write(SSD1306_I2C_ADDRESS, &command_control, 1, cmds, count);
+    bytes_sent += 1 + count;
+}
+
+// Sets (color 1) or clears (color 0) a column of up to 24 pixels starting at row y.
+// Bit 0 of bits is the top pixel, the same as the panel's page bytes.
+static void blitColumn(int16_t x, int16_t y, uint32_t bits, uint16_t color)
+{
+    if (x < 0 || x >= _width || color > 1)
+    {
+        return;
+    }
+    int16_t page = y >> 3; // Rounds down for rows above the screen too
+    bits <<= y & 7;
+    for (; bits; page++, bits >>= 8)
+    {
+        if (page < 0)
+        {
+            continue;
+        }
+        if (page >= _height / 8)
+        {
+            break;
+        }
+        uint8_t *cell = &buffer[page * _width + x];
+        uint8_t old = *cell;
+        *cell = color ? old | (uint8_t)bits : old & ~(uint8_t)bits;
+        if (*cell != old)
+        {
+            markDirty(page, x);
+        }
+    }
 }
 
+// Each nibble with every bit doubled, for building size 2 glyph columns
+static const uint8_t doubled_nibble[16] = {
+    0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F,
+    0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF};
+
 static void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint8_t size)
 {
     if (c < ' ' || c > '~')
     {
         c = '?';
     }
-    for (int8_t i = 0; i < 5; i++)
+    const uint8_t *glyph = &font[(c - ' ') * 5];
+
+    if (size == 1)
     {
-        uint8_t line = font[(c - ' ') * 5 + i];
-        for (int8_t j = 0; j < 8; j++)
+        if ((y & 7) == 0 && y >= 0 && y < _height && x >= 0 && x <= _width - 5 && color <= 1)
         {
-            if (line & 0x1)
+            // Page aligned and fully on screen, each font column is exactly one buffer byte
+            uint8_t page = y >> 3;
+            uint8_t *cell = &buffer[page * _width + x];
+            for (uint8_t i = 0; i < 5; i++)
             {
-                if (size == 1)
+                uint8_t old = cell[i];
+                cell[i] = color ? old | glyph[i] : old & ~glyph[i];
+                if (cell[i] != old)
                 {
-                    oled_drawPixel(x + i, y + j, color);
+                    markDirty(page, x + i);
                 }
-                else
+            }
+            return;
+        }
+        for (uint8_t i = 0; i < 5; i++)
+        {
+            blitColumn(x + i, y, glyph[i], color);
+        }
+    }
+    else if (size == 2)
+    {
+        // Every font column becomes two identical 16 pixel columns
+        for (uint8_t i = 0; i < 5; i++)
+        {
+            uint32_t column = doubled_nibble[glyph[i] & 0x0F] | (doubled_nibble[glyph[i] >> 4] << 8);
+            blitColumn(x + i * 2, y, column, color);
+            blitColumn(x + i * 2 + 1, y, column, color);
+        }
+    }
+    else
+    {
+        // Larger sizes are rare, draw them pixel by pixel
+        for (int8_t i = 0; i < 5; i++)
+        {
+            uint8_t line = glyph[i];
+            for (int8_t j = 0; j < 8; j++)
+            {
+                if (line & 0x1)
                 {
                     for (int16_t k = 0; k < size; k++)
                     {
@@ -197,8 +379,8 @@ static void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint
                         }
                     }
                 }
+                line >>= 1;
             }
-            line >>= 1;
         }
     }
 }
@@ -23,12 +23,25 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #define SSD1306_I2C_ADDRESS 0x3C
 
+// Largest panel the framebuffers are sized for. The shield's is 128x32, build with OLED_MAX_HEIGHT 64
+// for a 128x64 one.
+#ifndef OLED_MAX_WIDTH
+#define OLED_MAX_WIDTH 128
+#endif
+#ifndef OLED_MAX_HEIGHT
+#define OLED_MAX_HEIGHT 32
+#endif
+#define OLED_BUFFER_BYTES (OLED_MAX_WIDTH * OLED_MAX_HEIGHT / 8)
+
 bool oled_begin(int16_t width, int16_t height, uint8_t i2c_addr = SSD1306_I2C_ADDRESS);
+void oled_power(bool on);
 void oled_clearDisplay();
 void oled_display();
+uint16_t oled_bytes_sent();
 void oled_drawPixel(int16_t x, int16_t y, uint16_t color);
 void oled_setTextSize(uint8_t s);
 void oled_setTextColor(uint16_t c);
 void oled_setCursor(int16_t x, int16_t y);
 void oled_print(const char* str);
+void oled_print_fixed(const char* name, int32_t value, uint8_t decimals, bool negative_zero = false);
 void oled_print_diagnostic(const char* name, float value, int decimals);
\ No newline at end of file
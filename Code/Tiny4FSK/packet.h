@@ -0,0 +1,80 @@
+/*
+packet.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// HORUS BINARY V2 PACKET SCHEMA
+// Every field of the packet is listed once below, in packet order. The packed struct, the datalog.csv
+// header and writer, the DEV_MODE dump, and on the computer the decoders in Tools/ and the
+// horusdemodlib custom field list are all generated from these lists. Adding a sensor means changing
+// one line here and filling the field in build_horus_binary_packet_v2().
+// Each entry gives the struct member, its type, how the raw value scales to the unit, the unit, and a
+// lower case name for decoded columns. The scalings match horusdemodlib's converters:
+//   NONE    - the value as it is
+//   DIV10   - value / 10, "divide_by_10"
+//   DIV100  - value / 100, "divide_by_100"
+//   BATT5V  - value * 5 / 255, "battery_5v_byte"
+// Shared with the host tools in Tools/, so keep this free of Arduino includes.
+#pragma once
+
+#include <stdint.h>
+
+// Fixed by the Horus Binary v2 format
+// https://github.com/projecthorus/horusdemodlib/wiki/4-Packet-Format-Details#packet-formats
+#define HORUS_PACKET_FIELDS_FIXED(X)                     \
+  X(PayloadID, uint16_t, NONE, "-", payload_id)          \
+  X(Counter, uint16_t, NONE, "-", counter)               \
+  X(Hours, uint8_t, NONE, "h", hours)                    \
+  X(Minutes, uint8_t, NONE, "min", minutes)              \
+  X(Seconds, uint8_t, NONE, "s", seconds)                \
+  X(Latitude, float, NONE, "deg", latitude)              \
+  X(Longitude, float, NONE, "deg", longitude)            \
+  X(Altitude, uint16_t, NONE, "m", altitude)             \
+  X(Speed, uint8_t, NONE, "km/h", speed)                 \
+  X(Sats, uint8_t, NONE, "-", sats)                      \
+  X(Temp, int8_t, NONE, "C", temp)                       \
+  X(BattVoltage, uint8_t, BATT5V, "V", battery)
+
+// The user-customizable bytes between BattVoltage and the CRC. A receiver decodes them with the
+// custom field list for this payload (Tools/horus_fields prints it).
+#define HORUS_PACKET_FIELDS_CUSTOM(X)                    \
+  X(AscentRate, int16_t, DIV100, "m/s", ascent_rate)     \
+  X(ExtTemp, int16_t, DIV10, "C", ext_temperature)       \
+  X(Humidity, uint8_t, NONE, "%", ext_humidity)          \
+  X(ExtPress, uint16_t, DIV10, "hPa", ext_pressure)      \
+  X(dummy1, uint8_t, DIV10, "g", peak_accel)             \
+  X(dummy2, uint8_t, NONE, "-", flags)
+
+// Bits of dummy2
+#define PACKET_FLAG_DEAD_RECKONED 0x01 // No fresh fix, the position was carried forward (track.h)
+#define PACKET_FLAG_BACKFILL 0x02      // Sent again from the store and forward ring (backfill.h)
+
+#define HORUS_PACKET_FIELDS(X) HORUS_PACKET_FIELDS_FIXED(X) HORUS_PACKET_FIELDS_CUSTOM(X)
+
+#define HORUS_PACKET_CUSTOM_BYTES 9
+
+#define HORUS_PACKET_MEMBER(name, type, scale, unit, column) type name;
+#define HORUS_PACKET_SIZE(name, type, scale, unit, column) +sizeof(type)
+
+struct HorusBinaryPacketV2
+{
+  HORUS_PACKET_FIELDS(HORUS_PACKET_MEMBER)
+  uint16_t Checksum; // crc16() of everything above
+} __attribute__((packed));
+
+static_assert(sizeof(HorusBinaryPacketV2) == 32, "A Horus Binary v2 packet is 32 bytes");
+static_assert(0 HORUS_PACKET_FIELDS_CUSTOM(HORUS_PACKET_SIZE) == HORUS_PACKET_CUSTOM_BYTES,
+              "The custom fields must fill the custom bytes exactly");
@@ -0,0 +1,145 @@
+/*
+power.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "power.h"
+#include <ArduinoLowPower.h>
+#include "energy.h"
+#include "clock.h"
+#include "imu.h"
+
+// Deep sleep, counted on the crystal. SysTick and millis() stop while the MCU is in standby, the
+// clock timebase does not.
+// The IMU keeps sampling into its FIFO, so a long sleep is cut into pieces of IMU_SLEEP_MAX_MS,
+// with the FIFO drained in between, and no motion is lost however many slots are skipped.
+void power_deep_sleep(uint32_t ms)
+{
+  while (ms > 0)
+  {
+    uint32_t chunk = ms > IMU_SLEEP_MAX_MS ? IMU_SLEEP_MAX_MS : ms;
+    energy_set(ENERGY_CPU_SLEEP);
+    uint32_t start = clock_ticks();
+    LowPower.deepSleep(chunk);
+    clock_add_sleep(clock_ticks() - start);
+    energy_set(clock_get() == CLOCK_SLOW ? ENERGY_CPU_SLOW : ENERGY_CPU_ACTIVE);
+    ms -= chunk;
+    if (ms > 0)
+    {
+      imu_drain();
+    }
+  }
+}
+
+#ifdef ULTRA_LOW_POWER
+#include "cadence.h"
+#include "si4063.h"
+#include "shield.h"
+#include "fixed_format.h"
+
+static_assert(POWER_RADIO_WAKE_US < CADENCE_WAKE_MARGIN * 1000UL,
+              "The radio wake up budget must fit in the cadence wake margin");
+
+static bool gps_resting = false;
+static uint32_t gps_wake_ms = 0;
+static power_stats stats;
+
+// The display stays off for the flight. Everything else is put to rest straight away.
+void power_begin()
+{
+  if (oled_found)
+  {
+    oled_power(false);
+  }
+  power_idle();
+}
+
+// Puts the GPS in standby if it can be back up by needed_ms (cadence_millis() time). The CASIC
+// $PCAS12 command takes whole seconds, and the receiver wakes up by itself when they are up.
+void power_gps_rest(uint32_t needed_ms)
+{
+  power_service();
+  int32_t spare_ms = (int32_t)(needed_ms - cadence_millis()) - POWER_GPS_WAKE_MS;
+  if (gps_resting || spare_ms < 1000)
+  {
+    return;
+  }
+  uint32_t seconds = spare_ms / 1000;
+
+  // The checksum is the XOR of everything between $ and *
+  static const char hex[] = "0123456789ABCDEF";
+  char sentence[24] = "$PCAS12,";
+  char *end = fmt_uint(sentence + 8, seconds);
+  uint8_t checksum = 0;
+  for (char *c = sentence + 1; c < end; c++)
+  {
+    checksum ^= *c;
+  }
+  *end++ = '*';
+  *end++ = hex[checksum >> 4];
+  *end++ = hex[checksum & 0x0F];
+  *end++ = '\r';
+  *end++ = '\n';
+  Serial1.write((const uint8_t *)sentence, end - sentence);
+
+  gps_resting = true;
+  gps_wake_ms = cadence_millis() + seconds * 1000;
+  stats.gps_rests++;
+  stats.gps_rest_ms += seconds * 1000;
+  energy_set(ENERGY_GPS_STANDBY);
+}
+
+// After a packet: radio to sleep
+void power_idle()
+{
+  si4063_disable_tx();
+}
+
+// In the wake margin before a slot: the radio ready to key up
+void power_wake()
+{
+  power_service();
+  uint32_t start = clock_micros();
+  si4063_inhibit_tx();
+  si4063_wait_for_cts();
+  stats.radio_wake_us = clock_micros() - start;
+  if (stats.radio_wake_us > stats.radio_wake_max_us)
+  {
+    stats.radio_wake_max_us = stats.radio_wake_us;
+  }
+  if (stats.radio_wake_us > POWER_RADIO_WAKE_US)
+  {
+    stats.overruns++;
+  }
+}
+
+// Notices when the GPS has woken itself up. Call often.
+void power_service()
+{
+  uint32_t now = cadence_millis();
+  if (gps_resting && (int32_t)(now - gps_wake_ms) >= 0)
+  {
+    gps_resting = false;
+    energy_set_ago(ENERGY_GPS_ON, now - gps_wake_ms);
+  }
+}
+
+const power_stats *power_get_stats()
+{
+  return &stats;
+}
+
+#endif
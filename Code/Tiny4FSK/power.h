@@ -0,0 +1,63 @@
+/*
+power.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// LOW POWER PROFILE
+// With ULTRA_LOW_POWER in config.h, everything that is not needed between packets is put to rest:
+//  - The Si4063 sleeps between packets instead of waiting in READY.
+//  - The GPS goes into standby while its fix is not needed, and wakes itself in time for the next one.
+//  - The OLED and its charge pump are switched off once setup is done.
+// The CPU clock is left to CLOCK_SCALING (clock.h).
+// The BME280 already goes back to sleep by itself after each forced conversion. The SD card has no
+// power switch on the board, so it is left idle between flight log writes.
+// Every wake up has a budget. The radio budget has to fit in CADENCE_WAKE_MARGIN, and the
+// GPS is woken POWER_GPS_WAKE_MS before its fix or time pulse is needed, so the cadence is kept.
+// power_deep_sleep() is used with or without the profile, so the energy accounting sees every sleep.
+#pragma once
+
+#include <Arduino.h>
+#include "config.h"
+
+// Wake up budgets
+#define POWER_RADIO_WAKE_US 1000 // Si4063 SLEEP to READY, 440 us in the datasheet
+#define POWER_GPS_WAKE_MS 1500   // Hot start out of standby is about 1 s, then the first time pulse
+
+struct power_stats
+{
+  uint32_t gps_rests;         // Times the GPS was put in standby
+  uint32_t gps_rest_ms;       // Total time it spent there
+  uint32_t radio_wake_us;     // Last Si4063 SLEEP to READY
+  uint32_t radio_wake_max_us;
+  uint32_t overruns;          // Wake ups that took longer than their budget
+};
+
+void power_deep_sleep(uint32_t ms);
+
+#ifdef ULTRA_LOW_POWER
+void power_begin();
+void power_gps_rest(uint32_t needed_ms);
+void power_idle();
+void power_wake();
+void power_service();
+const power_stats *power_get_stats();
+#else
+inline void power_begin() {}
+inline void power_gps_rest(uint32_t needed_ms) {}
+inline void power_idle() {}
+inline void power_wake() {}
+inline void power_service() {}
+#endif
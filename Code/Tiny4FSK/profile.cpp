@@ -0,0 +1,178 @@
+/*
+profile.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "profile.h"
+
+#ifdef PROFILE
+#include <Arduino.h>
+#include <string.h>
+#include "fixed_format.h"
+#define Serial SerialUSB
+
+static profile_histogram histograms[PROFILE_PROBES];
+static uint32_t overhead_cycles = 0;
+
+static const char *const probe_names[PROFILE_PROBES] = {"build", "crc", "encode", "oled", "sd_write"};
+
+// Times a few empty scopes. The quickest is what clock_cycles() itself adds to every measurement.
+void profile_begin()
+{
+  memset(histograms, 0, sizeof(histograms));
+  overhead_cycles = UINT32_MAX;
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    uint32_t start = clock_cycles();
+    uint32_t cycles = clock_cycles() - start;
+    if (cycles < overhead_cycles)
+    {
+      overhead_cycles = cycles;
+    }
+  }
+}
+
+// The position of the highest set bit, with 0 and 1 both in bucket 0
+static uint8_t profile_bucket(uint32_t cycles)
+{
+  uint8_t bucket = 0;
+  while (cycles > 1 && bucket < PROFILE_BUCKETS - 1)
+  {
+    cycles >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void profile_add(profile_probe probe, uint32_t cycles)
+{
+  cycles = cycles > overhead_cycles ? cycles - overhead_cycles : 0;
+  profile_histogram *h = &histograms[probe];
+  if (h->count == 0 || cycles < h->min_cycles)
+  {
+    h->min_cycles = cycles;
+  }
+  if (cycles > h->max_cycles)
+  {
+    h->max_cycles = cycles;
+  }
+  h->count++;
+  h->total_cycles += cycles;
+  uint16_t *bucket = &h->buckets[profile_bucket(cycles)];
+  if (*bucket != UINT16_MAX)
+  {
+    (*bucket)++;
+  }
+}
+
+const profile_histogram *profile_get(profile_probe probe)
+{
+  return &histograms[probe];
+}
+
+const char *profile_probe_name(profile_probe probe)
+{
+  return probe_names[probe];
+}
+
+// One line per probe that has run, the histogram as bucket:count for the buckets in use
+void profile_print()
+{
+#ifdef DEV_MODE
+  Serial.print(F("Profile (cycles), overhead "));
+  Serial.println(overhead_cycles);
+  for (uint8_t i = 0; i < PROFILE_PROBES; i++)
+  {
+    const profile_histogram *h = &histograms[i];
+    if (h->count == 0)
+    {
+      continue;
+    }
+    Serial.print(F("  "));
+    Serial.print(probe_names[i]);
+    Serial.print(F(": n "));
+    Serial.print(h->count);
+    Serial.print(F(", min "));
+    Serial.print(h->min_cycles);
+    Serial.print(F(", mean "));
+    Serial.print((uint32_t)(h->total_cycles / h->count));
+    Serial.print(F(", max "));
+    Serial.print(h->max_cycles);
+    Serial.print(F(" |"));
+    for (uint8_t b = 0; b < PROFILE_BUCKETS; b++)
+    {
+      if (h->buckets[b] != 0)
+      {
+        Serial.print(' ');
+        Serial.print(b);
+        Serial.print(':');
+        Serial.print(h->buckets[b]);
+      }
+    }
+    Serial.println();
+  }
+#endif
+}
+
+// One PROFILE.CSV row for a probe, with the columns of PROFILE_LOG_HEADER. Buckets from the first that
+// does not fit in size on are left out. Returns the length, 0 if the probe has not run.
+size_t profile_log_row(char *out, size_t size, profile_probe probe)
+{
+  const profile_histogram *h = &histograms[probe];
+  if (h->count == 0 || size < 6 * FMT_MAX_CHARS + 16)
+  {
+    return 0;
+  }
+  char *start = out;
+  out = fmt_uint(out, millis());
+  *out++ = ',';
+  strcpy(out, probe_names[probe]);
+  out += strlen(out);
+  *out++ = ',';
+  out = fmt_uint(out, h->count);
+  *out++ = ',';
+  out = fmt_uint(out, h->min_cycles);
+  *out++ = ',';
+  out = fmt_uint(out, (uint32_t)(h->total_cycles / h->count));
+  *out++ = ',';
+  out = fmt_uint(out, h->max_cycles);
+  *out++ = ',';
+  bool first = true;
+  for (uint8_t b = 0; b < PROFILE_BUCKETS; b++)
+  {
+    // "bucket:count", a space before all but the first, and room for the NUL
+    if ((size_t)(out - start) + 10 > size)
+    {
+      break;
+    }
+    if (h->buckets[b] == 0)
+    {
+      continue;
+    }
+    if (!first)
+    {
+      *out++ = ' ';
+    }
+    first = false;
+    out = fmt_uint(out, b);
+    *out++ = ':';
+    out = fmt_uint(out, h->buckets[b]);
+  }
+  *out = '\0';
+  return out - start;
+}
+
+#endif
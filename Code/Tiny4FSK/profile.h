@@ -0,0 +1,93 @@
+/*
+profile.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// PROFILER
+// With PROFILE in config.h, PROFILE_SCOPE(probe) times the rest of the enclosing block in CPU cycles,
+// from SysTick (clock_cycles()), and adds it to the probe's histogram. The buckets are powers of two:
+// bucket n holds times of 2^n up to 2^(n+1) - 1 cycles, so the whole histogram is a fixed 24 counters,
+// from 1 cycle up to about 0.35 s at 48 MHz. The cost of an empty scope is measured by profile_begin()
+// and taken off every time.
+// Times are wall time, so interrupts and other Scheduler tasks that run inside a scope count towards
+// it. A scope must not span clock_set(), as a cycle then stands for a different length of time.
+// Without PROFILE, PROFILE_SCOPE() is empty and the functions below do nothing, so nothing is left in
+// the build.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+
+#if defined(PROFILE_SD_LOG) && !defined(PROFILE)
+#error "PROFILE_SD_LOG needs PROFILE"
+#endif
+
+#define PROFILE_BUCKETS 24
+
+// Packets between profile reports over USB (DEV_MODE) and rows of PROFILE.CSV, about a minute
+#define PROFILE_LOG_INTERVAL 12
+#define PROFILE_LOG_HEADER "profile_ms,probe,count,min_cycles,mean_cycles,max_cycles,histogram"
+
+enum profile_probe
+{
+  PROFILE_BUILD,    // build_horus_binary_packet_v2(), OLED and logging included
+  PROFILE_CRC,      // crc16() of the packet
+  PROFILE_ENCODE,   // horus_l2_encode_tx_packet()
+  PROFILE_OLED,     // oled_display()
+  PROFILE_SD_WRITE, // sd_card_write_line() and sd_card_log_line()
+  PROFILE_PROBES
+};
+
+struct profile_histogram
+{
+  uint32_t count;
+  uint32_t min_cycles;
+  uint32_t max_cycles;
+  uint64_t total_cycles;
+  uint16_t buckets[PROFILE_BUCKETS]; // Stop counting at 65535
+};
+
+#ifdef PROFILE
+#include "clock.h"
+
+void profile_begin();
+void profile_add(profile_probe probe, uint32_t cycles);
+const profile_histogram *profile_get(profile_probe probe);
+const char *profile_probe_name(profile_probe probe);
+void profile_print();
+size_t profile_log_row(char *out, size_t size, profile_probe probe);
+
+class profile_scope
+{
+public:
+  explicit profile_scope(profile_probe probe) : probe(probe), start(clock_cycles()) {}
+  ~profile_scope() { profile_add(probe, clock_cycles() - start); }
+
+private:
+  profile_probe probe;
+  uint32_t start;
+};
+
+#define PROFILE_JOIN2(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN2(a, b)
+#define PROFILE_SCOPE(probe) profile_scope PROFILE_JOIN(profile_scope_, __LINE__)(probe)
+#else
+inline void profile_begin() {}
+inline void profile_add(profile_probe probe, uint32_t cycles) {}
+inline void profile_print() {}
+#define PROFILE_SCOPE(probe) ((void)0)
+#endif
@@ -0,0 +1,99 @@
+/*
+ram.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ram.h"
+
+ram_arena arena;
+
+static ram_stats stats;
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#define Serial SerialUSB
+
+// From the linker script and newlib
+extern "C" char __data_start__;
+extern "C" char __bss_end__;
+extern "C" char end;
+extern "C" char __StackTop;
+extern "C" void *sbrk(int increment);
+
+// Room left below the caller's frame for ram_begin() itself and any interrupt that comes in
+#define RAM_PAINT_MARGIN 64
+
+static uint32_t *paint_start = NULL;
+static uint32_t *paint_end = NULL;
+
+static uint32_t *ram_heap_end()
+{
+  return (uint32_t *)(((uintptr_t)sbrk(0) + 3) & ~(uintptr_t)3);
+}
+
+// Call first thing in setup(), while the stack is shallow
+void ram_begin()
+{
+  uint32_t here;
+  paint_start = ram_heap_end();
+  paint_end = (uint32_t *)(((uintptr_t)&here - RAM_PAINT_MARGIN) & ~(uintptr_t)3);
+  for (uint32_t *word = paint_start; word < paint_end; word++)
+  {
+    *word = RAM_PAINT;
+  }
+}
+
+// The heap may have grown into the painted RAM since, so the search starts above it
+const ram_stats *ram_get_stats()
+{
+  uint32_t *heap_end = ram_heap_end();
+  uint32_t *word = heap_end > paint_start ? heap_end : paint_start;
+  while (word < paint_end && *word == RAM_PAINT)
+  {
+    word++;
+  }
+  stats.static_bytes = &__bss_end__ - &__data_start__;
+  stats.heap_bytes = (char *)heap_end - &end;
+  stats.stack_peak_bytes = &__StackTop - (char *)word;
+  stats.free_bytes = (char *)word - (char *)heap_end;
+  return &stats;
+}
+
+void ram_print()
+{
+#ifdef DEV_MODE
+  const ram_stats *m = ram_get_stats();
+  Serial.print(F("RAM (bytes): static "));
+  Serial.print(m->static_bytes);
+  Serial.print(F(", heap "));
+  Serial.print(m->heap_bytes);
+  Serial.print(F(", stack peak "));
+  Serial.print(m->stack_peak_bytes);
+  Serial.print(F(", never used "));
+  Serial.println(m->free_bytes);
+#endif
+}
+#else
+// On a computer there is nothing to measure
+void ram_begin() {}
+
+const ram_stats *ram_get_stats()
+{
+  return &stats;
+}
+
+void ram_print() {}
+#endif
@@ -0,0 +1,75 @@
+/*
+ram.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// RAM BUDGET
+// All of the tracker's RAM is laid out at build time. The packet buffers live in one static arena,
+// sized from the packet format, and every module keeps its own buffers as fixed static arrays (the
+// flight log sector, the OLED framebuffers, the I2C queue, the IMU burst, the store and forward ring).
+// Nothing in Code/Tiny4FSK uses the heap or variable length arrays. The one heap block is the gpsFeed
+// task's stack, which the Scheduler library allocates in setup().
+// ram_begin() paints the RAM between the heap and the stack with a pattern. The lowest word that
+// no longer holds it is as deep as the main stack has ever reached, which ram_get_stats() finds.
+// Tools/ram_report lists the static RAM of each module from the build's object files.
+#pragma once
+
+#include <stdint.h>
+#include "config.h"
+#include "packet.h"
+#include "horus_l2.h"
+#include "datalog_csv.h"
+#include "rate.h"
+
+#define RAM_SIZE 32768 // SAMD21G18
+#define RAM_PAINT 0xA5A5A5A5
+
+// Packets between RAM reports over USB (DEV_MODE), about a minute
+#define RAM_REPORT_INTERVAL 12
+
+// Arena sizes, from the packet format. Text lines are CSV rows for the SD card and the DEV_MODE
+// packet dump, whichever is longer.
+#define RAM_RAW_BYTES sizeof(HorusBinaryPacketV2)
+#define RAM_CODED_BYTES HORUS_L2_TX_BYTES(sizeof(HorusBinaryPacketV2))
+#ifdef DEV_MODE
+#define RAM_TEXT_BYTES (DATALOG_MAX_TEXT > DATALOG_MAX_ROW ? DATALOG_MAX_TEXT : DATALOG_MAX_ROW)
+#else
+#define RAM_TEXT_BYTES DATALOG_MAX_ROW
+#endif
+
+static_assert(sizeof(HorusBinaryPacketV2) <= HORUS_L2_MAX_PAYLOAD_BYTES, "The packet is too long for the encoder");
+static_assert(RATE_LOG_MAX <= RAM_TEXT_BYTES, "RATE.CSV rows have to fit in the text buffer");
+
+struct ram_arena
+{
+  char raw[RAM_RAW_BYTES];     // The packet as built
+  char coded[RAM_CODED_BYTES]; // The packet after horus_l2_encode_tx_packet()
+  char text[RAM_TEXT_BYTES];   // One line of text
+};
+
+extern ram_arena arena;
+
+struct ram_stats
+{
+  uint32_t static_bytes; // .data and .bss
+  uint32_t heap_bytes;   // Heap in use, free blocks included
+  uint32_t stack_peak_bytes; // Deepest the main stack has been since ram_begin()
+  uint32_t free_bytes;   // Between the heap and the deepest stack, never touched
+};
+
+void ram_begin();
+const ram_stats *ram_get_stats();
+void ram_print();
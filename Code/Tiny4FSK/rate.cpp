@@ -0,0 +1,231 @@
+/*
+rate.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "rate.h"
+#include <string.h>
+
+static const char *const phase_names[RATE_PHASES] = {"pad", "ascent", "float", "descent", "landed"};
+
+const char *rate_phase_name(rate_phase phase)
+{
+  return phase_names[phase];
+}
+
+#ifdef ADAPTIVE_RATE
+
+static const uint8_t phase_slots[RATE_PHASES] = {RATE_PAD_SLOTS, RATE_ASCENT_SLOTS, RATE_FLOAT_SLOTS,
+                                                 RATE_DESCENT_SLOTS, RATE_LANDED_SLOTS};
+static const uint8_t phase_power[RATE_PHASES] = {RATE_PAD_POWER, RATE_ASCENT_POWER, RATE_FLOAT_POWER,
+                                                 RATE_DESCENT_POWER, RATE_LANDED_POWER};
+
+static_assert(RATE_PAD_SLOTS >= 1 && RATE_ASCENT_SLOTS >= 1 && RATE_FLOAT_SLOTS >= 1 && RATE_DESCENT_SLOTS >= 1 &&
+                  RATE_LANDED_SLOTS >= 1,
+              "Every phase needs at least one slot");
+static_assert(RATE_MAX_SLOTS <= 255 && RATE_PAD_SLOTS <= RATE_MAX_SLOTS && RATE_ASCENT_SLOTS <= RATE_MAX_SLOTS &&
+                  RATE_FLOAT_SLOTS <= RATE_MAX_SLOTS && RATE_DESCENT_SLOTS <= RATE_MAX_SLOTS &&
+                  RATE_LANDED_SLOTS <= RATE_MAX_SLOTS,
+              "RATE_MAX_SLOTS bounds every phase, and has to fit in a byte");
+
+static rate_stats stats;
+
+static bool pad_known = false;
+static uint16_t pad_altitude_m = 0; // Lowest fix seen on the pad
+static rate_phase candidate = RATE_PAD;
+static uint8_t candidate_count = 0;
+
+// Battery average in 1/16 mV, and where it stood when the trend was last measured
+static uint32_t battery_x16 = 0;
+static uint32_t trend_start_x16 = 0;
+static uint32_t trend_start_ms = 0;
+
+void rate_begin()
+{
+  memset(&stats, 0, sizeof(stats));
+  stats.phase = RATE_PAD;
+  stats.slots = phase_slots[RATE_PAD];
+  stats.power = phase_power[RATE_PAD];
+  pad_known = false;
+  candidate = RATE_PAD;
+  candidate_count = 0;
+  battery_x16 = 0;
+}
+
+// The phase this packet points to, from the one the tracker is in
+static rate_phase rate_next_phase(uint16_t altitude_m, int16_t ascent_cms)
+{
+  bool still = ascent_cms < RATE_STILL_CMS && ascent_cms > -RATE_STILL_CMS;
+  bool low = altitude_m < (uint32_t)pad_altitude_m + RATE_LANDED_ABOVE_PAD_M;
+  switch (stats.phase)
+  {
+  case RATE_PAD:
+    // Falling, or this high up, the tracker was reset in flight
+    if (ascent_cms < RATE_FALL_CMS)
+    {
+      return RATE_DESCENT;
+    }
+    if (ascent_cms > RATE_CLIMB_CMS)
+    {
+      return RATE_ASCENT;
+    }
+    return altitude_m > RATE_PAD_MAX_M ? RATE_FLOAT : RATE_PAD;
+  case RATE_ASCENT:
+  case RATE_FLOAT:
+    if (ascent_cms < RATE_FALL_CMS)
+    {
+      return RATE_DESCENT;
+    }
+    if (ascent_cms > RATE_CLIMB_CMS)
+    {
+      return RATE_ASCENT;
+    }
+    return still ? RATE_FLOAT : stats.phase;
+  case RATE_DESCENT:
+    return still ? (low ? RATE_LANDED : RATE_FLOAT) : RATE_DESCENT;
+  default:
+    return ascent_cms < RATE_FALL_CMS ? RATE_DESCENT : RATE_LANDED;
+  }
+}
+
+// Averages the battery, and every RATE_TREND_MS measures how fast it is going down. Returns true while
+// it is low, or would be empty within RATE_RESERVE_HOURS at that rate.
+static bool rate_battery(uint16_t battery_mv, uint32_t now_ms)
+{
+  if (battery_x16 == 0)
+  {
+    battery_x16 = (uint32_t)battery_mv << 4;
+    trend_start_x16 = battery_x16;
+    trend_start_ms = now_ms;
+  }
+  battery_x16 += ((int32_t)((uint32_t)battery_mv << 4) - (int32_t)battery_x16) / 8;
+  stats.battery_mv = battery_x16 >> 4;
+
+  uint32_t elapsed_ms = now_ms - trend_start_ms;
+  if (elapsed_ms >= RATE_TREND_MS)
+  {
+    stats.trend_mv_h = (int64_t)((int32_t)battery_x16 - (int32_t)trend_start_x16) * 3600000 / 16 / (int32_t)elapsed_ms;
+    trend_start_x16 = battery_x16;
+    trend_start_ms = now_ms;
+  }
+
+  if (stats.battery_mv < RATE_LOW_MV)
+  {
+    return true;
+  }
+  return stats.trend_mv_h < 0 && (int32_t)(stats.battery_mv - RATE_EMPTY_MV) < -stats.trend_mv_h * RATE_RESERVE_HOURS;
+}
+
+// Call once per packet, with what went into it. Returns true if anything rate_log_row() shows, other
+// than the readings, changed.
+bool rate_update(bool fix, uint16_t altitude_m, int16_t ascent_cms, uint16_t battery_mv, uint32_t now_ms)
+{
+  rate_phase phase = stats.phase;
+  bool conserve = stats.conserve;
+  if (fix)
+  {
+    if (stats.phase == RATE_PAD && (!pad_known || altitude_m < pad_altitude_m))
+    {
+      pad_altitude_m = altitude_m;
+      pad_known = true;
+    }
+
+    rate_phase next = rate_next_phase(altitude_m, ascent_cms);
+    if (stats.phase == RATE_PAD && altitude_m >= (uint32_t)pad_altitude_m + RATE_LAUNCH_GAIN_M)
+    {
+      next = RATE_ASCENT;
+      candidate_count = RATE_CONFIRM;
+    }
+    else if (next == stats.phase)
+    {
+      candidate_count = 0;
+    }
+    else if (next == candidate)
+    {
+      candidate_count++;
+    }
+    else
+    {
+      candidate_count = 1;
+    }
+    candidate = next;
+    if (next != stats.phase && candidate_count >= RATE_CONFIRM)
+    {
+      stats.phase = next;
+      candidate_count = 0;
+    }
+  }
+  stats.conserve = battery_mv > 0 && rate_battery(battery_mv, now_ms);
+  stats.phase_packets[stats.phase]++;
+
+  uint16_t slots = phase_slots[stats.phase];
+  if (stats.conserve)
+  {
+    slots = slots * 2 > RATE_MAX_SLOTS ? RATE_MAX_SLOTS : slots * 2;
+  }
+  uint8_t power = phase_power[stats.phase];
+  if (slots == stats.slots && power == stats.power && phase == stats.phase && conserve == stats.conserve)
+  {
+    return false;
+  }
+  stats.slots = slots;
+  stats.power = power;
+  stats.changes++;
+  return true;
+}
+
+uint8_t rate_slots()
+{
+  return stats.slots;
+}
+
+uint8_t rate_power()
+{
+  return stats.power;
+}
+
+const rate_stats *rate_get_stats()
+{
+  return &stats;
+}
+
+// One RATE.CSV row, with the columns of RATE_LOG_HEADER. The ascent rate is in m/s.
+void rate_log_row(char *out, uint16_t packet, uint16_t altitude_m, int16_t ascent_cms, uint32_t now_ms)
+{
+  out = fmt_uint(out, now_ms);
+  *out++ = ',';
+  out = fmt_uint(out, packet);
+  *out++ = ',';
+  strcpy(out, phase_names[stats.phase]);
+  out += strlen(out);
+  *out++ = ',';
+  out = fmt_uint(out, stats.slots);
+  *out++ = ',';
+  out = fmt_uint(out, stats.power);
+  *out++ = ',';
+  *out++ = stats.conserve ? '1' : '0';
+  *out++ = ',';
+  out = fmt_uint(out, altitude_m);
+  *out++ = ',';
+  out = fmt_fixed(out, ascent_cms, 2);
+  *out++ = ',';
+  out = fmt_uint(out, stats.battery_mv);
+  *out++ = ',';
+  out = fmt_int(out, stats.trend_mv_h);
+  *out = '\0';
+}
+
+#endif
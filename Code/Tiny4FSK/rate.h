@@ -0,0 +1,93 @@
+/*
+rate.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// ADAPTIVE PACKET RATE
+// Works out the flight phase from each packet's altitude and ascent rate, and picks how often packets
+// go out and at what power for that phase, from the RATE_* settings in config.h. The rate is counted in
+// packet periods (slots): 1 sends a packet every period, 6 every sixth. With GPS_TIME_SYNC the skipped
+// slots stay on the GPS time grid, so receivers and trackers sharing the frequency are not disturbed.
+// A new phase has to be seen for RATE_CONFIRM packets in a row, except launch, which is taken as soon
+// as the tracker is RATE_LAUNCH_GAIN_M above where it sat on the pad. A tracker reset in flight starts
+// on the pad too, and finds its way out of it from the ascent rate and altitude.
+// The battery voltage is averaged, and its trend measured every RATE_TREND_MS. Once it is below
+// RATE_LOW_MV, or the trend says it will reach RATE_EMPTY_MV within RATE_RESERVE_HOURS, every phase
+// sends half as often.
+// Without ADAPTIVE_RATE in config.h, every slot is used at OUTPUT_POWER.
+// No hardware is touched here, so the same code runs in Tools/energy_model.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+#include "fixed_format.h"
+
+// Phase changes
+#define RATE_LAUNCH_GAIN_M 50 // Above the lowest pad altitude
+#define RATE_CLIMB_CMS 100    // Ascent rate that counts as climbing
+#define RATE_FALL_CMS -300    // Ascent rate that counts as falling
+#define RATE_STILL_CMS 50     // Slower than this either way is floating, or landed
+#define RATE_LANDED_ABOVE_PAD_M 3000 // Standing still lower than this above the pad is landed, not floating
+#define RATE_PAD_MAX_M 5000   // No launch site is this high, so a tracker still on the pad here was reset in flight
+#define RATE_CONFIRM 3
+
+// Battery trend. The cell sags by a few hundred mV an hour as it gets cold on the way up, and comes
+// back on the way down, so the trend is taken over an hour and only a short reserve left counts.
+#define RATE_RESERVE_HOURS 1
+#define RATE_TREND_MS 3600000UL
+
+// Longest line rate_log_row() writes, with the NUL
+#define RATE_LOG_MAX (9 * FMT_MAX_CHARS + 18)
+#define RATE_LOG_HEADER "clock_ms,packet,phase,slots,power,conserve,altitude,ascent_rate,battery_mv,trend_mv_h"
+
+enum rate_phase
+{
+  RATE_PAD,
+  RATE_ASCENT,
+  RATE_FLOAT,
+  RATE_DESCENT,
+  RATE_LANDED,
+  RATE_PHASES
+};
+
+struct rate_stats
+{
+  rate_phase phase;
+  uint8_t slots;       // Packet periods from this packet to the next
+  uint8_t power;       // Si4063 PA level
+  bool conserve;       // Battery low, or running out
+  uint16_t battery_mv; // Averaged
+  int32_t trend_mv_h;  // Battery change per hour, over the last RATE_TREND_MS
+  uint16_t changes;    // Times the phase, the slots, the power or conserve changed
+  uint32_t phase_packets[RATE_PHASES]; // Packets sent in each phase
+};
+
+const char *rate_phase_name(rate_phase phase);
+
+#ifdef ADAPTIVE_RATE
+void rate_begin();
+bool rate_update(bool fix, uint16_t altitude_m, int16_t ascent_cms, uint16_t battery_mv, uint32_t now_ms);
+uint8_t rate_slots();
+uint8_t rate_power();
+const rate_stats *rate_get_stats();
+void rate_log_row(char *out, uint16_t packet, uint16_t altitude_m, int16_t ascent_cms, uint32_t now_ms);
+#else
+inline void rate_begin() {}
+inline bool rate_update(bool fix, uint16_t altitude_m, int16_t ascent_cms, uint16_t battery_mv, uint32_t now_ms) { return false; }
+inline uint8_t rate_slots() { return 1; }
+inline uint8_t rate_power() { return OUTPUT_POWER; }
+#endif
@@ -17,6 +17,12 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include "sd_card.h"
+#include "energy.h"
+#include "morse.h"
+#include "profile.h"
+
+static File logs[SD_LOGS];
+static uint8_t unsynced[SD_LOGS];
 
 bool sd_card_begin() {
     //SPI.begin();
@@ -27,17 +33,24 @@ bool sd_card_begin() {
         SPI.begin();
         return false;
     }
+    energy_set(ENERGY_SD_IDLE);
     return true;
 }
 
+// The card shares the SPI bus with the radio, so a callsign being keyed is let finish first
 bool sd_card_write_line(const char* filename, const char* data) {
+    morse_wait();
+    PROFILE_SCOPE(PROFILE_SD_WRITE);
+    energy_set(ENERGY_SD_BUSY);
     File dataFile = SD.open(filename, FILE_WRITE);
 
     if (dataFile) {
         dataFile.println(data);
         dataFile.close();
+        energy_set(ENERGY_SD_IDLE);
         return true;
     } else {
+        energy_set(ENERGY_SD_IDLE);
         return false;
     }
 }
@@ -59,3 +72,33 @@ bool sd_card_read_line(const char* filename, char* buffer, size_t bufferSize) {
         return false;
     }
 }
+
+// Opens a CSV log to append to for the rest of the flight. A new file gets the header row first.
+bool sd_card_log_begin(sd_card_log log, const char* filename, const char* header) {
+    logs[log] = SD.open(filename, FILE_WRITE);
+    if (!logs[log]) {
+        return false;
+    }
+    unsynced[log] = 0;
+    if (logs[log].size() == 0) {
+        return sd_card_log_line(log, header);
+    }
+    return true;
+}
+
+// Appends a row to an open CSV log. Like sd_card_write_line(), a callsign being keyed is let finish first.
+bool sd_card_log_line(sd_card_log log, const char* line) {
+    if (!logs[log]) {
+        return false;
+    }
+    morse_wait();
+    PROFILE_SCOPE(PROFILE_SD_WRITE);
+    energy_set(ENERGY_SD_BUSY);
+    bool ok = logs[log].println(line) > 0;
+    if (++unsynced[log] >= FLIGHT_LOG_SYNC_INTERVAL) {
+        logs[log].flush();
+        unsynced[log] = 0;
+    }
+    energy_set(ENERGY_SD_IDLE);
+    return ok;
+}
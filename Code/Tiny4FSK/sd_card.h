@@ -23,6 +23,19 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <SD.h>
 #include "config.h"
 
+// CSV logs kept open for the whole flight, so a row costs no FAT lookups. Each is flushed every
+// FLIGHT_LOG_SYNC_INTERVAL rows, so a reset loses at most that many.
+enum sd_card_log
+{
+  SD_LOG_DATALOG, // datalog.csv, with SD_CSV_LOG
+  SD_LOG_RATE,    // rate.csv, with ADAPTIVE_RATE
+  SD_LOG_CLOCK,   // clock.csv, with CLOCK_SCALING
+  SD_LOG_PROFILE, // profile.csv, with PROFILE_SD_LOG
+  SD_LOGS
+};
+
 bool sd_card_begin();
 bool sd_card_write_line(const char* filename, const char* data);
 bool sd_card_read_line(const char* filename, char* buffer, size_t bufferSize);
+bool sd_card_log_begin(sd_card_log log, const char* filename, const char* header);
+bool sd_card_log_line(sd_card_log log, const char* line);
@@ -25,73 +25,166 @@ bool imu_found = false;
 bool oled_found = false;
 bool sd_found = false;
 
-void i2c_scan(int *allAddresses)
+// Devices on the bus, as bits in the device map
+#define SHIELD_BME280 0x01
+#define SHIELD_IMU 0x02
+#define SHIELD_OLED 0x04
+
+#define SHIELD_CACHE_MAGIC 0x444C4853 // "SHLD"
+
+// The device map as saved in flash. Whole words only, to suit the flash page buffer.
+struct shield_cache
+{
+    uint32_t magic;
+    uint8_t devices;
+    uint8_t bme280_address;
+    uint8_t reserved[8];
+    uint16_t crc;
+};
+
+static_assert(sizeof(shield_cache) % 4 == 0, "The shield cache is written to flash a word at a time");
+
+// One flash row set aside in the sketch for the cache. Uploading a new sketch clears it.
+__attribute__((aligned(NVMCTRL_ROW_SIZE))) static const volatile uint8_t cache_row[NVMCTRL_ROW_SIZE] = {0};
+
+static uint32_t discovery_us = 0;
+static bool discovery_cached = false;
+
+static bool shield_cache_load(shield_cache *cache)
+{
+    memcpy(cache, (const void *)cache_row, sizeof(*cache));
+    return cache->magic == SHIELD_CACHE_MAGIC &&
+           cache->crc == (uint16_t)crc16((unsigned char *)cache, sizeof(*cache) - sizeof(cache->crc));
+}
+
+static void shield_cache_save(shield_cache *cache)
 {
-    byte address, error;
-    int devices = 0;
-    for (int i = 0; i < 127; i++)
+    uint32_t words[sizeof(*cache) / 4];
+    cache->magic = SHIELD_CACHE_MAGIC;
+    cache->crc = crc16((unsigned char *)cache, sizeof(*cache) - sizeof(cache->crc));
+    memcpy(words, cache, sizeof(words));
+
+    // Erase the row, then write the first page of it through the page buffer
+    NVMCTRL->CTRLB.bit.MANW = 1;
+    NVMCTRL->ADDR.reg = (uint32_t)cache_row / 2;
+    NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMDEX_KEY | NVMCTRL_CTRLA_CMD_ER;
+    while (!NVMCTRL->INTFLAG.bit.READY)
+        ;
+    NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMDEX_KEY | NVMCTRL_CTRLA_CMD_PBC;
+    while (!NVMCTRL->INTFLAG.bit.READY)
+        ;
+    volatile uint32_t *page = (volatile uint32_t *)cache_row;
+    for (uint8_t i = 0; i < sizeof(words) / 4; i++)
     {
-        allAddresses[i] = 0;
+        page[i] = words[i];
     }
-    for (address = 1; address < 127; address++)
-    {
-        Wire.beginTransmission(address);
-        error = Wire.endTransmission();
+    NVMCTRL->ADDR.reg = (uint32_t)cache_row / 2;
+    NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMDEX_KEY | NVMCTRL_CTRLA_CMD_WP;
+    while (!NVMCTRL->INTFLAG.bit.READY)
+        ;
+}
 
-        if (!error)
-        {
-            allAddresses[devices] = address;
-            devices++;
-        }
+// A reset from the watchdog, software or a brown-out keeps the same hardware attached.
+// Power-on and the reset button may not, as that is when the shield gets swapped.
+static bool shield_warm_boot()
+{
+    return !(PM->RCAUSE.reg & (PM_RCAUSE_POR | PM_RCAUSE_EXT));
+}
+
+// Looks for each known device at its own address only
+static uint8_t shield_probe(uint8_t *bme_address)
+{
+    uint8_t devices = 0;
+    if (i2c_dma_probe(BME_ADDRESS))
+    {
+        devices |= SHIELD_BME280;
+        *bme_address = BME_ADDRESS;
+    }
+    else if (i2c_dma_probe(BME_ADDRESS_ALT))
+    {
+        devices |= SHIELD_BME280;
+        *bme_address = BME_ADDRESS_ALT;
+    }
+    if (i2c_dma_probe(IMU_ADDRESS))
+    {
+        devices |= SHIELD_IMU;
     }
+    if (i2c_dma_probe(SSD1306_I2C_ADDRESS))
+    {
+        devices |= SHIELD_OLED;
+    }
+    return devices;
 }
 
+// Finds the I2C devices, from the cache after a warm boot, and initializes each one once.
+// Needs i2c_dma_begin() first.
 void initialize_shield()
 {
-    int sensors[127] = {0};
-    i2c_scan(sensors);
+    uint32_t start = micros();
+    shield_cache stored;
+    shield_cache cache;
+    bool stored_valid = shield_cache_load(&stored);
 
-    Serial.print("I2C addresses found: ");
-    for (int i = 0; i < 127; i++)
+    discovery_cached = false;
+#ifdef SHIELD_CACHE
+    if (stored_valid && shield_warm_boot())
     {
-        if (sensors[i] != 0)
-        {
-            Serial.print("0x");
-            if (sensors[i] < 16)
-                Serial.print("0");
-            Serial.print(sensors[i], HEX);
-            Serial.print(" ");
-        }
+        cache = stored;
+        discovery_cached = true;
     }
-    Serial.println();
+#endif
 
-    for (int i = 0; i < (sizeof(sensors) / sizeof(sensors[0])); i++)
+    // The BME280 checks its chip ID as it starts, which also confirms the cached map
+    if (discovery_cached && (cache.devices & SHIELD_BME280))
     {
-        if (sensors[i] == BME_ADDRESS)
-        {
-            bme280_found = true;
-        }
-        if (sensors[i] == IMU_ADDRESS)
+        bme280_found = bme280_begin(cache.bme280_address);
+        discovery_cached = bme280_found;
+    }
+    if (!discovery_cached)
+    {
+        memset(&cache, 0, sizeof(cache));
+        cache.devices = shield_probe(&cache.bme280_address);
+        if (cache.devices & SHIELD_BME280)
         {
-            imu_found = true;
+            bme280_found = bme280_begin(cache.bme280_address);
         }
-        if (sensors[i] == 0x3C)
+#ifdef SHIELD_CACHE
+        // Only touch the flash when something changed
+        if (!stored_valid || stored.devices != cache.devices || stored.bme280_address != cache.bme280_address)
         {
-            oled_found = true;
+            shield_cache_save(&cache);
         }
+#endif
     }
+    if (cache.devices & SHIELD_IMU)
+    {
+        imu_found = imu_begin(IMU_ADDRESS);
+    }
+    oled_found = cache.devices & SHIELD_OLED;
+    discovery_us = micros() - start;
 
+#ifdef DEV_MODE
+    Serial.print(discovery_cached ? "I2C devices from cache (" : "I2C devices probed (");
+    Serial.print(discovery_us);
+    Serial.print(" us):");
     if (bme280_found)
     {
-        // initialize bme!
-        Serial.println("BME280 found! Initializing...");
-        BME280setI2Caddress(BME_ADDRESS);
-        BME280setup();
+        Serial.print(" BME280 0x");
+        Serial.print(cache.bme280_address, HEX);
     }
+    if (imu_found)
+    {
+        Serial.print(" IMU");
+    }
+    if (oled_found)
+    {
+        Serial.print(" OLED");
+    }
+    Serial.println();
+#endif
 
     if (oled_found)
     {
-        Serial.println("OLED Found! Initializing...");
         oled_begin(128, 32);
         oled_clearDisplay();
         oled_setTextSize(1);
@@ -103,11 +196,26 @@ void initialize_shield()
 
     if (sd_card_begin())
     {
+#ifdef DEV_MODE
         Serial.println("SD Card Initialized!");
+#endif
         sd_found = true;
     }
     else
     {
+#ifdef DEV_MODE
         Serial.println("No SD Card Detected...");
+#endif
     }
 }
+
+// Time spent finding the I2C devices at boot, and whether the cached map was used
+uint32_t shield_discovery_us()
+{
+    return discovery_us;
+}
+
+bool shield_discovery_cached()
+{
+    return discovery_cached;
+}
@@ -20,9 +20,11 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #pragma once
 
 #include <Arduino.h>
-#include <Wire.h>
-#include <TinyBME280.h>
 #include "config.h"
+#include "crc_calc.h"
+#include "i2c_dma.h"
+#include "bme280.h"
+#include "imu.h"
 #include "oled.h"
 #include "sd_card.h"
 #define Serial SerialUSB
@@ -32,5 +34,6 @@ extern bool imu_found;
 extern bool oled_found;
 extern bool sd_found;
 
-void i2c_scan(int* allAddresses);
 void initialize_shield();
+uint32_t shield_discovery_us();
+bool shield_discovery_cached();
@@ -17,6 +17,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include "si4063.h"
+#include "energy.h"
 
 uint32_t current_frequency_hz = 434000000UL;
 uint32_t current_deviation_hz = 0;
@@ -58,6 +59,7 @@ int si4063_init(radio_parameters rp, chip_parameters cp)
     Serial.println("ERROR: Error powering up Si4063\n");
     return HAL_ERROR;
   }
+  energy_set(ENERGY_RADIO_READY);
 
   // Assume Si4063 part number
   uint16_t part = si4063_read_part_info();
@@ -575,6 +577,7 @@ uint16_t si4063_read_part_info()
 void si4063_set_state(si4063_state state)
 {
   si4063_send_command(SI4063_COMMAND_CHANGE_STATE, 1, (uint8_t *)&state);
+  energy_set(state == SI4063_STATE_TX ? ENERGY_RADIO_TX : state == SI4063_STATE_SLEEP ? ENERGY_RADIO_SLEEP : ENERGY_RADIO_READY);
 }
 
 int si4063_wait_for_cts()
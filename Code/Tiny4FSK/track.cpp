@@ -0,0 +1,173 @@
+/*
+track.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "track.h"
+
+#ifdef DEAD_RECKONING
+#include <math.h>
+#include <string.h>
+
+#define TRACK_LAT 0
+#define TRACK_LON 1
+#define TRACK_ALT 2
+#define TRACK_AXES 3
+
+#define TRACK_HALF_TURN_E7 1800000000LL
+
+// One axis of the filter: position, and velocity per second with 8 fractional bits
+struct track_axis
+{
+  int32_t x;
+  int32_t v_q8;
+};
+
+static track_axis axes[TRACK_AXES];
+static uint32_t fixes_in_track = 0;
+static uint32_t last_fix_ms = 0;
+static track_stats stats;
+
+void track_begin()
+{
+  memset(axes, 0, sizeof(axes));
+  memset(&stats, 0, sizeof(stats));
+  fixes_in_track = 0;
+}
+
+// Distance covered along an axis in dt_ms at its filtered velocity
+static int32_t track_move(const track_axis *axis, int32_t dt_ms)
+{
+  return (int64_t)axis->v_q8 * dt_ms / 256000;
+}
+
+// Longitudes go round, so differences and positions are kept within half a turn
+static int64_t track_wrap(int64_t lon_e7)
+{
+  if (lon_e7 > TRACK_HALF_TURN_E7)
+  {
+    return lon_e7 - 2 * TRACK_HALF_TURN_E7;
+  }
+  if (lon_e7 < -TRACK_HALF_TURN_E7)
+  {
+    return lon_e7 + 2 * TRACK_HALF_TURN_E7;
+  }
+  return lon_e7;
+}
+
+// fix_ms is the local time (cadence_millis()) the fix was taken
+void track_add_fix(double lat, double lon, double alt_m, uint32_t fix_ms)
+{
+  int32_t z[TRACK_AXES];
+  z[TRACK_LAT] = (int32_t)(lat * 1e7 + (lat < 0 ? -0.5 : 0.5));
+  z[TRACK_LON] = (int32_t)(lon * 1e7 + (lon < 0 ? -0.5 : 0.5));
+  z[TRACK_ALT] = (int32_t)(alt_m * 100 + (alt_m < 0 ? -0.5 : 0.5));
+
+  uint32_t dt_ms = fix_ms - last_fix_ms;
+  if (fixes_in_track > 0 && dt_ms < TRACK_MIN_DT_MS)
+  {
+    return;
+  }
+  if (fixes_in_track > 0 && dt_ms > TRACK_COAST_MS)
+  {
+    fixes_in_track = 0;
+    stats.restarts++;
+  }
+
+  for (uint8_t i = 0; i < TRACK_AXES; i++)
+  {
+    track_axis *axis = &axes[i];
+    if (fixes_in_track == 0)
+    {
+      axis->x = z[i];
+      axis->v_q8 = 0;
+      continue;
+    }
+    int64_t residual = (int64_t)z[i] - axis->x;
+    if (i == TRACK_LON)
+    {
+      residual = track_wrap(residual);
+    }
+    if (fixes_in_track == 1)
+    {
+      // Two fixes give the first velocity
+      axis->v_q8 = residual * 256000 / (int32_t)dt_ms;
+      axis->x = z[i];
+      continue;
+    }
+    int64_t predicted = (int64_t)axis->x + track_move(axis, dt_ms);
+    residual = (int64_t)z[i] - predicted;
+    if (i == TRACK_LON)
+    {
+      residual = track_wrap(residual);
+      predicted = track_wrap(predicted);
+    }
+    int64_t x = predicted + residual * TRACK_ALPHA / 256;
+    axis->x = i == TRACK_LON ? track_wrap(x) : x;
+    axis->v_q8 += residual * TRACK_BETA * 1000 / (int32_t)dt_ms;
+  }
+  last_fix_ms = fix_ms;
+  fixes_in_track++;
+  stats.fixes++;
+
+  // 1e-7 degrees of latitude is 1.11 cm, and of longitude that much less away from the equator
+  stats.north_cms = axes[TRACK_LAT].v_q8 / 256 * 1113 / 1000;
+  stats.east_cms = axes[TRACK_LON].v_q8 / 256 * 1113 / 1000 * cosf(axes[TRACK_LAT].x * 1e-7f * (float)M_PI / 180);
+  stats.ascent_cms = axes[TRACK_ALT].v_q8 / 256;
+}
+
+// How far the track moves between two local times, at the filtered velocity. False until the velocity
+// can be trusted, with no movement.
+bool track_ahead(uint32_t from_ms, uint32_t to_ms, track_position *movement)
+{
+  memset(movement, 0, sizeof(*movement));
+  if (fixes_in_track < TRACK_MIN_FIXES)
+  {
+    return false;
+  }
+  int32_t dt_ms = (int32_t)(to_ms - from_ms);
+  movement->lat_e7 = track_move(&axes[TRACK_LAT], dt_ms);
+  movement->lon_e7 = track_move(&axes[TRACK_LON], dt_ms);
+  movement->alt_cm = track_move(&axes[TRACK_ALT], dt_ms);
+  return true;
+}
+
+// The track carried forward from its last fix to a local time, for when the GPS has none. False if
+// there is no track to carry, or it has gone TRACK_COAST_MS without a fix.
+bool track_coast(uint32_t at_ms, track_position *position)
+{
+  uint32_t coast_ms = at_ms - last_fix_ms;
+  if (fixes_in_track < TRACK_MIN_FIXES || coast_ms > TRACK_COAST_MS)
+  {
+    return false;
+  }
+  position->lat_e7 = axes[TRACK_LAT].x + track_move(&axes[TRACK_LAT], coast_ms);
+  position->lon_e7 = track_wrap((int64_t)axes[TRACK_LON].x + track_move(&axes[TRACK_LON], coast_ms));
+  position->alt_cm = axes[TRACK_ALT].x + track_move(&axes[TRACK_ALT], coast_ms);
+  stats.dead_reckoned++;
+  if (coast_ms > stats.max_coast_ms)
+  {
+    stats.max_coast_ms = coast_ms;
+  }
+  return true;
+}
+
+const track_stats *track_get_stats()
+{
+  return &stats;
+}
+
+#endif
@@ -0,0 +1,80 @@
+/*
+track.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// DEAD RECKONING
+// An alpha-beta filter on each axis (latitude, longitude, altitude) follows position and velocity
+// from every GPS fix, in integers: positions in 1e-7 degrees and centimetres, velocities in those
+// units per second with 8 fractional bits. Each packet's position is given for the moment it goes
+// out, not the moment of the last fix: the fix is moved forward by the filtered velocity. If the GPS
+// has had no fix for TRACK_FIX_AGE_MS, the filtered track itself is carried forward instead, for up to
+// TRACK_COAST_MS, and the packet is flagged PACKET_FLAG_DEAD_RECKONED. After that the position is
+// given up as before. A gap of more than TRACK_COAST_MS between fixes starts the track again.
+// Without DEAD_RECKONING in config.h, packets carry the last fix as it is.
+// No hardware is touched here, so the same code runs on a computer (Tools/replay -o).
+#pragma once
+
+#include <stdint.h>
+#include "config.h"
+
+// Filter gains, in 1/256. Position follows the fixes closely, velocity over a few fixes.
+#define TRACK_ALPHA 192
+#define TRACK_BETA 64
+
+// Fixes this close together are one fix, reported twice
+#define TRACK_MIN_DT_MS 200
+
+// A fix older than this is stale, and the track is carried forward instead
+#define TRACK_FIX_AGE_MS 2500
+
+// Longest a track is carried without a fix
+#define TRACK_COAST_MS 60000UL
+
+// Fixes before the velocity is trusted for carrying the track
+#define TRACK_MIN_FIXES 3
+
+// A position, or with track_ahead() a movement
+struct track_position
+{
+  int32_t lat_e7; // 1e-7 degrees
+  int32_t lon_e7;
+  int32_t alt_cm;
+};
+
+struct track_stats
+{
+  uint32_t fixes;         // Fixes taken into the track
+  uint32_t restarts;      // Times the track started again after a long gap
+  uint32_t dead_reckoned; // Positions carried without a fresh fix
+  uint32_t max_coast_ms;  // Longest one was carried
+  int32_t north_cms;      // Filtered velocity, cm/s
+  int32_t east_cms;
+  int32_t ascent_cms;
+};
+
+#ifdef DEAD_RECKONING
+void track_begin();
+void track_add_fix(double lat, double lon, double alt_m, uint32_t fix_ms);
+bool track_ahead(uint32_t from_ms, uint32_t to_ms, track_position *movement);
+bool track_coast(uint32_t at_ms, track_position *position);
+const track_stats *track_get_stats();
+#else
+inline void track_begin() {}
+inline void track_add_fix(double lat, double lon, double alt_m, uint32_t fix_ms) {}
+inline bool track_ahead(uint32_t from_ms, uint32_t to_ms, track_position *movement) { return false; }
+inline bool track_coast(uint32_t at_ms, track_position *position) { return false; }
+#endif
@@ -24,14 +24,17 @@ double mapf(double x, double in_min, double in_max, double out_min, double out_m
   return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
 }
 
-// Send out the Morse Code callsign
+// Start the Morse Code callsign. It is keyed in the background, see morse.h.
 void sendCallsign()
 {
 #ifdef DEV_MODE
   Serial.println("Sending Morse Code Callsign!");
 #endif
+  // morse_start() keys the radio from READY, and with ULTRA_LOW_POWER it sleeps between packets
+  si4063_inhibit_tx();
+  si4063_wait_for_cts();
   si4063_set_frequency_offset(0);
-  sendMorseString(CALLSIGN);
+  morse_start();
 }
 
 // Configure the Si4063 to user values
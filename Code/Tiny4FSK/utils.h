@@ -26,7 +26,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #define Serial SerialUSB
 
-// Send out the Morse Code callsign
+// Start the Morse Code callsign, keyed in the background
 void sendCallsign();
 
 // Custom map function that supports floating-point mapping
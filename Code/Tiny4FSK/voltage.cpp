@@ -18,16 +18,159 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "voltage.h"
 
-double readVoltage() {
-  const int numReadings = 3; // Number of readings to average
-  double totalVoltage = 0.0;
-
-  for (int i = 0; i < numReadings; i++) {
-    int rawValue = analogRead(VOLTMETER_PIN); // Read ADC value
-    double voltage = rawValue * (3.3 / 1023.0) * 2; // Convert to voltage
-    totalVoltage += voltage; // Accumulate the voltage
-    delay(5); // Small delay for noise reduction (optional)
+enum voltage_phase
+{
+  VOLTAGE_IDLE,
+  VOLTAGE_BATTERY,
+  VOLTAGE_BANDGAP
+};
+
+static volatile voltage_phase phase = VOLTAGE_IDLE;
+static volatile uint16_t battery_raw = 0;
+static volatile uint16_t bandgap_raw = 0;
+static volatile bool measured = false;
+static uint32_t last_start_ms = 0;
+static uint8_t battery_mux = 0;
+
+#ifdef ARDUINO
+static_assert(VOLTAGE_MUX_BANDGAP == ADC_INPUTCTRL_MUXPOS_BANDGAP_Val, "Wrong bandgap input");
+
+static void voltage_select(uint8_t mux)
+{
+  ADC->INPUTCTRL.reg = ADC_INPUTCTRL_MUXPOS(mux) | ADC_INPUTCTRL_MUXNEG_GND | ADC_INPUTCTRL_GAIN_DIV2;
+  while (ADC->STATUS.bit.SYNCBUSY)
+    ;
+}
+
+static void voltage_trigger()
+{
+  ADC->SWTRIG.reg = ADC_SWTRIG_START;
+  while (ADC->STATUS.bit.SYNCBUSY)
+    ;
+}
+
+static uint16_t voltage_result()
+{
+  return ADC->RESULT.reg; // Also clears RESRDY
+}
+#else
+// Host builds convert on the spot, with the result the tool gives for the selected input
+uint16_t (*voltage_host_adc)(uint8_t mux) = NULL;
+static uint8_t host_mux = 0;
+
+static void voltage_select(uint8_t mux)
+{
+  host_mux = mux;
+}
+
+static void voltage_trigger()
+{
+  ADC_Handler();
+}
+
+static uint16_t voltage_result()
+{
+  return voltage_host_adc ? voltage_host_adc(host_mux) : 0;
+}
+#endif
+
+// One interrupt per averaged result: the battery first, then the bandgap
+void ADC_Handler()
+{
+  uint16_t result = voltage_result();
+  if (phase == VOLTAGE_BATTERY)
+  {
+    battery_raw = result;
+    phase = VOLTAGE_BANDGAP;
+    voltage_select(VOLTAGE_MUX_BANDGAP);
+    voltage_trigger();
+  }
+  else
+  {
+    bandgap_raw = result;
+    phase = VOLTAGE_IDLE;
+    measured = true;
+  }
+}
+
+void voltage_begin()
+{
+#ifdef ARDUINO
+  // Route the pin to the ADC, and the bandgap reference to the ADC input mux
+  pinPeripheral(VOLTMETER_PIN, PIO_ANALOG);
+  battery_mux = g_APinDescription[VOLTMETER_PIN].ulADCChannelNumber;
+  SYSCTRL->VREF.reg |= SYSCTRL_VREF_BGOUTEN;
+
+  ADC->CTRLA.reg &= ~ADC_CTRLA_ENABLE;
+  while (ADC->STATUS.bit.SYNCBUSY)
+    ;
+
+  // Reference is VDDANA / 2 and the input is halved too, so full scale is VDDANA.
+  // Both conversions share it, so VDDANA drops out of the ratio.
+  ADC->REFCTRL.reg = ADC_REFCTRL_REFSEL_INTVCC1;
+  ADC->CTRLB.reg = ADC_CTRLB_PRESCALER_DIV64 | ADC_CTRLB_RESSEL_16BIT;
+  ADC->SAMPCTRL.reg = ADC_SAMPCTRL_SAMPLEN(31); // Long sampling time for the divider's high impedance
+  ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM(VOLTAGE_SAMPLENUM) | ADC_AVGCTRL_ADJRES(VOLTAGE_ADJRES);
+  while (ADC->STATUS.bit.SYNCBUSY)
+    ;
+
+  ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY;
+  ADC->INTENSET.reg = ADC_INTENSET_RESRDY;
+  NVIC_EnableIRQ(ADC_IRQn);
+
+  ADC->CTRLA.reg |= ADC_CTRLA_ENABLE;
+  while (ADC->STATUS.bit.SYNCBUSY)
+    ;
+#endif
+}
+
+// Starts a measurement in the background, if one is not already running
+void voltage_start()
+{
+  if (phase != VOLTAGE_IDLE)
+  {
+    return;
+  }
+  last_start_ms = millis();
+  phase = VOLTAGE_BATTERY;
+  voltage_select(battery_mux);
+  voltage_trigger();
+}
+
+// Keeps a recent measurement on hand. Called from the gpsFeed task.
+void voltage_service()
+{
+  if (millis() - last_start_ms >= VOLTAGE_INTERVAL_MS || !measured)
+  {
+    voltage_start();
+  }
+}
+
+// Latest battery voltage in millivolts, from the ratio to the 1.1 V bandgap
+uint16_t voltage_mv()
+{
+  if (!measured)
+  {
+    // Nothing yet, so take one now. Only happens straight after boot.
+    voltage_start();
+    while (!measured)
+      ;
+  }
+  noInterrupts();
+  uint32_t battery = battery_raw;
+  uint32_t bandgap = bandgap_raw;
+  interrupts();
+
+  if (bandgap == 0)
+  {
+    return 0;
   }
+  return battery * VOLTAGE_DIVIDER * VOLTAGE_BANDGAP_MV / bandgap;
+}
 
-  return totalVoltage / numReadings; // Return the average voltage
-}
\ No newline at end of file
+// Battery voltage for the packet, 0-5 V as 0-255
+uint8_t voltage_packet_byte(uint16_t mv)
+{
+  uint32_t scaled = (uint32_t)mv * 51 / 1000;
+  return scaled > 255 ? 255 : scaled;
+}
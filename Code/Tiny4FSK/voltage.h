@@ -16,12 +16,43 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
-// Voltage reading function
-
+// BATTERY VOLTAGE
+// Measures the battery in the background. The ADC adds up 256 conversions by itself,
+// and ADC_Handler() runs once for the battery and once for the internal 1.1 V bandgap. The
+// battery voltage is then the ratio of the two, in integers, so it does not depend on the
+// supply voltage that the ADC reference comes from.
 #pragma once
 
 #include <stdint.h>
 #include "config.h"
 #include <Arduino.h>
+#include <wiring_private.h>
+
+// 2^8 = 256 samples. The ADC shifts the 20-bit sum down to 16 bits by itself, so no further
+// adjustment is needed: a 16-bit oversampled result rather than a 12-bit average.
+#define VOLTAGE_SAMPLENUM 8
+#define VOLTAGE_ADJRES 0
+
+// The battery goes through a 1:2 divider to VOLTMETER_PIN
+#define VOLTAGE_DIVIDER 2
+
+// Nominal bandgap voltage
+#define VOLTAGE_BANDGAP_MV 1100
+
+// Measure this often between packets
+#define VOLTAGE_INTERVAL_MS 1000
+
+// ADC input of the bandgap reference
+#define VOLTAGE_MUX_BANDGAP 0x19
+
+#ifndef ARDUINO
+// Host builds have no ADC. The tool returns the 16-bit result for each input instead.
+extern uint16_t (*voltage_host_adc)(uint8_t mux);
+#endif
 
-double readVoltage();
\ No newline at end of file
+void ADC_Handler();
+void voltage_begin();
+void voltage_start();
+void voltage_service();
+uint16_t voltage_mv();
+uint8_t voltage_packet_byte(uint16_t mv);
@@ -0,0 +1,304 @@
+/*
+bench_ascent.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Compares the windowed least-squares ascent rate (ascent.cpp) with the two-point difference the
+// tracker used before, on the recorded flights, and times both. Runs on a computer, not the tracker.
+// Build and run from this folder with:
+//
+//   $ make bench_ascent
+//   $ ./bench_ascent [log.csv ...]
+//
+// With no logs given, the three test flights in Media/Data are used. Each received packet's time and
+// altitude is one fix, a few seconds apart. The same flight is also resampled to a fix a second, as
+// the GPS gives them, across reception gaps up to RESAMPLE_GAP_S, with NOISE_M of random altitude
+// noise. The reference rate at each fix is the least-squares slope of the altitudes (without the
+// noise) within REFERENCE_S either side, which neither estimator can see. The error is against it,
+// and the jitter is the change from one estimate to the next. Both are run again with a GPS glitch
+// (GLITCH_M up) every GLITCH_EVERY fixes.
+// Times on a computer only compare with each other. On the Cortex-M0+ the two-point difference needs
+// a software float division and conversions, and the window a software 64-bit division.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "ascent.h"
+
+#define REFERENCE_S 60
+#define RESAMPLE_GAP_S 30
+#define NOISE_M 2.0
+#define GLITCH_M 300
+#define GLITCH_EVERY 50
+#define ROUNDS 200
+
+struct fix
+{
+  int64_t seconds; // GPS time, seconds since 1970
+  double altitude;
+};
+
+// The datetime and alt columns of a horusdemodlib CSV log, in time order
+static bool log_read(const char *filename, std::vector<fix> *fixes)
+{
+  FILE *file = fopen(filename, "r");
+  if (!file)
+  {
+    fprintf(stderr, "Could not open %s\n", filename);
+    return false;
+  }
+  char line[2048];
+  int datetime = -1, alt = -1;
+  if (fgets(line, sizeof(line), file))
+  {
+    int column = 0;
+    for (char *name = strtok(line, ",\r\n"); name; name = strtok(NULL, ",\r\n"), column++)
+    {
+      datetime = strcmp(name, "datetime") ? datetime : column;
+      alt = strcmp(name, "alt") ? alt : column;
+    }
+  }
+  if (datetime < 0 || alt < 0)
+  {
+    fprintf(stderr, "%s has no datetime or alt column\n", filename);
+    fclose(file);
+    return false;
+  }
+  while (fgets(line, sizeof(line), file))
+  {
+    // Neither column is quoted, so splitting on commas finds them
+    fix f;
+    struct tm t;
+    memset(&t, 0, sizeof(t));
+    int found = 0;
+    char *field = line;
+    for (int column = 0; field && found < 2; column++)
+    {
+      if (column == datetime && sscanf(field, "%d-%d-%dT%d:%d:%d", &t.tm_year, &t.tm_mon, &t.tm_mday, &t.tm_hour,
+                                       &t.tm_min, &t.tm_sec) == 6)
+      {
+        t.tm_year -= 1900;
+        t.tm_mon -= 1;
+        f.seconds = timegm(&t);
+        found++;
+      }
+      if (column == alt)
+      {
+        f.altitude = atof(field);
+        found++;
+      }
+      field = strchr(field, ',');
+      field = field ? field + 1 : NULL;
+    }
+    if (found == 2 && f.altitude > 0 && f.altitude < 50000)
+    {
+      fixes->push_back(f);
+    }
+  }
+  fclose(file);
+  std::stable_sort(fixes->begin(), fixes->end(), [](const fix &a, const fix &b)
+                   { return a.seconds < b.seconds; });
+  fixes->erase(std::unique(fixes->begin(), fixes->end(), [](const fix &a, const fix &b)
+                           { return a.seconds == b.seconds; }),
+               fixes->end());
+  return true;
+}
+
+static std::vector<double> reference_rates(const std::vector<fix> &fixes)
+{
+  std::vector<double> rates(fixes.size());
+  size_t first = 0, last = 0;
+  for (size_t i = 0; i < fixes.size(); i++)
+  {
+    while (fixes[i].seconds - fixes[first].seconds > REFERENCE_S)
+    {
+      first++;
+    }
+    while (last + 1 < fixes.size() && fixes[last + 1].seconds - fixes[i].seconds <= REFERENCE_S)
+    {
+      last++;
+    }
+    double n = 0, st = 0, sa = 0, stt = 0, sta = 0;
+    for (size_t j = first; j <= last; j++)
+    {
+      double t = fixes[j].seconds - fixes[i].seconds;
+      n++;
+      st += t;
+      sa += fixes[j].altitude;
+      stt += t * t;
+      sta += t * fixes[j].altitude;
+    }
+    double den = n * stt - st * st;
+    rates[i] = den > 0 ? (n * sta - st * sa) / den : 0;
+  }
+  return rates;
+}
+
+// As build_horus_binary_packet_v2() did it: the altitude change since the last packet over the time
+// between them, in float
+static void two_point(const std::vector<fix> &fixes, std::vector<double> *rates)
+{
+  float prev_altitude = 0.0f;
+  unsigned long prev_time = 0;
+  for (size_t i = 0; i < fixes.size(); i++)
+  {
+    float altitude = fixes[i].altitude;
+    unsigned long now = (unsigned long)(fixes[i].seconds - fixes[0].seconds) * 1000 + 1000;
+    float ascent_rate = 0.0f;
+    if (prev_time != 0)
+    {
+      unsigned long time_diff = now - prev_time;
+      if (time_diff > 0)
+      {
+        ascent_rate = (altitude - prev_altitude) / (time_diff / 1000.0f);
+      }
+    }
+    prev_altitude = altitude;
+    prev_time = now;
+    (*rates)[i] = (int16_t)(ascent_rate * 100) / 100.0;
+  }
+}
+
+static void window(const std::vector<fix> &fixes, std::vector<double> *rates)
+{
+  ascent_begin();
+  for (size_t i = 0; i < fixes.size(); i++)
+  {
+    int seconds = fixes[i].seconds % 86400;
+    ascent_add(seconds / 3600, seconds / 60 % 60, seconds % 60, 0, lround(fixes[i].altitude * 100));
+    (*rates)[i] = ascent_cms() / 100.0;
+  }
+}
+
+// A fix every second between logged fixes, without the noise, which is added once the reference is taken
+static std::vector<fix> resample(const std::vector<fix> &fixes)
+{
+  std::vector<fix> out;
+  for (size_t i = 0; i + 1 < fixes.size(); i++)
+  {
+    const fix &a = fixes[i], &b = fixes[i + 1];
+    int64_t gap = b.seconds - a.seconds;
+    for (int64_t t = 0; t < (gap <= RESAMPLE_GAP_S ? gap : 1); t++)
+    {
+      fix f = {a.seconds + t, a.altitude + (b.altitude - a.altitude) * t / gap};
+      out.push_back(f);
+    }
+  }
+  out.push_back(fixes.back());
+  return out;
+}
+
+static void add_noise(std::vector<fix> *fixes)
+{
+  srand(1);
+  for (fix &f : *fixes)
+  {
+    // Box-Muller
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    f.altitude += NOISE_M * sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+  }
+}
+
+static double seconds_now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void compare(const char *name, void (*estimate)(const std::vector<fix> &, std::vector<double> *),
+                    const std::vector<fix> &fixes, const std::vector<double> &reference, bool glitched)
+{
+  std::vector<double> rates(fixes.size());
+  estimate(fixes, &rates);
+  double error = 0, jitter = 0, worst = 0;
+  for (size_t i = 1; i < fixes.size(); i++)
+  {
+    double e = rates[i] - reference[i];
+    error += e * e;
+    worst = std::max(worst, fabs(e));
+    jitter += (rates[i] - rates[i - 1]) * (rates[i] - rates[i - 1]);
+  }
+  size_t n = fixes.size() - 1;
+
+  double ns = 0;
+  if (!glitched)
+  {
+    double start = seconds_now();
+    for (int r = 0; r < ROUNDS; r++)
+    {
+      estimate(fixes, &rates);
+    }
+    ns = (seconds_now() - start) / ((double)ROUNDS * fixes.size()) * 1e9;
+  }
+  printf("    %-10s %-9s error RMS %6.2f m/s, max %6.1f m/s, jitter RMS %6.2f m/s", name, glitched ? "glitches" : "clean",
+         sqrt(error / n), worst, sqrt(jitter / n));
+  if (ns)
+  {
+    printf(", %5.1f ns/fix", ns);
+  }
+  printf("\n");
+}
+
+static void run_set(const char *name, std::vector<fix> fixes, const std::vector<double> &reference)
+{
+  printf("  %s, %zu fixes\n", name, fixes.size());
+  compare("two-point", two_point, fixes, reference, false);
+  compare("window", window, fixes, reference, false);
+  for (size_t i = GLITCH_EVERY; i < fixes.size(); i += GLITCH_EVERY)
+  {
+    fixes[i].altitude += GLITCH_M;
+  }
+  compare("two-point", two_point, fixes, reference, true);
+  compare("window", window, fixes, reference, true);
+  printf("    window: %u glitches, %u fixes left out, %u restarts\n", (unsigned)((fixes.size() - 1) / GLITCH_EVERY),
+         ascent_get_stats()->rejected, ascent_get_stats()->restarts);
+}
+
+int main(int argc, char **argv)
+{
+  static const char *default_logs[] = {"../Media/Data/TestFlight6-21-25.csv", "../Media/Data/TestFlight2-5-21-25.csv",
+                                       "../Media/Data/IMUFlightTest.csv"};
+  std::vector<const char *> logs(argv + 1, argv + argc);
+  if (logs.empty())
+  {
+    logs.assign(default_logs, default_logs + sizeof(default_logs) / sizeof(default_logs[0]));
+  }
+
+  bool ok = true;
+  for (const char *filename : logs)
+  {
+    std::vector<fix> fixes;
+    if (!log_read(filename, &fixes) || fixes.size() < 2)
+    {
+      ok = false;
+      continue;
+    }
+    const char *name = strrchr(filename, '/') ? strrchr(filename, '/') + 1 : filename;
+    printf("%s: %lld s of flight\n", name, (long long)(fixes.back().seconds - fixes[0].seconds));
+    std::vector<fix> resampled = resample(fixes);
+    std::vector<double> resampled_reference = reference_rates(resampled);
+    add_noise(&resampled);
+    run_set("as logged", fixes, reference_rates(fixes));
+    run_set("1 Hz", resampled, resampled_reference);
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+/*
+bench_csv.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Checks the integer CSV writer (datalog_csv.cpp) against the same row written with snprintf, and
+// times both. Runs on a computer, not the tracker. Build and run from this folder with:
+//
+//   $ make bench_csv
+//   $ ./bench_csv
+//
+// The reference scales each field the way packet.h says, in floating point. The old snprintf format
+// divided ExtTemp and ExtPress in integers and printed the battery byte unscaled.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "datalog_csv.h"
+
+#define PACKETS 4096
+#define ROUNDS 50
+
+static HorusBinaryPacketV2 packets[PACKETS];
+
+static float random_float(float range)
+{
+  return ((float)rand() / RAND_MAX * 2.0f - 1.0f) * range;
+}
+
+static int reference_row(char *out, size_t size, const HorusBinaryPacketV2 &p)
+{
+  return snprintf(out, size, "%u,%u,%u,%u,%u,%.7f,%.7f,%u,%u,%u,%d,%.2f,%.2f,%.1f,%u,%.1f,%.1f,%u",
+                  p.PayloadID, p.Counter, p.Hours, p.Minutes, p.Seconds, p.Latitude, p.Longitude,
+                  p.Altitude, p.Speed, p.Sats, p.Temp, p.BattVoltage * 5.0 / 255, p.AscentRate / 100.0,
+                  p.ExtTemp / 10.0, p.Humidity, p.ExtPress / 10.0, p.dummy1 / 10.0, p.dummy2);
+}
+
+static double seconds_now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main()
+{
+  srand(1);
+  for (int i = 0; i < PACKETS; i++)
+  {
+    HorusBinaryPacketV2 &p = packets[i];
+    memset(&p, 0, sizeof(p));
+    p.PayloadID = rand();
+    p.Counter = rand();
+    p.Hours = rand() % 24;
+    p.Minutes = rand() % 60;
+    p.Seconds = rand() % 60;
+    p.Latitude = random_float(90.0f);
+    p.Longitude = random_float(180.0f);
+    p.Altitude = rand();
+    p.Speed = rand();
+    p.Sats = rand() % 32;
+    p.Temp = rand();
+    p.BattVoltage = rand();
+    p.AscentRate = rand();
+    p.ExtTemp = rand();
+    p.Humidity = rand();
+    p.ExtPress = rand();
+    p.dummy1 = rand();
+    p.dummy2 = rand();
+  }
+  // Awkward values: exact rounding ties, tiny negatives and zeros
+  packets[0].Latitude = 0.00390625f;
+  packets[0].Longitude = -0.00000001f;
+  packets[1].Latitude = -0.0f;
+  packets[1].Longitude = 0.0f;
+  packets[2].Latitude = 89.99999999f;
+  packets[2].Longitude = -179.99999f;
+
+  // Byte for byte comparison
+  char expected[DATALOG_MAX_ROW], actual[DATALOG_MAX_ROW];
+  int mismatches = 0;
+  for (int i = 0; i < PACKETS; i++)
+  {
+    reference_row(expected, sizeof(expected), packets[i]);
+    datalog_csv_row(actual, packets[i]);
+    if (strcmp(expected, actual) != 0)
+    {
+      if (mismatches++ < 5)
+      {
+        printf("mismatch:\n  snprintf: %s\n  datalog:  %s\n", expected, actual);
+      }
+    }
+  }
+  printf("header: %s\n", DATALOG_HEADER);
+  printf("%d rows compared, %d mismatches\n", PACKETS, mismatches);
+
+  // Timing
+  volatile int sink = 0;
+  double start = seconds_now();
+  for (int r = 0; r < ROUNDS; r++)
+    for (int i = 0; i < PACKETS; i++)
+      sink += reference_row(expected, sizeof(expected), packets[i]);
+  double snprintf_ns = (seconds_now() - start) / (ROUNDS * PACKETS) * 1e9;
+
+  start = seconds_now();
+  for (int r = 0; r < ROUNDS; r++)
+    for (int i = 0; i < PACKETS; i++)
+      sink += datalog_csv_row(actual, packets[i]);
+  double datalog_ns = (seconds_now() - start) / (ROUNDS * PACKETS) * 1e9;
+
+  printf("snprintf:    %8.1f ns/row\n", snprintf_ns);
+  printf("datalog_csv: %8.1f ns/row (%.1fx faster)\n", datalog_ns, snprintf_ns / datalog_ns);
+  return mismatches != 0;
+}
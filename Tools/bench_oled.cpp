@@ -0,0 +1,249 @@
+/*
+bench_oled.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Checks the OLED column-blit text renderer (oled.cpp) against the pixel-by-pixel renderer it
+// replaced, and times both. Runs on a computer, not the tracker. Build and run from this folder with:
+//
+//   $ make bench_oled
+//   $ ./bench_oled
+//
+// The panel is modelled from the I2C traffic, so the comparison also covers the partial refresh.
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "oled.h"
+#include "font.h"
+
+#define WIDTH 128
+#define HEIGHT 64
+#define ROUNDS 20000
+
+// SSD1306 in horizontal addressing mode, just the commands oled.cpp sends
+static uint8_t panel[WIDTH * HEIGHT / 8];
+static uint8_t column_start, column_end, page_start, page_end, column, page;
+static uint8_t command, params_left, params[2];
+
+// oled.cpp reports refreshes to the energy accounting, which is never started here
+unsigned long micros()
+{
+  return (unsigned long)clock() * 1000000 / CLOCKS_PER_SEC;
+}
+
+static uint8_t command_params(uint8_t cmd)
+{
+  switch (cmd)
+  {
+  case 0x21:
+  case 0x22:
+    return 2;
+  case 0x20:
+  case 0x81:
+  case 0x8D:
+  case 0xA8:
+  case 0xD3:
+  case 0xD5:
+  case 0xD9:
+  case 0xDA:
+  case 0xDB:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+static void panel_write(uint8_t address, const uint8_t *data, size_t length)
+{
+  if (address != SSD1306_I2C_ADDRESS || length < 1)
+  {
+    return;
+  }
+  for (size_t i = 1; i < length; i++)
+  {
+    if (data[0] == 0x40)
+    {
+      panel[page * WIDTH + column] = data[i];
+      if (column++ == column_end)
+      {
+        column = column_start;
+        page = page == page_end ? page_start : page + 1;
+      }
+    }
+    else if (params_left)
+    {
+      params[2 - params_left--] = data[i];
+      if (!params_left && command == 0x21)
+      {
+        column_start = column = params[0];
+        column_end = params[1];
+      }
+      else if (!params_left && command == 0x22)
+      {
+        page_start = page = params[0];
+        page_end = params[1];
+      }
+    }
+    else
+    {
+      command = data[i];
+      params_left = command_params(command);
+    }
+  }
+}
+
+// The old renderer, one bounds-checked pixel at a time
+static void old_drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint8_t size)
+{
+  if (c < ' ' || c > '~')
+  {
+    c = '?';
+  }
+  for (int8_t i = 0; i < 5; i++)
+  {
+    uint8_t line = font[(c - ' ') * 5 + i];
+    for (int8_t j = 0; j < 8; j++)
+    {
+      if (line & 0x1)
+      {
+        if (size == 1)
+        {
+          oled_drawPixel(x + i, y + j, color);
+        }
+        else
+        {
+          for (int16_t k = 0; k < size; k++)
+          {
+            for (int16_t l = 0; l < size; l++)
+            {
+              oled_drawPixel(x + i * size + k, y + j * size + l, color);
+            }
+          }
+        }
+      }
+      line >>= 1;
+    }
+  }
+}
+
+static void old_print(int16_t x, int16_t y, const char *str, uint16_t color, uint8_t size)
+{
+  while (*str)
+  {
+    old_drawChar(x, y, *str++, color, size);
+    x += size * 6;
+    if (x > WIDTH - size * 6)
+    {
+      x = 0;
+      y += size * 8;
+    }
+  }
+}
+
+static void new_print(int16_t x, int16_t y, const char *str, uint16_t color, uint8_t size)
+{
+  oled_setCursor(x, y);
+  oled_setTextColor(color);
+  oled_setTextSize(size);
+  oled_print(str);
+}
+
+struct test_case
+{
+  int16_t x, y;
+  uint8_t size;
+  uint16_t color;
+};
+
+static const char *text = "Lat: 42.360082 Alt: 31234.5 ~{}|";
+
+static const test_case cases[] = {
+    {0, 0, 1, 1}, {3, 8, 1, 1}, {0, 5, 1, 1}, {-3, -4, 1, 1}, {124, 60, 1, 1}, {0, 16, 2, 1},
+    {1, 13, 2, 1}, {-5, -9, 2, 1}, {0, 3, 3, 1}, {2, 8, 1, 0}, {0, 11, 2, 0}};
+
+static bool check(const test_case &t)
+{
+  uint8_t expected[sizeof(panel)];
+
+  // Fill the screen first so clearing pixels (color 0) shows up too
+  for (int pass = 0; pass < 2; pass++)
+  {
+    oled_clearDisplay();
+    for (int16_t x = 0; x < WIDTH; x += 2)
+    {
+      for (int16_t y = 0; y < HEIGHT; y++)
+      {
+        oled_drawPixel(x, y, t.color == 0);
+      }
+    }
+    if (pass == 0)
+    {
+      old_print(t.x, t.y, text, t.color, t.size);
+    }
+    else
+    {
+      new_print(t.x, t.y, text, t.color, t.size);
+    }
+    oled_display();
+    if (pass == 0)
+    {
+      memcpy(expected, panel, sizeof(panel));
+    }
+  }
+  return memcmp(expected, panel, sizeof(panel)) == 0;
+}
+
+static double time_glyphs(void (*print)(int16_t, int16_t, const char *, uint16_t, uint8_t), int16_t y, uint8_t size)
+{
+  size_t length = strlen(text);
+  clock_t start = clock();
+  for (int round = 0; round < ROUNDS; round++)
+  {
+    oled_clearDisplay();
+    print(0, y, text, 1, size);
+  }
+  double ms = (double)(clock() - start) * 1000 / CLOCKS_PER_SEC;
+  return ROUNDS * length / ms;
+}
+
+int main()
+{
+  wire_host_on_write = panel_write;
+  if (!oled_begin(WIDTH, HEIGHT))
+  {
+    fprintf(stderr, "oled_begin failed\n");
+    return 1;
+  }
+
+  int failures = 0;
+  for (const test_case &t : cases)
+  {
+    if (!check(t))
+    {
+      printf("MISMATCH x=%d y=%d size=%d color=%d\n", t.x, t.y, t.size, t.color);
+      failures++;
+    }
+  }
+  printf("%d of %d layouts match the old renderer\n", (int)(sizeof(cases) / sizeof(cases[0])) - failures,
+         (int)(sizeof(cases) / sizeof(cases[0])));
+
+  printf("%-24s %12s %12s\n", "glyphs/ms", "old", "new");
+  printf("%-24s %12.0f %12.0f\n", "size 1, page aligned", time_glyphs(old_print, 8, 1), time_glyphs(new_print, 8, 1));
+  printf("%-24s %12.0f %12.0f\n", "size 1, unaligned", time_glyphs(old_print, 5, 1), time_glyphs(new_print, 5, 1));
+  printf("%-24s %12.0f %12.0f\n", "size 2", time_glyphs(old_print, 16, 2), time_glyphs(new_print, 16, 2));
+  return failures ? 1 : 0;
+}
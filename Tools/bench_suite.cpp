@@ -0,0 +1,542 @@
+/*
+bench_suite.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Times the tracker's hardware-independent hot paths on a computer: the Golay code, interleaver,
+// scrambler and CRCs of horus_l2.cpp, the whole packet encode and decode, the OLED text renderer and
+// the CSV writer. Build and run from this folder with:
+//
+//   $ make bench_suite
+//   $ ./bench_suite [-t seconds] [-r repetitions] [-f filter] [-o results.json] [-c baseline.json] [-p percent]
+//
+// Like Google Benchmark, each benchmark is run for more and more iterations until one run takes
+// -t seconds (0.2 by default), then repeated -r times (5), and the median time per iteration is kept.
+// -f runs only the benchmarks whose name contains the filter. -o writes the results as JSON, in the
+// layout Google Benchmark uses, so its compare.py can read them too. -c compares against an earlier
+// JSON file, and exits with 1 if any benchmark got more than -p percent (10) slower.
+// Times on a computer only compare with each other: the tracker's Cortex-M0+ is a different machine.
+// The packet builder is timed by replay.cpp, and the morse keyer runs from a timer interrupt, so
+// neither is here.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include "horus_l2.h"
+#include "crc_calc.h"
+#include "oled.h"
+#include "datalog_csv.h"
+
+// Not in horus_l2.h, but not static either
+int32_t get_syndrome(int32_t pattern);
+void golay23_init(void);
+int golay23_encode(int data);
+int golay23_decode(int received_codeword);
+unsigned short gen_crc16(unsigned char *data_p, unsigned char length);
+void interleave(unsigned char *inout, int nbytes, int dir);
+void scramble(unsigned char *inout, int nbytes);
+
+// oled.cpp reports refreshes to the energy accounting, which is never started here
+unsigned long micros()
+{
+  return (unsigned long)clock() * 1000000 / CLOCKS_PER_SEC;
+}
+
+// Keeps the compiler from dropping a result, or a store to memory, that nothing reads
+template <typename T>
+static inline void keep(const T &value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#define PACKET_BYTES ((int)sizeof(HorusBinaryPacketV2))
+#define PACKETS 256
+
+static HorusBinaryPacketV2 packets[PACKETS];
+static unsigned char coded[PACKETS][128];
+static int coded_bytes;
+static int codewords[4096];
+
+static void setup_data()
+{
+  srand(1);
+  for (int i = 0; i < PACKETS; i++)
+  {
+    unsigned char *bytes = (unsigned char *)&packets[i];
+    for (int j = 0; j < PACKET_BYTES; j++)
+    {
+      bytes[j] = rand();
+    }
+    packets[i].Latitude = ((float)rand() / RAND_MAX * 2.0f - 1.0f) * 90.0f;
+    packets[i].Longitude = ((float)rand() / RAND_MAX * 2.0f - 1.0f) * 180.0f;
+    packets[i].Checksum = crc16(bytes, PACKET_BYTES - 2);
+    coded_bytes = horus_l2_encode_tx_packet(coded[i], bytes, PACKET_BYTES);
+  }
+
+  // Codewords with 0 to 3 bit errors, all of which the decoder corrects
+  golay23_init();
+  for (int data = 0; data < 4096; data++)
+  {
+    int codeword = golay23_encode(data);
+    for (int e = rand() % 4; e > 0; e--)
+    {
+      codeword ^= 1 << (rand() % 23);
+    }
+    codewords[data] = codeword;
+  }
+}
+
+// A benchmark of broken code is no use, so the results are checked once before any timing
+static bool check_data()
+{
+  for (int data = 0; data < 4096; data++)
+  {
+    if (golay23_decode(codewords[data]) >> 11 != data)
+    {
+      fprintf(stderr, "golay23_decode failed for 0x%03X\n", data);
+      return false;
+    }
+  }
+  for (int i = 0; i < PACKETS; i++)
+  {
+    unsigned char buffer[128];
+    unsigned char payload[PACKET_BYTES];
+    memcpy(buffer, coded[i], coded_bytes);
+    horus_l2_decode_rx_packet(payload, buffer, PACKET_BYTES);
+    if (memcmp(payload, &packets[i], PACKET_BYTES) != 0)
+    {
+      fprintf(stderr, "Packet %d did not decode to what was encoded\n", i);
+      return false;
+    }
+  }
+  return true;
+}
+
+// ****************
+// || Benchmarks ||
+// ****************
+
+static void bench_golay_encode(uint64_t iterations)
+{
+  for (uint64_t i = 0; i < iterations; i++)
+  {
+    keep(golay23_encode(i & 0xFFF));
+  }
+}
+
+// What horus_l2_encode_tx_packet() does for each codeword, without the table
+static void bench_golay_syndrome(uint64_t iterations)
+{
+  for (uint64_t i = 0; i < iterations; i++)
+  {
+    keep(get_syndrome((int32_t)(i & 0xFFF) << 11));
+  }
+}
+
+static void bench_golay_decode(uint64_t iterations)
+{
+  for (uint64_t i = 0; i < iterations; i++)
+  {
+    keep(golay23_decode(codewords[i & 0xFFF]));
+  }
+}
+
+// The unique word is not interleaved or scrambled
+static void bench_interleave(uint64_t iterations)
+{
+  unsigned char buffer[128];
+  memcpy(buffer, coded[0], coded_bytes);
+  for (uint64_t i = 0; i < iterations; i++)
+  {
+    interleave(buffer + 2, coded_bytes - 2, i & 1);
+    keep(buffer);
+  }
+}
+
+static void bench_scramble(uint64_t iterations)
+{
+  unsigned char buffer[128];
+  memcpy(buffer, coded[0], coded_bytes);
+  for (uint64_t i = 0; i < iterations; i++)
+  {
+    scramble(buffer + 2, coded_bytes - 2);
+    keep(buffer);
+  }
+}
+
+static void bench_crc16(uint64_t iterations)
+{
+  for (uint64_t i = 0; i < iterations; i++)
+  {
+    keep(crc16((unsigned char *)&packets[i % PACKETS], PACKET_BYTES - 2));
+  }
+}
+
+static void bench_gen_crc16(uint64_t iterations)
+{
+  for (uint64_t i = 0; i < iterations; i++)
+  {
+    keep(gen_crc16((unsigned char *)&packets[i % PACKETS], PACKET_BYTES - 2));
+  }
+}
+
+static void bench_packet_encode(uint64_t iterations)
+{
+  unsigned char buffer[128];
+  for (uint64_t i = 0; i < iterations; i++)
+  {
+    keep(horus_l2_encode_tx_packet(buffer, (unsigned char *)&packets[i % PACKETS], PACKET_BYTES));
+    keep(buffer);
+  }
+}
+
+static void bench_packet_decode(uint64_t iterations)
+{
+  unsigned char buffer[128];
+  unsigned char payload[PACKET_BYTES];
+  for (uint64_t i = 0; i < iterations; i++)
+  {
+    // The decoder works in place on its input
+    memcpy(buffer, coded[i % PACKETS], coded_bytes);
+    horus_l2_decode_rx_packet(payload, buffer, PACKET_BYTES);
+    keep(payload);
+  }
+}
+
+static void bench_glyph(uint64_t iterations)
+{
+  oled_setTextSize(1);
+  for (uint64_t i = 0; i < iterations; i++)
+  {
+    char text[2] = {(char)(' ' + i % 95), 0};
+    oled_setCursor((i * 6) % 120, (i / 20 * 8) % 24);
+    oled_print(text);
+  }
+}
+
+// The tracker's own screen, as build_horus_binary_packet_v2() draws it
+static void bench_oled_screen(uint64_t iterations)
+{
+  for (uint64_t i = 0; i < iterations; i++)
+  {
+    const HorusBinaryPacketV2 &p = packets[i % PACKETS];
+    oled_clearDisplay();
+    oled_setCursor(0, 0);
+    oled_print_fixed("Sats", p.Sats, 0);
+    oled_print_diagnostic("Lat", p.Latitude, 6);
+    oled_print_diagnostic("Lon", p.Longitude, 6);
+    oled_print_fixed("Alt", p.Altitude * 10L, 1);
+  }
+}
+
+static void bench_csv_row(uint64_t iterations)
+{
+  char row[DATALOG_MAX_ROW];
+  for (uint64_t i = 0; i < iterations; i++)
+  {
+    keep(datalog_csv_row(row, packets[i % PACKETS]));
+    keep(row);
+  }
+}
+
+struct benchmark
+{
+  const char *name;
+  void (*run)(uint64_t iterations);
+  int bytes; // Processed per iteration, for a throughput. 0 for none, -1 for a coded packet.
+};
+
+static const benchmark benchmarks[] = {
+    {"golay23_encode", bench_golay_encode, 0},
+    {"golay23_syndrome", bench_golay_syndrome, 0},
+    {"golay23_decode", bench_golay_decode, 0},
+    {"interleave", bench_interleave, -1},
+    {"scramble", bench_scramble, -1},
+    {"crc16", bench_crc16, PACKET_BYTES - 2},
+    {"gen_crc16", bench_gen_crc16, PACKET_BYTES - 2},
+    {"packet_encode", bench_packet_encode, PACKET_BYTES},
+    {"packet_decode", bench_packet_decode, PACKET_BYTES},
+    {"oled_glyph", bench_glyph, 0},
+    {"oled_screen", bench_oled_screen, 0},
+    {"csv_row", bench_csv_row, 0},
+};
+
+// ************
+// || Runner ||
+// ************
+
+struct result
+{
+  const char *name;
+  uint64_t iterations;
+  double real_ns; // Per iteration, median of the repetitions
+  double cpu_ns;
+  double bytes_per_second;
+};
+
+static double seconds(clockid_t clock)
+{
+  timespec t;
+  clock_gettime(clock, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static double median(std::vector<double> values)
+{
+  std::sort(values.begin(), values.end());
+  size_t n = values.size();
+  return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+static result run(const benchmark &b, double min_seconds, int repetitions)
+{
+  // Grow the iteration count until a run is long enough, like Google Benchmark does
+  uint64_t iterations = 1;
+  for (;;)
+  {
+    double start = seconds(CLOCK_MONOTONIC);
+    b.run(iterations);
+    double elapsed = seconds(CLOCK_MONOTONIC) - start;
+    if (elapsed >= min_seconds || iterations >= (1ULL << 40))
+    {
+      break;
+    }
+    double scale = elapsed > 0 ? min_seconds * 1.4 / elapsed : 100;
+    iterations = (uint64_t)(iterations * std::min(std::max(scale, 2.0), 100.0));
+  }
+
+  std::vector<double> real, cpu;
+  for (int r = 0; r < repetitions; r++)
+  {
+    double real_start = seconds(CLOCK_MONOTONIC);
+    double cpu_start = seconds(CLOCK_PROCESS_CPUTIME_ID);
+    b.run(iterations);
+    cpu.push_back((seconds(CLOCK_PROCESS_CPUTIME_ID) - cpu_start) * 1e9 / iterations);
+    real.push_back((seconds(CLOCK_MONOTONIC) - real_start) * 1e9 / iterations);
+  }
+
+  result r;
+  r.name = b.name;
+  r.iterations = iterations;
+  r.real_ns = median(real);
+  r.cpu_ns = median(cpu);
+  int bytes = b.bytes < 0 ? coded_bytes - 2 : b.bytes;
+  r.bytes_per_second = bytes ? bytes * 1e9 / r.cpu_ns : 0;
+  return r;
+}
+
+static bool write_json(const char *path, const std::vector<result> &results, int repetitions)
+{
+  FILE *f = fopen(path, "w");
+  if (!f)
+  {
+    return false;
+  }
+  char host[256] = "";
+  gethostname(host, sizeof(host) - 1);
+  char date[32];
+  time_t now = time(NULL);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+
+  fprintf(f, "{\n  \"context\": {\n");
+  fprintf(f, "    \"date\": \"%s\",\n", date);
+  fprintf(f, "    \"host_name\": \"%s\",\n", host);
+  fprintf(f, "    \"executable\": \"bench_suite\",\n");
+  fprintf(f, "    \"num_cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+#ifdef NDEBUG
+  fprintf(f, "    \"library_build_type\": \"release\",\n");
+#else
+  fprintf(f, "    \"library_build_type\": \"debug\",\n");
+#endif
+  fprintf(f, "    \"repetitions\": %d\n  },\n  \"benchmarks\": [\n", repetitions);
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    const result &r = results[i];
+    fprintf(f, "    {\n");
+    fprintf(f, "      \"name\": \"%s\",\n", r.name);
+    fprintf(f, "      \"run_name\": \"%s\",\n", r.name);
+    fprintf(f, "      \"run_type\": \"iteration\",\n");
+    fprintf(f, "      \"iterations\": %llu,\n", (unsigned long long)r.iterations);
+    fprintf(f, "      \"real_time\": %.3f,\n", r.real_ns);
+    fprintf(f, "      \"cpu_time\": %.3f,\n", r.cpu_ns);
+    if (r.bytes_per_second > 0)
+    {
+      fprintf(f, "      \"bytes_per_second\": %.0f,\n", r.bytes_per_second);
+    }
+    fprintf(f, "      \"time_unit\": \"ns\"\n");
+    fprintf(f, "    }%s\n", i + 1 < results.size() ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+  return fclose(f) == 0;
+}
+
+// Reads back the cpu_time of a benchmark from a file in the layout above. Returns -1 if it is not there.
+static double baseline_cpu_ns(const char *json, const char *name)
+{
+  char key[96];
+  snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+  const char *entry = strstr(json, key);
+  if (!entry)
+  {
+    return -1;
+  }
+  const char *end = strchr(entry, '}');
+  const char *cpu = strstr(entry, "\"cpu_time\":");
+  if (!cpu || (end && cpu > end))
+  {
+    return -1;
+  }
+  return atof(cpu + strlen("\"cpu_time\":"));
+}
+
+static char *read_file(const char *path)
+{
+  FILE *f = fopen(path, "rb");
+  if (!f)
+  {
+    return NULL;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char *text = (char *)malloc(size + 1);
+  if (text)
+  {
+    text[fread(text, 1, size, f)] = '\0';
+  }
+  fclose(f);
+  return text;
+}
+
+static void usage()
+{
+  fprintf(stderr, "usage: bench_suite [-t seconds] [-r repetitions] [-f filter] [-o results.json] "
+                  "[-c baseline.json] [-p percent]\n");
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  double min_seconds = 0.2;
+  int repetitions = 5;
+  double threshold = 10;
+  const char *filter = NULL, *output = NULL, *baseline = NULL;
+  int opt;
+  while ((opt = getopt(argc, argv, "t:r:f:o:c:p:")) != -1)
+  {
+    switch (opt)
+    {
+    case 't':
+      min_seconds = atof(optarg);
+      break;
+    case 'r':
+      repetitions = atoi(optarg);
+      break;
+    case 'f':
+      filter = optarg;
+      break;
+    case 'o':
+      output = optarg;
+      break;
+    case 'c':
+      baseline = optarg;
+      break;
+    case 'p':
+      threshold = atof(optarg);
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind != argc || repetitions < 1 || min_seconds <= 0)
+  {
+    usage();
+  }
+
+  char *baseline_json = NULL;
+  if (baseline && !(baseline_json = read_file(baseline)))
+  {
+    fprintf(stderr, "Could not read %s\n", baseline);
+    return 2;
+  }
+
+  if (!oled_begin(128, 32))
+  {
+    fprintf(stderr, "oled_begin failed\n");
+    return 2;
+  }
+  setup_data();
+  if (!check_data())
+  {
+    return 2;
+  }
+
+  printf("%-18s %14s %12s %12s %14s", "Benchmark", "Iterations", "Time (ns)", "CPU (ns)", "Throughput");
+  printf(baseline_json ? " %10s\n" : "\n", "Change");
+  std::vector<result> results;
+  int regressions = 0;
+  for (const benchmark &b : benchmarks)
+  {
+    if (filter && !strstr(b.name, filter))
+    {
+      continue;
+    }
+    result r = run(b, min_seconds, repetitions);
+    results.push_back(r);
+    printf("%-18s %14llu %12.1f %12.1f", r.name, (unsigned long long)r.iterations, r.real_ns, r.cpu_ns);
+    if (r.bytes_per_second > 0)
+    {
+      printf(" %10.1f MB/s", r.bytes_per_second / 1e6);
+    }
+    else
+    {
+      printf(" %14s", "");
+    }
+    if (baseline_json)
+    {
+      double before = baseline_cpu_ns(baseline_json, r.name);
+      if (before > 0)
+      {
+        double change = (r.cpu_ns - before) * 100 / before;
+        bool slower = change > threshold;
+        regressions += slower;
+        printf(" %+9.1f%%%s", change, slower ? "  SLOWER" : "");
+      }
+      else
+      {
+        printf(" %10s", "new");
+      }
+    }
+    printf("\n");
+  }
+
+  if (output && !write_json(output, results, repetitions))
+  {
+    fprintf(stderr, "Could not write %s\n", output);
+    return 2;
+  }
+  if (regressions)
+  {
+    printf("%d benchmark%s more than %.0f%% slower than %s\n", regressions, regressions == 1 ? "" : "s",
+           threshold, baseline);
+    return 1;
+  }
+  return 0;
+}
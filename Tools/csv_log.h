@@ -0,0 +1,74 @@
+/*
+csv_log.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// FLIGHT LOG CSV, COMPUTER SIDE
+// Helpers the tools share for reading horusdemodlib CSV logs: splitting a line into fields, finding
+// a column by name, and turning the datetime column into seconds since 1970.
+// Header only, for tools built from a single file.
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Splits one CSV line, with quoted fields
+inline std::vector<std::string> csv_split(const std::string &line)
+{
+  std::vector<std::string> fields(1);
+  bool quoted = false;
+  for (char c : line)
+  {
+    if (c == '"')
+    {
+      quoted = !quoted;
+    }
+    else if (c == ',' && !quoted)
+    {
+      fields.push_back(std::string());
+    }
+    else if (c != '\r' && c != '\n')
+    {
+      fields.back() += c;
+    }
+  }
+  return fields;
+}
+
+// Index of the named column in the header, or -1
+inline int csv_column(const std::vector<std::string> &header, const char *name)
+{
+  for (size_t i = 0; i < header.size(); i++)
+  {
+    if (header[i] == name)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Days since 1970 for a civil date, so timegm() is not needed
+inline int64_t days_from_civil(int64_t y, unsigned m, unsigned d)
+{
+  y -= m <= 2;
+  int64_t era = (y >= 0 ? y : y - 399) / 400;
+  unsigned yoe = (unsigned)(y - era * 400);
+  unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int64_t)doe - 719468;
+}
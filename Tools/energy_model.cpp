@@ -0,0 +1,508 @@
+/*
+energy_model.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Plays the tracker's packet cycle through the energy accounting (energy.cpp) on a simulated clock,
+// and ranks power saving changes by the charge they save. Runs on a computer, not the tracker.
+// Build and run from this folder with:
+//
+//   $ make energy_model
+//   $ ./energy_model [-f flight.csv ...] [slot period in seconds]
+//
+// The durations below follow loop() with GPS_TIME_SYNC. The currents are the table in energy.cpp,
+// so change them there and both the tracker and this model pick them up.
+// The callsign, the BME280 and the IMU are left out.
+// With -f, each horusdemodlib log (such as those in Media/Data) is flown through the adaptive packet
+// rate (rate.cpp, with the RATE_* settings in config.h) instead, and the charge it takes is set against
+// sending every slot at OUTPUT_POWER, phase by phase. Across packets lost in reception, the altitude
+// is interpolated, as the tracker's own GPS would have seen it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "energy.h"
+#include "horus_l2.h"
+#include "packet.h"
+#include "flight_log.h"
+#include "power.h"
+#include "rate.h"
+#include "csv_log.h"
+
+#define PACKETS 720 // An hour at the default 5 second period
+
+// Packet cycle, in milliseconds
+#define BUILD_MS 12         // Waiting for the BME280 conversion, then building and encoding
+#define LED_MS 500          // Each STATUS_LED blink, spent in delay()
+#define OLED_BYTES 600      // Typical partial refresh
+#define SECTOR_WRITE_MS 4   // One 512 byte sector to the card
+#define FLUSH_MS 2          // Directory entry update after a sync
+#define WAKE_MARGIN_MS 300  // CADENCE_WAKE_MARGIN
+#define SYMBOL_MS 10        // 100 baud 4FSK
+
+// The cell behind the boost converter
+#define AA_CAPACITY_MAH 3000 // Lithium AA
+#define AA_MV 1500
+#define BOOST_EFFICIENCY 85 // Percent
+
+// Simulated clock
+static unsigned long now_us = 0;
+unsigned long micros() { return now_us; }
+unsigned long millis() { return now_us / 1000; }
+void delay(unsigned long ms) { now_us += ms * 1000; }
+void yield() {}
+
+// Time the GPS comes out of standby, zero if it is not resting
+static uint32_t gps_wake_ms = 0;
+
+// Moves the clock on, waking the GPS on the way if it is due
+static void run(uint32_t ms)
+{
+  uint32_t end_ms = millis() + ms;
+  if (gps_wake_ms && gps_wake_ms < end_ms)
+  {
+    now_us = gps_wake_ms * 1000UL;
+    energy_set(ENERGY_GPS_ON);
+    gps_wake_ms = 0;
+  }
+  now_us = end_ms * 1000UL;
+}
+
+// power_gps_rest(): whole seconds of standby, if the GPS can be back up in time
+static void gps_rest(uint32_t needed_ms)
+{
+  int32_t spare_ms = (int32_t)(needed_ms - millis()) - POWER_GPS_WAKE_MS;
+  if (gps_wake_ms || spare_ms < 1000)
+  {
+    return;
+  }
+  energy_set(ENERGY_GPS_STANDBY);
+  gps_wake_ms = millis() + spare_ms / 1000 * 1000;
+}
+
+struct scenario
+{
+  const char *name;
+  bool dev_mode;    // No deep sleep, the CPU spins in delay()
+  bool status_led;  // Two LED blinks per packet with the CPU awake
+  bool radio_sleep; // Si4063 in SLEEP rather than READY between packets
+  bool gps_standby; // GPS in standby while its fix is not needed
+  bool clock_scaling; // CLOCK_SCALING: 8 MHz except while the packet is built
+  bool oled;        // OLED on and refreshed every packet
+  bool sd;          // Flight log on an SD card
+};
+
+static const scenario scenarios[] = {
+    {"Flight build (baseline)", false, true, false, false, false, true, true},
+    {"No STATUS_LED blinks", false, false, false, false, false, true, true},
+    {"Radio asleep between packets", false, true, true, false, false, true, true},
+    {"GPS standby between fixes", false, true, false, true, false, true, true},
+    {"CLOCK_SCALING", false, true, false, false, true, true, true},
+    {"OLED off", false, true, false, false, false, false, true},
+    {"No SD card", false, true, false, false, false, true, false},
+    {"ULTRA_LOW_POWER", false, true, true, true, true, false, true},
+    {"ULTRA_LOW_POWER, no LEDs", false, false, true, true, true, false, true},
+    {"DEV_MODE build", true, true, false, false, false, true, true},
+};
+#define SCENARIOS (sizeof(scenarios) / sizeof(scenarios[0]))
+
+struct result
+{
+  energy_report sum; // Every packet's report added up
+  uint32_t packets;
+  uint32_t gps_late;  // Fixes or time pulses needed while the GPS was still in standby
+};
+
+static void add_report(energy_report *sum, const energy_report &r)
+{
+  sum->duration_ms += r.duration_ms;
+  for (int i = 0; i < ENERGY_STATES; i++)
+  {
+    sum->state_ms[i] += r.state_ms[i];
+  }
+  for (int i = 0; i < ENERGY_SUBSYSTEMS; i++)
+  {
+    sum->charge_nah[i] += r.charge_nah[i];
+  }
+  sum->total_nah += r.total_nah;
+  sum->since_boot_uah = r.since_boot_uah;
+}
+
+static void simulate(const scenario &s, uint32_t period_ms, result *out)
+{
+  uint32_t airtime_ms = (8 + horus_l2_get_num_tx_data_bytes(sizeof(HorusBinaryPacketV2))) * 4 * SYMBOL_MS;
+  uint32_t after_tx_ms = airtime_ms + (s.status_led ? LED_MS : 0);
+  uint32_t oled_ms = (OLED_BYTES * 9 + 399) / 400; // 9 clocks per byte at 400 kHz
+  energy_state awake = s.clock_scaling && !s.dev_mode ? ENERGY_CPU_SLOW : ENERGY_CPU_ACTIVE;
+  uint16_t unsynced = 0;
+
+  // Start at the top of loop(), right after a packet
+  now_us = 0;
+  gps_wake_ms = 0;
+  uint32_t tx_ms = period_ms - after_tx_ms;
+  energy_begin();
+  energy_set(s.radio_sleep ? ENERGY_RADIO_SLEEP : ENERGY_RADIO_READY);
+  energy_set(awake);
+  if (s.sd)
+  {
+    energy_set(ENERGY_SD_IDLE);
+  }
+  if (s.oled)
+  {
+    energy_set(ENERGY_OLED_ON);
+  }
+  energy_report report;
+  memset(out, 0, sizeof(*out));
+
+  for (uint32_t packet = 0; packet < PACKETS; packet++)
+  {
+    // build_horus_binary_packet_v2() at full speed, with the CPU awake throughout, delay() included
+    out->gps_late += gps_wake_ms != 0;
+    energy_set(ENERGY_CPU_ACTIVE);
+    run(BUILD_MS);
+    if (s.status_led)
+    {
+      run(LED_MS);
+    }
+    if (s.oled)
+    {
+      energy_set(ENERGY_OLED_PUSH);
+      run(oled_ms);
+      energy_set(ENERGY_OLED_ON);
+    }
+    if (s.sd)
+    {
+      // flight_log_append() writes a full sector, or syncs the partial one every few records
+      if (packet % FLIGHT_LOG_RECORDS_PER_SECTOR == FLIGHT_LOG_RECORDS_PER_SECTOR - 1)
+      {
+        energy_set(ENERGY_SD_BUSY);
+        run(SECTOR_WRITE_MS);
+        energy_set(ENERGY_SD_IDLE);
+        unsynced = 0;
+      }
+      else if (++unsynced >= FLIGHT_LOG_SYNC_INTERVAL)
+      {
+        energy_set(ENERGY_SD_BUSY);
+        run(SECTOR_WRITE_MS + FLUSH_MS);
+        energy_set(ENERGY_SD_IDLE);
+        unsynced = 0;
+      }
+    }
+
+    // The fix is taken, so the GPS can rest until just before the slot's time pulse
+    energy_set(awake);
+    if (s.gps_standby)
+    {
+      gps_rest(tx_ms);
+    }
+
+    // cadence_wait_for_slot(), then power_wake() in the wake margin
+    uint32_t wait_ms = tx_ms > millis() ? tx_ms - millis() : 0;
+    if (!s.dev_mode && wait_ms > WAKE_MARGIN_MS)
+    {
+      energy_set(ENERGY_CPU_SLEEP);
+      run(wait_ms - WAKE_MARGIN_MS);
+      energy_set(awake);
+      wait_ms = WAKE_MARGIN_MS;
+    }
+    energy_set(ENERGY_RADIO_READY);
+    run(wait_ms);
+
+    // The packet itself, paced by delay(). The GPS rests again until the next build.
+    out->gps_late += gps_wake_ms != 0;
+    energy_set(ENERGY_RADIO_TX);
+    if (s.gps_standby)
+    {
+      gps_rest(millis() + after_tx_ms);
+    }
+    run(airtime_ms);
+    energy_set(s.radio_sleep ? ENERGY_RADIO_SLEEP : ENERGY_RADIO_READY);
+    if (s.status_led)
+    {
+      run(LED_MS);
+    }
+    tx_ms += period_ms;
+
+    energy_take_report(&report);
+    add_report(&out->sum, report);
+    out->packets++;
+  }
+}
+
+// Average current at the rail, in microamps
+static double rail_ua(const result &r)
+{
+  return r.sum.total_nah / 1000.0 * 3600000.0 / r.sum.duration_ms;
+}
+
+// Battery life, with the boost converter losses
+static double battery_hours(const result &r)
+{
+  double cell_ma = rail_ua(r) / 1000.0 * ENERGY_RAIL_MV / AA_MV * 100 / BOOST_EFFICIENCY;
+  return AA_CAPACITY_MAH / cell_ma;
+}
+
+// ******************
+// || Logged flights ||
+// ******************
+
+struct flight_row
+{
+  int64_t seconds; // Since 1970
+  uint16_t altitude_m;
+  uint16_t battery_mv;
+};
+
+// The time, altitude and battery of every packet in the log, in time order
+static bool flight_read(const char *filename, std::vector<flight_row> *rows)
+{
+  FILE *file = fopen(filename, "r");
+  if (!file)
+  {
+    fprintf(stderr, "Could not open %s\n", filename);
+    return false;
+  }
+  std::vector<std::string> header;
+  int datetime = -1, alt = -1, batt = -1;
+  char buffer[2048];
+  while (fgets(buffer, sizeof(buffer), file))
+  {
+    std::vector<std::string> fields = csv_split(buffer);
+    if (header.empty())
+    {
+      header = fields;
+      datetime = csv_column(header, "datetime");
+      alt = csv_column(header, "alt");
+      batt = csv_column(header, "batt");
+      if (datetime < 0 || alt < 0 || batt < 0)
+      {
+        fprintf(stderr, "%s needs datetime, alt and batt columns\n", filename);
+        fclose(file);
+        return false;
+      }
+      continue;
+    }
+    int year, month, day, hour, minute, second;
+    if (fields.size() < header.size() ||
+        sscanf(fields[datetime].c_str(), "%d-%d-%dT%d:%d:%d", &year, &month, &day, &hour, &minute, &second) != 6)
+    {
+      continue;
+    }
+    flight_row row;
+    row.seconds = days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    row.altitude_m = atoi(fields[alt].c_str());
+    row.battery_mv = atof(fields[batt].c_str()) * 1000 + 0.5;
+    rows->push_back(row);
+  }
+  fclose(file);
+  std::stable_sort(rows->begin(), rows->end(), [](const flight_row &a, const flight_row &b)
+                   { return a.seconds < b.seconds; });
+  return !rows->empty();
+}
+
+// Charge of one packet, from the build to the next build, in nAh. The cycle is simulated once for
+// each number of slots and power level, on the flight build.
+static double cycle_nah(uint8_t slots, uint8_t power, uint32_t period_ms)
+{
+  static double cache[RATE_MAX_SLOTS + 1][128];
+  double &nah = cache[slots][power & 0x7F];
+  if (nah == 0)
+  {
+    result r;
+    energy_set_tx_power(power);
+    simulate(scenarios[0], slots * period_ms, &r);
+    energy_set_tx_power(OUTPUT_POWER);
+    nah = (double)r.sum.total_nah / r.packets;
+  }
+  return nah;
+}
+
+struct phase_total
+{
+  double seconds;
+  uint32_t packets;
+  double adaptive_nah;
+  double fixed_nah; // Every slot, at OUTPUT_POWER
+};
+
+// Flies the logged flight through the rate controller, one packet at a time, the way loop() does:
+// each packet goes out at the power its build chose, then waits the slots its build chose.
+static void fly(const char *filename, const std::vector<flight_row> &rows, uint32_t period_ms)
+{
+  phase_total phases[RATE_PHASES];
+  memset(phases, 0, sizeof(phases));
+  rate_begin();
+  int64_t start_ms = rows[0].seconds * 1000;
+  int64_t end_ms = rows.back().seconds * 1000;
+  int64_t now_ms = start_ms;
+  int64_t last_ms = 0;
+  uint16_t last_altitude = 0;
+  size_t at = 0;
+  uint32_t changes = 0;
+  while (now_ms <= end_ms)
+  {
+    while (at + 1 < rows.size() && rows[at + 1].seconds * 1000 <= now_ms)
+    {
+      at++;
+    }
+    const flight_row &row = rows[at];
+    uint16_t altitude_m = row.altitude_m;
+    if (at + 1 < rows.size())
+    {
+      const flight_row &next = rows[at + 1];
+      altitude_m += (int32_t)(next.altitude_m - row.altitude_m) * (now_ms - row.seconds * 1000) /
+                    ((next.seconds - row.seconds) * 1000);
+    }
+    int16_t ascent_cms = last_ms ? (int32_t)(altitude_m - last_altitude) * 100000 / (now_ms - last_ms) : 0;
+    last_ms = now_ms;
+    last_altitude = altitude_m;
+    changes += rate_update(true, altitude_m, ascent_cms, row.battery_mv, now_ms - start_ms);
+
+    phase_total &phase = phases[rate_get_stats()->phase];
+    uint8_t slots = rate_slots();
+    phase.seconds += slots * period_ms / 1000.0;
+    phase.packets++;
+    phase.adaptive_nah += cycle_nah(slots, rate_power(), period_ms);
+    phase.fixed_nah += slots * cycle_nah(1, OUTPUT_POWER, period_ms);
+    now_ms += slots * period_ms;
+  }
+
+  const char *name = strrchr(filename, '/') ? strrchr(filename, '/') + 1 : filename;
+  printf("%s: %.1f h logged, %zu packets received, %u rate changes\n", name, (end_ms - start_ms) / 3600000.0,
+         rows.size(), changes);
+  printf("  %-8s %8s %8s %12s %12s %9s\n", "Phase", "minutes", "packets", "fixed uAh", "adaptive uAh", "saved");
+  phase_total total;
+  memset(&total, 0, sizeof(total));
+  for (int i = 0; i < RATE_PHASES; i++)
+  {
+    const phase_total &p = phases[i];
+    if (p.packets == 0)
+    {
+      continue;
+    }
+    printf("  %-8s %8.1f %8u %12.1f %12.1f %8.1f%%\n", rate_phase_name((rate_phase)i), p.seconds / 60, p.packets,
+           p.fixed_nah / 1000, p.adaptive_nah / 1000, 100 * (1 - p.adaptive_nah / p.fixed_nah));
+    total.seconds += p.seconds;
+    total.packets += p.packets;
+    total.fixed_nah += p.fixed_nah;
+    total.adaptive_nah += p.adaptive_nah;
+  }
+  printf("  %-8s %8.1f %8u %12.1f %12.1f %8.1f%%\n", "Total", total.seconds / 60, total.packets, total.fixed_nah / 1000,
+         total.adaptive_nah / 1000, 100 * (1 - total.adaptive_nah / total.fixed_nah));
+
+  // Battery life at this flight's mix of phases, and on the ground waiting for recovery
+  result fixed, adaptive;
+  memset(&fixed, 0, sizeof(fixed));
+  memset(&adaptive, 0, sizeof(adaptive));
+  fixed.sum.total_nah = total.fixed_nah;
+  fixed.sum.duration_ms = total.seconds * 1000;
+  adaptive.sum.total_nah = total.adaptive_nah;
+  adaptive.sum.duration_ms = total.seconds * 1000;
+  printf("  AA life at this mix: %.1f h every slot, %.1f h adaptive (%+.0f%%)\n", battery_hours(fixed),
+         battery_hours(adaptive), 100 * (battery_hours(adaptive) / battery_hours(fixed) - 1));
+  result landed;
+  memset(&landed, 0, sizeof(landed));
+  landed.sum.total_nah = cycle_nah(RATE_LANDED_SLOTS, RATE_LANDED_POWER, period_ms);
+  landed.sum.duration_ms = RATE_LANDED_SLOTS * period_ms;
+  fixed.sum.total_nah = cycle_nah(1, OUTPUT_POWER, period_ms);
+  fixed.sum.duration_ms = period_ms;
+  printf("  AA life once landed: %.1f h every slot, %.1f h adaptive\n\n", battery_hours(fixed), battery_hours(landed));
+}
+
+int main(int argc, char **argv)
+{
+  std::vector<const char *> flights;
+  int opt;
+  while ((opt = getopt(argc, argv, "f:")) != -1)
+  {
+    if (opt != 'f')
+    {
+      fprintf(stderr, "usage: energy_model [-f flight.csv ...] [slot period in seconds]\n");
+      return 2;
+    }
+    flights.push_back(optarg);
+  }
+  uint32_t period_ms = (optind < argc ? atoi(argv[optind]) : TX_SLOT_PERIOD) * 1000;
+
+  if (!flights.empty())
+  {
+    bool ok = true;
+    for (const char *filename : flights)
+    {
+      std::vector<flight_row> rows;
+      if (!flight_read(filename, &rows))
+      {
+        ok = false;
+        continue;
+      }
+      fly(filename, rows, period_ms);
+    }
+    return ok ? 0 : 1;
+  }
+
+  static result results[SCENARIOS];
+  for (size_t i = 0; i < SCENARIOS; i++)
+  {
+    simulate(scenarios[i], period_ms, &results[i]);
+  }
+
+  // Where the charge goes in the baseline
+  const result &base = results[0];
+  printf("%s, %lu ms period, %u packets\n\n", scenarios[0].name, (unsigned long)period_ms, base.packets);
+  printf("%-14s %10s %8s %12s\n", "State", "ms/packet", "mA", "nAh/packet");
+  for (int i = 0; i < ENERGY_STATES; i++)
+  {
+    if (base.sum.state_ms[i] == 0)
+    {
+      continue;
+    }
+    energy_state state = (energy_state)i;
+    double ms = (double)base.sum.state_ms[i] / base.packets;
+    printf("%-14s %10.1f %8.3f %12.1f\n", energy_state_name(state), ms, energy_current_ua(state) / 1000.0,
+           ms * energy_current_ua(state) / 3600.0);
+  }
+  printf("\n%-14s %12s %8s\n", "Subsystem", "nAh/packet", "share");
+  for (int i = 0; i < ENERGY_SUBSYSTEMS; i++)
+  {
+    printf("%-14s %12.1f %7.1f%%\n", energy_subsystem_name((energy_subsystem)i),
+           (double)base.sum.charge_nah[i] / base.packets, 100.0 * base.sum.charge_nah[i] / base.sum.total_nah);
+  }
+  printf("%-14s %12.1f\n\n", "Total", (double)base.sum.total_nah / base.packets);
+
+  // Every change against the baseline, most charge saved first
+  size_t order[SCENARIOS];
+  for (size_t i = 0; i < SCENARIOS; i++)
+  {
+    order[i] = i;
+  }
+  std::sort(order + 1, order + SCENARIOS, [](size_t a, size_t b)
+            { return results[a].sum.total_nah < results[b].sum.total_nah; });
+
+  printf("%-30s %11s %9s %9s %10s %9s\n", "Scenario", "uAh/packet", "rail mA", "saved", "AA hours", "GPS late");
+  for (size_t n = 0; n < SCENARIOS; n++)
+  {
+    const result &r = results[order[n]];
+    double per_packet = r.sum.total_nah / 1000.0 / r.packets;
+    double saved = 100.0 * ((double)base.sum.total_nah - r.sum.total_nah) / base.sum.total_nah;
+    printf("%-30s %11.2f %9.2f %8.1f%% %10.1f %9u\n", scenarios[order[n]].name, per_packet, rail_ua(r) / 1000.0,
+           saved, battery_hours(r), r.gps_late);
+  }
+  return 0;
+}
@@ -0,0 +1,106 @@
+/*
+flightlog2csv.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Converts the binary flight log (FLIGHT.BIN on the SD card) to CSV.
+// Runs on a computer, not the tracker. Build and run from this folder with:
+//
+//   $ make flightlog2csv
+//   $ ./flightlog2csv FLIGHT.BIN > flight.csv
+//
+// The first 16 columns are written exactly like datalog.csv on the tracker.
+// The log is a ring, so records are sorted back into order by their sequence number.
+// Unused space and records with a bad CRC are skipped.
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "flight_log.h"
+#include "crc_calc.h"
+#include "datalog_csv.h"
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: %s FLIGHT.BIN [out.csv]\n", argv[0]);
+    return 1;
+  }
+
+  FILE *in = fopen(argv[1], "rb");
+  if (!in)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+  FILE *out = argc > 2 ? fopen(argv[2], "w") : stdout;
+  if (!out)
+  {
+    perror(argv[2]);
+    return 1;
+  }
+
+  // Read every good record, then put them back in order
+  std::vector<flight_log_record> records;
+  flight_log_record record;
+  unsigned long bad_records = 0;
+  while (fread(&record, sizeof(record), 1, in) == 1)
+  {
+    if (record.magic != FLIGHT_LOG_MAGIC)
+    {
+      continue;
+    }
+    if (!flight_log_record_valid(&record))
+    {
+      bad_records++;
+      continue;
+    }
+    records.push_back(record);
+  }
+  std::sort(records.begin(), records.end(), [](const flight_log_record &a, const flight_log_record &b)
+            { return a.sequence < b.sequence; });
+
+  fprintf(out, "Sequence,%s,TimestampMs,PressurePa,TemperatureC,HumidityPct,BatteryV,SlotErrorUs,PeakAccelMg,VibrationMg,SpinDps,ChecksumOK\n", DATALOG_HEADER);
+
+  char row[DATALOG_MAX_ROW];
+  unsigned long bad_checksums = 0;
+  for (const flight_log_record &r : records)
+  {
+    const HorusBinaryPacketV2 &p = r.packet;
+    bool crc_ok = (uint16_t)crc16((unsigned char *)&p, sizeof(p) - 2) == p.Checksum;
+    if (!crc_ok)
+    {
+      bad_checksums++;
+    }
+
+    datalog_csv_row(row, p);
+    fprintf(out, "%lu,%s,%lu,%ld,%.2f,%.2f,%.3f,%ld,%u,%u,%d,%d\n",
+            (unsigned long)r.sequence, row, (unsigned long)r.timestamp_ms, (long)r.pressure_pa,
+            r.temperature_centi / 100.0, r.humidity_centi / 100.0, r.battery_mv / 1000.0,
+            (long)r.slot_error_us, r.peak_accel_mg, r.vibration_mg, r.spin_dps, crc_ok);
+  }
+
+  fprintf(stderr, "%lu records, %lu damaged records skipped, %lu bad packet checksums\n",
+          (unsigned long)records.size(), bad_records, bad_checksums);
+  fclose(in);
+  if (out != stdout)
+  {
+    fclose(out);
+  }
+  return 0;
+}
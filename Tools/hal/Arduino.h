@@ -0,0 +1,100 @@
+/*
+Arduino.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// HOST ARDUINO STAND-IN
+// Just enough of Arduino.h for the tracker's hardware-independent modules to build on a computer,
+// for the host tools and benchmarks. Add to it as tools need more.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Timing. Each tool supplies these, so it can run the clock however suits it.
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+// SAMD21 types named in tracker headers. The registers themselves do not exist on the host.
+struct DmacDescriptor
+{
+  uint32_t words[4];
+};
+
+// Pins and interrupts. There is nothing to drive, so these do nothing.
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define LOW 0x0
+#define HIGH 0x1
+#define A0 14
+inline void pinMode(uint32_t pin, uint32_t mode) {}
+inline void digitalWrite(uint32_t pin, uint32_t value) {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+// Strings kept in flash on the board are ordinary strings here
+class __FlashStringHelper;
+#define F(string) (reinterpret_cast<const __FlashStringHelper *>(string))
+
+// SerialUSB and Serial1, defined in board.cpp. A tool feeds received bytes in with host_feed(), and
+// whatever the tracker prints goes to host_echo, or nowhere if that is not set.
+class HostSerial
+{
+public:
+  void begin(unsigned long baud) {}
+  operator bool() { return true; }
+  int available();
+  int read();
+  size_t write(uint8_t data);
+  size_t write(const uint8_t *data, size_t length);
+  size_t write(const char *text);
+
+  size_t print(const char *text);
+  size_t print(const __FlashStringHelper *text);
+  size_t print(char c);
+  size_t print(int value);
+  size_t print(unsigned int value);
+  size_t print(long value);
+  size_t print(unsigned long value);
+  size_t print(double value, int digits = 2);
+  size_t println();
+  template <typename T>
+  size_t println(T value)
+  {
+    return print(value) + println();
+  }
+  size_t println(double value, int digits)
+  {
+    return print(value, digits) + println();
+  }
+
+  bool host_feed(const char *data, size_t length);
+  FILE *host_echo = NULL;
+
+private:
+  char _input[1024];
+  size_t _head = 0;
+  size_t _tail = 0;
+};
+
+extern HostSerial SerialUSB;
+extern HostSerial Serial1;
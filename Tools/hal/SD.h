@@ -1,5 +1,5 @@
 /*
-delay_timer.h, part of Tiny4FSK, for a high-altitude tracker.
+SD.h, part of Tiny4FSK, for a high-altitude tracker.
 Copyright (C) 2026 Maxwell Kendall
 
 This program is free software: you can redistribute it and/or modify
@@ -16,12 +16,17 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
-// LOW-LEVEL DELAY FUNCTION
-// These functions use the TC (timer counter) to achieve a more accurate delay.
+// HOST SD STAND-IN
+// No card is ever found on the host.
 #pragma once
 
-#include <Arduino.h>
+#include <stdint.h>
 
-void TC3_Handler();
-void setupTC3(uint16_t delay_ms);
-void delayWithTC3(uint16_t delay_ms);
\ No newline at end of file
+class SDClass
+{
+public:
+  bool begin(uint8_t cs_pin) { return false; }
+  bool exists(const char *filename) { return false; }
+};
+
+extern SDClass SD;
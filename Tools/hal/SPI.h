@@ -0,0 +1,45 @@
+/*
+SPI.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// HOST SPI STAND-IN
+// The Si4063 and the SD card are not modelled on the host, so the bus carries nothing.
+#pragma once
+
+#include <stdint.h>
+
+#define MSBFIRST 1
+#define SPI_MODE0 0x00
+
+class SPISettings
+{
+public:
+  SPISettings() {}
+  SPISettings(uint32_t clock, uint8_t bit_order, uint8_t data_mode) {}
+};
+
+class SPIClass
+{
+public:
+  void begin() {}
+  void end() {}
+  void beginTransaction(SPISettings settings) {}
+  void endTransaction() {}
+  uint8_t transfer(uint8_t data) { return 0; }
+};
+
+extern SPIClass SPI;
@@ -0,0 +1,136 @@
+/*
+TinyGPSPlus.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "TinyGPSPlus.h"
+
+#define GPS_MAX_TERMS 20
+
+// ddmm.mmmm, with the hemisphere letter
+static double nmea_degrees(const char *term, const char *hemisphere)
+{
+  double value = strtod(term, NULL);
+  double degrees = (int)(value / 100);
+  degrees += (value - degrees * 100) / 60;
+  return (*hemisphere == 'S' || *hemisphere == 'W') ? -degrees : degrees;
+}
+
+// hhmmss.ss to hhmmsscc
+static uint32_t nmea_time(const char *term)
+{
+  return (uint32_t)(strtod(term, NULL) * 100 + 0.5);
+}
+
+static uint8_t hex_digit(char c)
+{
+  return c >= 'A' ? c - 'A' + 10 : c - '0';
+}
+
+bool TinyGPSPlus::encode(char c)
+{
+  _chars++;
+  if (c == '$')
+  {
+    _length = 0;
+  }
+  if (c == '\r' || c == '\n')
+  {
+    bool used = _length > 0 && sentence_done();
+    _length = 0;
+    return used;
+  }
+  if (_length < sizeof(_sentence) - 1)
+  {
+    _sentence[_length++] = c;
+  }
+  return false;
+}
+
+// Checks the sentence, splits it into terms and commits what it carries
+bool TinyGPSPlus::sentence_done()
+{
+  _sentence[_length] = '\0';
+  char *star = strchr(_sentence, '*');
+  if (_sentence[0] != '$' || !star || star - _sentence < 7 || _length - (star - _sentence) < 3)
+  {
+    return false;
+  }
+  uint8_t checksum = 0;
+  for (char *p = _sentence + 1; p < star; p++)
+  {
+    checksum ^= *p;
+  }
+  if (checksum != (hex_digit(star[1]) << 4 | hex_digit(star[2])))
+  {
+    _failed++;
+    return false;
+  }
+  _passed++;
+  *star = '\0';
+
+  const char *terms[GPS_MAX_TERMS];
+  uint8_t count = 0;
+  char *p = _sentence + 1;
+  terms[count++] = p;
+  while ((p = strchr(p, ',')) && count < GPS_MAX_TERMS)
+  {
+    *p++ = '\0';
+    terms[count++] = p;
+  }
+  // The talker (GP, GN, BD...) does not matter
+  const char *type = terms[0] + 2;
+
+  if (!strcmp(type, "GGA") && count >= 10)
+  {
+    bool fix = terms[6][0] > '0';
+    time._time = nmea_time(terms[1]);
+    time.commit();
+    if (fix)
+    {
+      location._lat = nmea_degrees(terms[2], terms[3]);
+      location._lng = nmea_degrees(terms[4], terms[5]);
+      location.commit();
+      altitude._value = strtod(terms[9], NULL);
+      altitude.commit();
+      _with_fix++;
+    }
+    satellites._value = atol(terms[7]);
+    satellites.commit();
+    hdop._value = strtod(terms[8], NULL);
+    hdop.commit();
+    return true;
+  }
+  if (!strcmp(type, "RMC") && count >= 10)
+  {
+    bool fix = terms[2][0] == 'A';
+    time._time = nmea_time(terms[1]);
+    time.commit();
+    date._date = atol(terms[9]);
+    date.commit();
+    if (fix)
+    {
+      location._lat = nmea_degrees(terms[3], terms[4]);
+      location._lng = nmea_degrees(terms[5], terms[6]);
+      location.commit();
+      speed._value = strtod(terms[7], NULL);
+      speed.commit();
+      _with_fix++;
+    }
+    return true;
+  }
+  return false;
+}
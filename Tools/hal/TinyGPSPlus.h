@@ -0,0 +1,183 @@
+/*
+TinyGPSPlus.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// HOST TINYGPSPLUS STAND-IN
+// Parses the NMEA sentences the tracker relies on, GGA and RMC from any talker, into the same
+// fields as TinyGPSPlus, with the same rules: a sentence is only used if its checksum matches, and
+// the position and altitude only if it reports a fix. Only the parts of the API the tracker calls
+// are here. To check against the real library, put its src folder ahead of hal on the include path.
+#pragma once
+
+#include <Arduino.h>
+
+#define _GPS_MAX_FIELD_SIZE 15
+#define _GPS_KMPH_PER_KNOT 1.852
+
+// Validity, update flag and age, shared by every field
+class TinyGPSField
+{
+  friend class TinyGPSPlus;
+
+public:
+  bool isValid() const { return _valid; }
+  bool isUpdated() const { return _updated; }
+  uint32_t age() const { return _valid ? millis() - _commit_ms : 0xFFFFFFFF; }
+
+protected:
+  void commit()
+  {
+    _valid = true;
+    _updated = true;
+    _commit_ms = millis();
+  }
+  bool _valid = false;
+  mutable bool _updated = false;
+  uint32_t _commit_ms = 0;
+};
+
+class TinyGPSLocation : public TinyGPSField
+{
+  friend class TinyGPSPlus;
+
+public:
+  double lat() const
+  {
+    _updated = false;
+    return _lat;
+  }
+  double lng() const
+  {
+    _updated = false;
+    return _lng;
+  }
+
+private:
+  double _lat = 0, _lng = 0;
+};
+
+class TinyGPSDate : public TinyGPSField
+{
+  friend class TinyGPSPlus;
+
+public:
+  uint32_t value() const
+  {
+    _updated = false;
+    return _date;
+  }
+  uint16_t year() const { return value() % 100 + 2000; }
+  uint8_t month() const { return value() / 100 % 100; }
+  uint8_t day() const { return value() / 10000; }
+
+private:
+  uint32_t _date = 0; // ddmmyy
+};
+
+class TinyGPSTime : public TinyGPSField
+{
+  friend class TinyGPSPlus;
+
+public:
+  uint32_t value() const
+  {
+    _updated = false;
+    return _time;
+  }
+  uint8_t hour() const { return value() / 1000000; }
+  uint8_t minute() const { return value() / 10000 % 100; }
+  uint8_t second() const { return value() / 100 % 100; }
+  uint8_t centisecond() const { return value() % 100; }
+
+private:
+  uint32_t _time = 0; // hhmmsscc
+};
+
+class TinyGPSDecimal : public TinyGPSField
+{
+  friend class TinyGPSPlus;
+
+public:
+  double value() const
+  {
+    _updated = false;
+    return _value;
+  }
+
+protected:
+  double _value = 0;
+};
+
+class TinyGPSAltitude : public TinyGPSDecimal
+{
+public:
+  double meters() const { return value(); }
+  double feet() const { return value() * 3.28083989501312; }
+};
+
+class TinyGPSSpeed : public TinyGPSDecimal
+{
+public:
+  double knots() const { return value(); }
+  double kmph() const { return value() * _GPS_KMPH_PER_KNOT; }
+  double mps() const { return value() * _GPS_KMPH_PER_KNOT / 3.6; }
+};
+
+class TinyGPSInteger : public TinyGPSField
+{
+  friend class TinyGPSPlus;
+
+public:
+  uint32_t value() const
+  {
+    _updated = false;
+    return _value;
+  }
+
+private:
+  uint32_t _value = 0;
+};
+
+class TinyGPSPlus
+{
+public:
+  // Returns true when a sentence with a good checksum has just been used
+  bool encode(char c);
+
+  TinyGPSLocation location;
+  TinyGPSDate date;
+  TinyGPSTime time;
+  TinyGPSSpeed speed;
+  TinyGPSAltitude altitude;
+  TinyGPSInteger satellites;
+  TinyGPSDecimal hdop;
+
+  uint32_t charsProcessed() const { return _chars; }
+  uint32_t sentencesWithFix() const { return _with_fix; }
+  uint32_t failedChecksum() const { return _failed; }
+  uint32_t passedChecksum() const { return _passed; }
+
+private:
+  bool sentence_done();
+
+  char _sentence[96];
+  uint8_t _length = 0;
+  uint32_t _chars = 0;
+  uint32_t _with_fix = 0;
+  uint32_t _failed = 0;
+  uint32_t _passed = 0;
+};
@@ -0,0 +1,82 @@
+/*
+Wire.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// HOST WIRE STAND-IN
+// Collects each I2C write transaction and hands it to wire_host_on_write, so a tool can model the
+// device on the other end. Reads through the i2c_dma stand-in are answered by wire_host_on_read.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define BUFFER_LENGTH 32
+
+// Called at endTransmission() with the address and the bytes written
+extern void (*wire_host_on_write)(uint8_t address, const uint8_t *data, size_t length);
+
+// Called to fill each read transaction, and with no data to probe an address. Returns false if
+// nothing answered. Unset, reads return zeros and probes find nothing.
+extern bool (*wire_host_on_read)(uint8_t address, uint8_t *data, size_t length);
+
+class TwoWire
+{
+public:
+  void begin() {}
+  void setClock(uint32_t) {}
+  void beginTransmission(uint8_t address)
+  {
+    _address = address;
+    _length = 0;
+  }
+  size_t write(uint8_t data)
+  {
+    if (_length >= BUFFER_LENGTH)
+    {
+      return 0;
+    }
+    _buffer[_length++] = data;
+    return 1;
+  }
+  size_t write(const uint8_t *data, size_t length)
+  {
+    size_t written = 0;
+    while (written < length && write(data[written]))
+    {
+      written++;
+    }
+    return written;
+  }
+  uint8_t endTransmission(bool = true)
+  {
+    if (wire_host_on_write)
+    {
+      wire_host_on_write(_address, _buffer, _length);
+    }
+    return 0;
+  }
+  uint8_t requestFrom(uint8_t, uint8_t, bool = true) { return 0; }
+  int available() { return 0; }
+  int read() { return -1; }
+
+private:
+  uint8_t _address = 0;
+  uint8_t _buffer[BUFFER_LENGTH];
+  size_t _length = 0;
+};
+
+extern TwoWire Wire;
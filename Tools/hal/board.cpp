@@ -0,0 +1,390 @@
+/*
+board.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Host stand-ins for everything the sketch needs that only exists on the board: the Arduino library
+// objects, and the tracker modules that work the SAMD21 peripherals directly. With these, the sketch
+// itself and its hardware-independent modules build on a computer, as Tools/replay does.
+// The stand-ins keep time with the tool's millis() and micros(), and otherwise do as little as they can:
+//  - clock.cpp and cadence.cpp: the crystal timebase is micros(), the CPU never changes speed, and
+//    slots start whenever they are asked for.
+//  - si4063.cpp and morse.cpp: the radio takes every command and sends nothing.
+//  - imu.cpp: no IMU is fitted.
+//  - shield.cpp: probes the I2C bus every boot, without the flash cache.
+//  - sd_card.cpp and flight_log.cpp: no card is fitted.
+
+// Built as the Arduino IDE builds the sketch, so the headers show their Arduino-only parts
+#define ARDUINO 10819
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <SD.h>
+#include <ArduinoLowPower.h>
+#include <Scheduler.h>
+#include "clock.h"
+#include "cadence.h"
+#include "si4063.h"
+#include "morse.h"
+#include "shield.h"
+#include "sd_card.h"
+#include "flight_log.h"
+
+HostSerial SerialUSB;
+HostSerial Serial1;
+SPIClass SPI;
+SDClass SD;
+ArduinoLowPowerClass LowPower;
+SchedulerClass Scheduler;
+
+// *****************
+// || Host serial ||
+// *****************
+
+int HostSerial::available()
+{
+  return (_head - _tail + sizeof(_input)) % sizeof(_input);
+}
+
+int HostSerial::read()
+{
+  if (_head == _tail)
+  {
+    return -1;
+  }
+  char c = _input[_tail];
+  _tail = (_tail + 1) % sizeof(_input);
+  return (uint8_t)c;
+}
+
+// Queues bytes for read(). Returns false, taking none of them, if they do not fit.
+bool HostSerial::host_feed(const char *data, size_t length)
+{
+  if (available() + length >= sizeof(_input))
+  {
+    return false;
+  }
+  for (size_t i = 0; i < length; i++)
+  {
+    _input[_head] = data[i];
+    _head = (_head + 1) % sizeof(_input);
+  }
+  return true;
+}
+
+size_t HostSerial::write(const uint8_t *data, size_t length)
+{
+  if (host_echo)
+  {
+    fwrite(data, 1, length, host_echo);
+  }
+  return length;
+}
+
+size_t HostSerial::write(uint8_t data)
+{
+  return write(&data, 1);
+}
+
+size_t HostSerial::write(const char *text)
+{
+  return write((const uint8_t *)text, strlen(text));
+}
+
+size_t HostSerial::print(const char *text)
+{
+  return write(text);
+}
+
+size_t HostSerial::print(const __FlashStringHelper *text)
+{
+  return write(reinterpret_cast<const char *>(text));
+}
+
+size_t HostSerial::print(char c)
+{
+  return write((uint8_t)c);
+}
+
+size_t HostSerial::print(int value)
+{
+  return print((long)value);
+}
+
+size_t HostSerial::print(unsigned int value)
+{
+  return print((unsigned long)value);
+}
+
+size_t HostSerial::print(long value)
+{
+  char text[24];
+  snprintf(text, sizeof(text), "%ld", value);
+  return write(text);
+}
+
+size_t HostSerial::print(unsigned long value)
+{
+  char text[24];
+  snprintf(text, sizeof(text), "%lu", value);
+  return write(text);
+}
+
+size_t HostSerial::print(double value, int digits)
+{
+  char text[48];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return write(text);
+}
+
+size_t HostSerial::println()
+{
+  return write("\r\n");
+}
+
+// ***********
+// || Clock ||
+// ***********
+
+static clock_stats clock_host_stats;
+
+void clock_begin()
+{
+  clock_host_stats.speed[CLOCK_FAST].hz = CLOCK_FAST_HZ;
+}
+
+uint32_t clock_ticks()
+{
+  return (uint32_t)((uint64_t)micros() * CLOCK_TICKS_PER_SECOND / 1000000);
+}
+
+uint32_t clock_millis()
+{
+  return millis();
+}
+
+uint32_t clock_micros()
+{
+  return micros();
+}
+
+uint32_t clock_cycles()
+{
+  return micros() * (CLOCK_FAST_HZ / 1000000);
+}
+
+void clock_add_sleep(uint32_t ticks) {}
+void clock_set(clock_speed speed) {}
+
+clock_speed clock_get()
+{
+  return CLOCK_FAST;
+}
+
+const clock_stats *clock_get_stats()
+{
+  return &clock_host_stats;
+}
+
+void clock_log_row(char *out, clock_speed speed)
+{
+  *out = '\0';
+}
+
+// *************
+// || Cadence ||
+// *************
+
+static cadence_stats cadence_host_stats;
+
+void cadence_begin() {}
+void cadence_update_time(uint8_t hour, uint8_t minute, uint8_t second, uint8_t centisecond, uint32_t age_ms) {}
+
+uint32_t cadence_millis()
+{
+  return millis();
+}
+
+uint32_t cadence_next_slot_ms()
+{
+  return millis();
+}
+
+uint32_t cadence_next_build_ms()
+{
+  return millis();
+}
+
+void cadence_set_slots(uint8_t slots) {}
+void cadence_wait_for_build() {}
+void cadence_wait_for_slot() {}
+
+void cadence_mark_tx_start()
+{
+  cadence_host_stats.slots++;
+  cadence_host_stats.free_slots++;
+}
+
+const cadence_stats *cadence_get_stats()
+{
+  return &cadence_host_stats;
+}
+
+// *******************
+// || Si4063, Morse ||
+// *******************
+
+unsigned int NSEL = NSEL_PIN;
+unsigned int SDN = SDN_PIN;
+
+int si4063_init(radio_parameters rp, chip_parameters cp)
+{
+  return HAL_OK;
+}
+
+void si4063_set_frequency_offset(uint16_t offset) {}
+void si4063_set_tx_power(uint8_t power) {}
+void si4063_enable_tx() {}
+void si4063_inhibit_tx() {}
+void si4063_disable_tx() {}
+
+int si4063_wait_for_cts()
+{
+  return HAL_OK;
+}
+
+static morse_stats morse_host_stats;
+
+void morse_begin() {}
+
+void morse_start()
+{
+  morse_host_stats.callsigns++;
+}
+
+bool morse_busy()
+{
+  return false;
+}
+
+void morse_wait() {}
+
+const morse_stats *morse_get_stats()
+{
+  return &morse_host_stats;
+}
+
+// ********************
+// || IMU and shield ||
+// ********************
+
+static imu_stats imu_host_stats;
+
+bool imu_begin(uint8_t address)
+{
+  return false;
+}
+
+void imu_service() {}
+void imu_drain() {}
+
+void imu_take_summary(imu_summary *summary)
+{
+  memset(summary, 0, sizeof(*summary));
+}
+
+const imu_stats *imu_get_stats()
+{
+  return &imu_host_stats;
+}
+
+bool bme280_found = false;
+bool imu_found = false;
+bool oled_found = false;
+bool sd_found = false;
+
+void initialize_shield()
+{
+  uint8_t bme_address = i2c_dma_probe(BME_ADDRESS) ? BME_ADDRESS : BME_ADDRESS_ALT;
+  bme280_found = i2c_dma_probe(bme_address) && bme280_begin(bme_address);
+  oled_found = i2c_dma_probe(SSD1306_I2C_ADDRESS) && oled_begin(128, 32);
+}
+
+uint32_t shield_discovery_us()
+{
+  return 0;
+}
+
+bool shield_discovery_cached()
+{
+  return false;
+}
+
+// ****************************
+// || SD card and flight log ||
+// ****************************
+
+static flight_log_stats flight_log_host_stats;
+
+bool sd_card_begin()
+{
+  return false;
+}
+
+bool sd_card_write_line(const char *filename, const char *data)
+{
+  return false;
+}
+
+bool sd_card_read_line(const char *filename, char *buffer, size_t bufferSize)
+{
+  return false;
+}
+
+bool sd_card_log_begin(sd_card_log log, const char *filename, const char *header)
+{
+  return false;
+}
+
+bool sd_card_log_line(sd_card_log log, const char *line)
+{
+  return false;
+}
+
+bool flight_log_begin(const char *filename)
+{
+  return false;
+}
+
+bool flight_log_last(flight_log_record *record)
+{
+  return false;
+}
+
+bool flight_log_append(flight_log_record *record)
+{
+  return false;
+}
+
+bool flight_log_sync()
+{
+  return false;
+}
+
+const flight_log_stats *flight_log_get_stats()
+{
+  return &flight_log_host_stats;
+}
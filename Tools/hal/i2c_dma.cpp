@@ -0,0 +1,89 @@
+/*
+i2c_dma.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Host version of the asynchronous I2C engine. Jobs run straight away and write transactions go
+// to wire_host_on_write in one piece, with no 32 byte Wire buffer limit. Reads are filled by
+// wire_host_on_read, or with zeros if the tool does not model any device.
+
+#include "i2c_dma.h"
+
+static i2c_dma_stats stats;
+
+void i2c_dma_begin() {}
+
+bool i2c_dma_write(uint8_t address, const uint8_t *prefix, uint8_t prefix_length, const uint8_t *data, uint8_t length,
+                   i2c_dma_callback callback, void *context)
+{
+  if (prefix_length > I2C_DMA_PREFIX || prefix_length + length == 0 || prefix_length + length > 255)
+  {
+    return false;
+  }
+  uint8_t transaction[255];
+  memcpy(transaction, prefix, prefix_length);
+  memcpy(transaction + prefix_length, data, length);
+  if (wire_host_on_write)
+  {
+    wire_host_on_write(address, transaction, prefix_length + length);
+  }
+  stats.jobs++;
+  stats.bytes += prefix_length + length;
+  if (callback)
+  {
+    callback(true, context);
+  }
+  return true;
+}
+
+bool i2c_dma_read(uint8_t address, uint8_t *data, uint8_t length, i2c_dma_callback callback, void *context)
+{
+  memset(data, 0, length);
+  bool ok = !wire_host_on_read || wire_host_on_read(address, data, length);
+  stats.jobs++;
+  stats.bytes += length;
+  if (!ok)
+  {
+    stats.errors++;
+  }
+  if (callback)
+  {
+    callback(ok, context);
+  }
+  return length > 0;
+}
+
+bool i2c_dma_read_register(uint8_t address, uint8_t reg, uint8_t *data, uint8_t length,
+                           i2c_dma_callback callback, void *context)
+{
+  i2c_dma_write(address, &reg, 1, NULL, 0);
+  return i2c_dma_read(address, data, length, callback, context);
+}
+
+// A device answers if the tool models one at that address, asked with an empty read
+bool i2c_dma_probe(uint8_t address)
+{
+  return wire_host_on_read && wire_host_on_read(address, NULL, 0);
+}
+
+void i2c_dma_service() {}
+void i2c_dma_flush() {}
+bool i2c_dma_idle() { return true; }
+
+const i2c_dma_stats *i2c_dma_get_stats()
+{
+  return &stats;
+}
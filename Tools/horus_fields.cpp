@@ -0,0 +1,97 @@
+/*
+horus_fields.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Prints the horusdemodlib custom field list entry for this tracker's packet, generated from the
+// packet schema in packet.h, so receivers decode the custom bytes the way the firmware fills them.
+// Runs on a computer. Build and run from this folder with:
+//
+//   $ make horus_fields
+//   $ ./horus_fields [-t] [payload_callsign]
+//
+// The entry goes into custom_field_list.json under the payload's callsign (CALLSIGN from config.h
+// unless one is given), and the payload ID (HORUS_ID) has to be in payload_id_list.txt with the same
+// callsign. -t prints a table of every field of the packet instead.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "config.h"
+#include "packet_schema.h"
+
+static void print_table()
+{
+  printf("%-12s %-16s %6s %4s %-6s %-16s %s\n", "Field", "Column", "Offset", "Size", "Type", "Scaling", "Unit");
+  for (size_t i = 0; i < PACKET_FIELDS; i++)
+  {
+    const packet_field &f = packet_fields[i];
+    printf("%-12s %-16s %6zu %4zu %-6s %-16s %s%s\n", f.name, f.column, f.offset, f.size, f.numpy,
+           packet_converter(f.scale), f.unit, f.custom ? "  (custom)" : "");
+  }
+  printf("%-12s %-16s %6zu %4zu %-6s %-16s %s\n", "Checksum", "checksum", offsetof(HorusBinaryPacketV2, Checksum),
+         sizeof(uint16_t), "u2", "none", "-");
+}
+
+static void print_custom_fields(const char *callsign)
+{
+  char format[2 + HORUS_PACKET_CUSTOM_BYTES] = "<";
+  size_t n = 1;
+  for (size_t i = 0; i < PACKET_FIELDS; i++)
+  {
+    if (packet_fields[i].custom)
+    {
+      format[n++] = packet_fields[i].format;
+    }
+  }
+  format[n] = '\0';
+
+  printf("{\n  \"%s\": {\n    \"struct\": \"%s\",\n    \"fields\": [\n", callsign, format);
+  bool first = true;
+  for (size_t i = 0; i < PACKET_FIELDS; i++)
+  {
+    const packet_field &f = packet_fields[i];
+    if (!f.custom)
+    {
+      continue;
+    }
+    printf("%s      [\"%s\", \"%s\"]", first ? "" : ",\n", f.column, packet_converter(f.scale));
+    first = false;
+  }
+  printf("\n    ]\n  }\n}\n");
+}
+
+int main(int argc, char **argv)
+{
+  bool table = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "t")) != -1)
+  {
+    if (opt != 't')
+    {
+      fprintf(stderr, "usage: horus_fields [-t] [payload_callsign]\n");
+      return 2;
+    }
+    table = true;
+  }
+  if (table)
+  {
+    print_table();
+    return 0;
+  }
+  print_custom_fields(optind < argc ? argv[optind] : CALLSIGN);
+  return 0;
+}
@@ -0,0 +1,138 @@
+/*
+packet_schema.h, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// PACKET SCHEMA, COMPUTER SIDE
+// A table of the packet's fields for the tools, generated from the schema in packet.h: where each
+// field sits, how to read it, and how it scales to its unit. Also the packet decoder the tools share.
+// Header only, for tools built from a single file.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "packet.h"
+#include "crc_calc.h"
+
+enum packet_scale
+{
+  PACKET_SCALE_NONE,
+  PACKET_SCALE_DIV10,
+  PACKET_SCALE_DIV100,
+  PACKET_SCALE_BATT5V
+};
+
+// How a field's type is stored: kind is u (unsigned), s (signed) or f (float), format is its Python
+// struct character, and numpy its numpy type
+template <typename T>
+struct packet_type;
+template <>
+struct packet_type<uint8_t> { static constexpr char kind = 'u', format = 'B'; static constexpr const char *numpy = "u1"; };
+template <>
+struct packet_type<int8_t> { static constexpr char kind = 's', format = 'b'; static constexpr const char *numpy = "i1"; };
+template <>
+struct packet_type<uint16_t> { static constexpr char kind = 'u', format = 'H'; static constexpr const char *numpy = "u2"; };
+template <>
+struct packet_type<int16_t> { static constexpr char kind = 's', format = 'h'; static constexpr const char *numpy = "i2"; };
+template <>
+struct packet_type<uint32_t> { static constexpr char kind = 'u', format = 'I'; static constexpr const char *numpy = "u4"; };
+template <>
+struct packet_type<int32_t> { static constexpr char kind = 's', format = 'i'; static constexpr const char *numpy = "i4"; };
+template <>
+struct packet_type<float> { static constexpr char kind = 'f', format = 'f'; static constexpr const char *numpy = "f4"; };
+
+struct packet_field
+{
+  const char *name;   // Struct member
+  const char *column; // Lower case name for decoded data
+  size_t offset;
+  size_t size;
+  char kind;
+  char format;
+  const char *numpy;
+  packet_scale scale;
+  const char *unit;
+  bool custom; // In the user-customizable bytes
+};
+
+#define PACKET_FIELD_ENTRY(name, type, scale, unit, column, custom)                                  \
+  {#name, #column, offsetof(HorusBinaryPacketV2, name), sizeof(type), packet_type<type>::kind,       \
+   packet_type<type>::format, packet_type<type>::numpy, PACKET_SCALE_##scale, unit, custom},
+#define PACKET_FIELD_FIXED(name, type, scale, unit, column) PACKET_FIELD_ENTRY(name, type, scale, unit, column, false)
+#define PACKET_FIELD_CUSTOM(name, type, scale, unit, column) PACKET_FIELD_ENTRY(name, type, scale, unit, column, true)
+
+static const packet_field packet_fields[] = {
+    HORUS_PACKET_FIELDS_FIXED(PACKET_FIELD_FIXED) HORUS_PACKET_FIELDS_CUSTOM(PACKET_FIELD_CUSTOM)};
+#define PACKET_FIELDS (sizeof(packet_fields) / sizeof(packet_fields[0]))
+
+// horusdemodlib's name for each scaling, as used in its custom field list
+static inline const char *packet_converter(packet_scale scale)
+{
+  static const char *const names[] = {"none", "divide_by_10", "divide_by_100", "battery_5v_byte"};
+  return names[scale];
+}
+
+// The field's raw value, as stored in the packet bytes (little endian)
+static inline double packet_raw(const uint8_t *packet, const packet_field &field)
+{
+  const uint8_t *p = packet + field.offset;
+  if (field.kind == 'f')
+  {
+    float value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+  }
+  uint32_t value = 0;
+  for (size_t i = 0; i < field.size; i++)
+  {
+    value |= (uint32_t)p[i] << (8 * i);
+  }
+  if (field.kind == 's' && (value >> (8 * field.size - 1)))
+  {
+    value |= ~0UL << (8 * field.size - 1);
+    return (int32_t)value;
+  }
+  return value;
+}
+
+// The field in its unit
+static inline double packet_value(const uint8_t *packet, const packet_field &field)
+{
+  double raw = packet_raw(packet, field);
+  switch (field.scale)
+  {
+  case PACKET_SCALE_DIV10:
+    return raw / 10;
+  case PACKET_SCALE_DIV100:
+    return raw / 100;
+  case PACKET_SCALE_BATT5V:
+    return raw * 5 / 255;
+  default:
+    return raw;
+  }
+}
+
+// Takes a packet from its bytes, if the length and CRC are right
+static inline bool packet_decode(const uint8_t *bytes, size_t length, HorusBinaryPacketV2 *packet)
+{
+  if (length != sizeof(HorusBinaryPacketV2))
+  {
+    return false;
+  }
+  memcpy(packet, bytes, sizeof(*packet));
+  return (uint16_t)crc16((unsigned char *)bytes, sizeof(*packet) - 2) == packet->Checksum;
+}
@@ -0,0 +1,385 @@
+/*
+ram_report.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Reports where the tracker's static RAM goes, from a build. Reads the ELF files directly, so no ARM
+// toolchain is needed. Build and run from this folder with:
+//
+//   $ make ram_report
+//   $ ./ram_report [-e Tiny4FSK.ino.elf] [-n 15] [-r 32768] build_folder...
+//
+// The build folder is the one arduino-cli compile --build-path (or the IDE's verbose output) names.
+// Every object file under it is counted, grouped into the sketch's modules, each library and the
+// Arduino core. These are the sizes before the linker drops unused sections, so they can be a little
+// over. With -e, the firmware itself gives the exact total, the RAM left for the heap and the stacks
+// out of -r bytes, and the -n largest variables. Compare the stack peak that ram_print() reports
+// over USB against what is left.
+
+#include <cxxabi.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+// ELF constants, the few this needs
+#define SHT_SYMTAB 2
+#define SHT_NOBITS 8
+#define SHF_WRITE 0x1
+#define SHF_ALLOC 0x2
+#define SHN_COMMON 0xFFF2
+#define STT_OBJECT 1
+
+struct section
+{
+  std::string name;
+  uint32_t type;
+  uint64_t flags;
+  uint64_t offset;
+  uint64_t size;
+  uint32_t link;
+  uint64_t entsize;
+};
+
+struct symbol
+{
+  std::string name;
+  uint16_t section;
+  uint8_t type;
+  uint64_t size;
+};
+
+struct elf_file
+{
+  std::vector<section> sections;
+  std::vector<symbol> symbols;
+};
+
+struct ram_use
+{
+  uint64_t data = 0;
+  uint64_t bss = 0;
+};
+
+// Little-endian reads, 32 or 64-bit ELF, so host objects can be read too
+static uint64_t get(const std::vector<uint8_t> &file, uint64_t at, int bytes)
+{
+  uint64_t value = 0;
+  for (int i = bytes - 1; i >= 0; i--)
+  {
+    value = (value << 8) | (at + i < file.size() ? file[at + i] : 0);
+  }
+  return value;
+}
+
+static bool read_file(const char *path, std::vector<uint8_t> &file)
+{
+  FILE *f = fopen(path, "rb");
+  if (!f)
+  {
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  file.resize(ftell(f));
+  fseek(f, 0, SEEK_SET);
+  bool ok = fread(file.data(), 1, file.size(), f) == file.size();
+  fclose(f);
+  return ok;
+}
+
+static bool parse_elf(const char *path, elf_file &elf)
+{
+  std::vector<uint8_t> file;
+  if (!read_file(path, file) || file.size() < 52 || memcmp(file.data(), "\x7F" "ELF", 4) != 0 || file[5] != 1)
+  {
+    return false;
+  }
+  bool wide = file[4] == 2;
+  int word = wide ? 8 : 4;
+  uint64_t shoff = get(file, wide ? 0x28 : 0x20, word);
+  uint64_t shentsize = get(file, wide ? 0x3A : 0x2E, 2);
+  uint64_t shnum = get(file, wide ? 0x3C : 0x30, 2);
+  uint64_t shstrndx = get(file, wide ? 0x3E : 0x32, 2);
+  if (shoff == 0 || shoff + shnum * shentsize > file.size() || shstrndx >= shnum)
+  {
+    return false;
+  }
+
+  for (uint64_t i = 0; i < shnum; i++)
+  {
+    uint64_t at = shoff + i * shentsize;
+    section s;
+    s.name = std::to_string(get(file, at, 4)); // Offset into the names for now
+    s.type = get(file, at + 4, 4);
+    s.flags = get(file, at + 8, word);
+    s.offset = get(file, at + 8 + 2 * word, word);
+    s.size = get(file, at + 8 + 3 * word, word);
+    s.link = get(file, at + 8 + 4 * word, 4);
+    s.entsize = get(file, at + 16 + 5 * word, word);
+    elf.sections.push_back(s);
+  }
+  uint64_t names = elf.sections[shstrndx].offset;
+  for (section &s : elf.sections)
+  {
+    uint64_t at = names + strtoull(s.name.c_str(), NULL, 10);
+    s.name = at < file.size() ? std::string((const char *)&file[at], strnlen((const char *)&file[at], file.size() - at)) : "";
+  }
+
+  for (const section &s : elf.sections)
+  {
+    if (s.type != SHT_SYMTAB || s.entsize == 0 || s.link >= elf.sections.size())
+    {
+      continue;
+    }
+    uint64_t strings = elf.sections[s.link].offset;
+    for (uint64_t at = s.offset; at + s.entsize <= s.offset + s.size && at + s.entsize <= file.size(); at += s.entsize)
+    {
+      symbol sym;
+      uint64_t name = strings + get(file, at, 4);
+      sym.name = name < file.size() ? std::string((const char *)&file[name], strnlen((const char *)&file[name], file.size() - name)) : "";
+      if (wide)
+      {
+        sym.type = file[at + 4] & 0x0F;
+        sym.section = get(file, at + 6, 2);
+        sym.size = get(file, at + 16, 8);
+      }
+      else
+      {
+        sym.size = get(file, at + 8, 4);
+        sym.type = file[at + 12] & 0x0F;
+        sym.section = get(file, at + 14, 2);
+      }
+      elf.symbols.push_back(sym);
+    }
+  }
+  return true;
+}
+
+static bool in_ram(const section &s)
+{
+  return (s.flags & SHF_ALLOC) && (s.flags & SHF_WRITE);
+}
+
+static ram_use ram_of(const elf_file &elf)
+{
+  ram_use use;
+  for (const section &s : elf.sections)
+  {
+    if (in_ram(s))
+    {
+      (s.type == SHT_NOBITS ? use.bss : use.data) += s.size;
+    }
+  }
+  // Tentative definitions from C files compiled with -fcommon, given a place only at link time
+  for (const symbol &sym : elf.symbols)
+  {
+    if (sym.section == SHN_COMMON)
+    {
+      use.bss += sym.size;
+    }
+  }
+  return use;
+}
+
+// "sketch/oled.cpp.o" is the module oled.cpp, anything under libraries/SD/ is "SD library"
+static std::string module_of(const std::string &path)
+{
+  size_t lib = path.find("/libraries/");
+  if (lib != std::string::npos)
+  {
+    size_t start = lib + strlen("/libraries/");
+    return path.substr(start, path.find('/', start) - start) + " library";
+  }
+  if (path.find("/core/") != std::string::npos)
+  {
+    return "Arduino core";
+  }
+  std::string name = path.substr(path.rfind('/') + 1);
+  return name.substr(0, name.size() - 2);
+}
+
+static void find_objects(const std::string &path, std::vector<std::string> &objects)
+{
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0)
+  {
+    return;
+  }
+  if (!S_ISDIR(st.st_mode))
+  {
+    objects.push_back(path);
+    return;
+  }
+  DIR *dir = opendir(path.c_str());
+  if (!dir)
+  {
+    return;
+  }
+  while (dirent *entry = readdir(dir))
+  {
+    std::string name = entry->d_name;
+    if (name == "." || name == "..")
+    {
+      continue;
+    }
+    std::string child = path + "/" + name;
+    if (stat(child.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+    {
+      find_objects(child, objects);
+    }
+    else if (name.size() > 2 && name.compare(name.size() - 2, 2, ".o") == 0)
+    {
+      objects.push_back(child);
+    }
+  }
+  closedir(dir);
+}
+
+static std::string demangle(const std::string &name)
+{
+  int status = 0;
+  char *plain = abi::__cxa_demangle(name.c_str(), NULL, NULL, &status);
+  if (status != 0 || !plain)
+  {
+    return name;
+  }
+  std::string result = plain;
+  free(plain);
+  return result;
+}
+
+static void usage()
+{
+  fprintf(stderr, "usage: ram_report [-e firmware.elf] [-n largest] [-r ram_bytes] build_folder...\n");
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  const char *firmware = NULL;
+  int largest = 15;
+  uint64_t ram_size = 32768;
+  int opt;
+  while ((opt = getopt(argc, argv, "e:n:r:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'e':
+      firmware = optarg;
+      break;
+    case 'n':
+      largest = atoi(optarg);
+      break;
+    case 'r':
+      ram_size = strtoull(optarg, NULL, 0);
+      break;
+    default:
+      usage();
+    }
+  }
+  if (optind == argc && !firmware)
+  {
+    usage();
+  }
+
+  std::vector<std::string> objects;
+  for (int i = optind; i < argc; i++)
+  {
+    find_objects(argv[i], objects);
+  }
+  std::map<std::string, ram_use> modules;
+  int unreadable = 0;
+  for (const std::string &path : objects)
+  {
+    elf_file elf;
+    if (!parse_elf(path.c_str(), elf))
+    {
+      fprintf(stderr, "Not an ELF object: %s\n", path.c_str());
+      unreadable++;
+      continue;
+    }
+    ram_use use = ram_of(elf);
+    ram_use &module = modules[module_of(path)];
+    module.data += use.data;
+    module.bss += use.bss;
+  }
+
+  if (!modules.empty())
+  {
+    std::vector<std::pair<std::string, ram_use>> sorted(modules.begin(), modules.end());
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, ram_use> &a, const std::pair<std::string, ram_use> &b) {
+      return a.second.data + a.second.bss > b.second.data + b.second.bss;
+    });
+    printf("Static RAM by module, in bytes, before unused sections are dropped\n");
+    printf("  %-28s %8s %8s %8s\n", "Module", "data", "bss", "total");
+    ram_use total;
+    for (const auto &m : sorted)
+    {
+      if (m.second.data + m.second.bss == 0)
+      {
+        continue;
+      }
+      printf("  %-28s %8llu %8llu %8llu\n", m.first.c_str(), (unsigned long long)m.second.data,
+             (unsigned long long)m.second.bss, (unsigned long long)(m.second.data + m.second.bss));
+      total.data += m.second.data;
+      total.bss += m.second.bss;
+    }
+    printf("  %-28s %8llu %8llu %8llu\n", "Total", (unsigned long long)total.data,
+           (unsigned long long)total.bss, (unsigned long long)(total.data + total.bss));
+  }
+
+  if (firmware)
+  {
+    elf_file elf;
+    if (!parse_elf(firmware, elf))
+    {
+      fprintf(stderr, "Could not read %s\n", firmware);
+      return 1;
+    }
+    ram_use use = ram_of(elf);
+    uint64_t used = use.data + use.bss;
+    printf("\n%s: data %llu, bss %llu, static %llu of %llu bytes (%.1f%%)\n", firmware,
+           (unsigned long long)use.data, (unsigned long long)use.bss, (unsigned long long)used,
+           (unsigned long long)ram_size, used * 100.0 / ram_size);
+    printf("Left for the heap and the stacks: %lld bytes\n", (long long)ram_size - (long long)used);
+
+    std::vector<const symbol *> variables;
+    for (const symbol &sym : elf.symbols)
+    {
+      if (sym.type == STT_OBJECT && sym.size > 0 && sym.section < elf.sections.size() && in_ram(elf.sections[sym.section]))
+      {
+        variables.push_back(&sym);
+      }
+    }
+    std::sort(variables.begin(), variables.end(), [](const symbol *a, const symbol *b) { return a->size > b->size; });
+    if (largest > 0 && !variables.empty())
+    {
+      printf("\nLargest variables:\n");
+      for (int i = 0; i < largest && i < (int)variables.size(); i++)
+      {
+        printf("  %8llu  %-8s %s\n", (unsigned long long)variables[i]->size, elf.sections[variables[i]->section].name.c_str(),
+               demangle(variables[i]->name).c_str());
+      }
+    }
+  }
+  return unreadable ? 1 : 0;
+}
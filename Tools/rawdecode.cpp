@@ -0,0 +1,492 @@
+/*
+rawdecode.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Decodes the `raw` column of horusdemodlib CSV logs (the Media/Data format) again, straight from the
+// packet bytes, and checks every CRC. Good packets are written out as columns: one little-endian
+// binary file per field, plus columns.txt listing each file's type and unit. Runs on a computer, not
+// the tracker, on Linux or macOS. Build and run from this folder with:
+//
+//   $ make rawdecode
+//   $ ./rawdecode [-j threads] out_folder log.csv [log.csv ...]
+//
+// Each log is mapped into memory and split between threads at line breaks, so quoted fields may hold
+// commas but not line breaks. The hex is decoded 16 characters at a time with SSE2 where the compiler
+// has it, and a byte at a time otherwise. Rows keep the order of the logs.
+// Columns follow the packet schema in packet.h, and scaled fields are written as floats in their
+// unit. A column reads back in numpy with, for example, numpy.fromfile("out/latitude.f4", dtype="<f4").
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "packet_schema.h"
+
+#define PACKET_BYTES sizeof(HorusBinaryPacketV2)
+#define PACKET_HEX (2 * PACKET_BYTES)
+
+// *************
+// || Columns ||
+// *************
+
+struct column
+{
+  const char *name;
+  const char *type; // numpy style: u1, i1, u2, i2, f4
+  uint8_t size;
+  const char *unit;
+  void (*extract)(const HorusBinaryPacketV2 &packet, uint8_t *out);
+};
+
+template <typename T>
+static void put(uint8_t *out, T value)
+{
+  memcpy(out, &value, sizeof(value));
+}
+
+// Unscaled fields keep their type, scaled ones become floats in their unit
+template <packet_scale scale, typename T>
+static void put_column(uint8_t *out, T value)
+{
+  switch (scale)
+  {
+  case PACKET_SCALE_NONE:
+    put<T>(out, value);
+    break;
+  case PACKET_SCALE_DIV10:
+    put<float>(out, value / 10.0f);
+    break;
+  case PACKET_SCALE_DIV100:
+    put<float>(out, value / 100.0f);
+    break;
+  case PACKET_SCALE_BATT5V:
+    put<float>(out, value * 5.0f / 255);
+    break;
+  }
+}
+
+// One column per field of the packet schema
+#define COLUMN(name, type, scale, unit, column)                                                         \
+  {#column, PACKET_SCALE_##scale == PACKET_SCALE_NONE ? packet_type<type>::numpy : "f4",               \
+   PACKET_SCALE_##scale == PACKET_SCALE_NONE ? sizeof(type) : sizeof(float), unit,                     \
+   [](const HorusBinaryPacketV2 &p, uint8_t *out) { put_column<PACKET_SCALE_##scale, type>(out, p.name); }},
+
+static const column columns[] = {HORUS_PACKET_FIELDS(COLUMN)};
+#define COLUMNS (sizeof(columns) / sizeof(columns[0]))
+
+// *********
+// || Hex ||
+// *********
+
+static int8_t hex_value[256];
+
+static void hex_init()
+{
+  memset(hex_value, -1, sizeof(hex_value));
+  for (int i = 0; i < 10; i++)
+  {
+    hex_value['0' + i] = i;
+  }
+  for (int i = 0; i < 6; i++)
+  {
+    hex_value['A' + i] = 10 + i;
+    hex_value['a' + i] = 10 + i;
+  }
+}
+
+// PACKET_HEX characters to PACKET_BYTES bytes. False if any character is not hex.
+static bool hex_decode_scalar(const char *hex, uint8_t *out)
+{
+  int bad = 0;
+  for (size_t i = 0; i < PACKET_BYTES; i++)
+  {
+    int high = hex_value[(uint8_t)hex[2 * i]];
+    int low = hex_value[(uint8_t)hex[2 * i + 1]];
+    bad |= high | low;
+    out[i] = high << 4 | low;
+  }
+  return bad >= 0;
+}
+
+#ifdef __SSE2__
+// 16 characters to their nibble values, in place of the characters. valid gets a bit per character.
+static inline __m128i hex_nibbles(__m128i chars, int *valid)
+{
+  const __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20)); // Letters to lower case, digits stay
+  const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+  const __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+  *valid &= _mm_movemask_epi8(_mm_or_si128(digit, letter));
+  return _mm_or_si128(_mm_and_si128(digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+                      _mm_and_si128(letter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+}
+
+// Each 16-bit lane holds a high nibble in its low byte and a low nibble in its high byte
+static inline __m128i hex_pairs(__m128i nibbles)
+{
+  __m128i bytes = _mm_or_si128(_mm_slli_epi16(nibbles, 4), _mm_srli_epi16(nibbles, 8));
+  return _mm_and_si128(bytes, _mm_set1_epi16(0x00FF));
+}
+
+static bool hex_decode(const char *hex, uint8_t *out)
+{
+  static_assert(PACKET_HEX % 32 == 0, "The SSE2 decoder takes 32 characters at a time");
+  int valid = 0xFFFF;
+  for (size_t i = 0; i < PACKET_HEX; i += 32)
+  {
+    __m128i first = hex_nibbles(_mm_loadu_si128((const __m128i *)(hex + i)), &valid);
+    __m128i second = hex_nibbles(_mm_loadu_si128((const __m128i *)(hex + i + 16)), &valid);
+    _mm_storeu_si128((__m128i *)(out + i / 2), _mm_packus_epi16(hex_pairs(first), hex_pairs(second)));
+  }
+  return valid == 0xFFFF;
+}
+#else
+static bool hex_decode(const char *hex, uint8_t *out)
+{
+  return hex_decode_scalar(hex, out);
+}
+#endif
+
+// **********
+// || Work ||
+// **********
+
+struct chunk
+{
+  const char *start;
+  const char *end;
+  uint32_t rows;
+  uint32_t bad_hex; // raw missing, the wrong length or not hex
+  uint32_t bad_crc;
+  std::vector<uint8_t> data[COLUMNS];
+};
+
+// Start and length of field number index in a line, minding quotes
+static bool csv_field(const char *line, const char *end, int index, const char **field, size_t *length)
+{
+  bool quoted = false;
+  const char *start = line;
+  for (const char *p = line; p <= end; p++)
+  {
+    if (p < end && *p == '"')
+    {
+      quoted = !quoted;
+    }
+    else if (p == end || (*p == ',' && !quoted))
+    {
+      if (index-- == 0)
+      {
+        *field = start;
+        *length = p - start;
+        return true;
+      }
+      start = p + 1;
+    }
+  }
+  return false;
+}
+
+static void decode_chunk(chunk *work, int raw_column, bool raw_last)
+{
+  const char *line = work->start;
+  uint8_t bytes[PACKET_BYTES];
+  HorusBinaryPacketV2 packet;
+  uint8_t value[8];
+
+  while (line < work->end)
+  {
+    const char *end = (const char *)memchr(line, '\n', work->end - line);
+    end = end ? end : work->end;
+    const char *next = end + 1;
+    if (end > line && end[-1] == '\r')
+    {
+      end--;
+    }
+    if (end == line)
+    {
+      line = next;
+      continue;
+    }
+    work->rows++;
+
+    // The raw column is usually last, so it is found from the end of the line
+    const char *field = NULL;
+    size_t length = 0;
+    if (raw_last)
+    {
+      field = end;
+      while (field > line && field[-1] != ',')
+      {
+        field--;
+      }
+      length = end - field;
+    }
+    else if (!csv_field(line, end, raw_column, &field, &length))
+    {
+      length = 0;
+    }
+    if (length == PACKET_HEX + 2 && field[0] == '"')
+    {
+      field++;
+      length -= 2;
+    }
+    if (length != PACKET_HEX || !hex_decode(field, bytes))
+    {
+      work->bad_hex++;
+      line = next;
+      continue;
+    }
+
+    if (!packet_decode(bytes, PACKET_BYTES, &packet))
+    {
+      work->bad_crc++;
+      line = next;
+      continue;
+    }
+    for (size_t i = 0; i < COLUMNS; i++)
+    {
+      columns[i].extract(packet, value);
+      work->data[i].insert(work->data[i].end(), value, value + columns[i].size);
+    }
+    line = next;
+  }
+}
+
+// Maps a log and decodes it with the given number of threads. The chunks are added to the list.
+static bool decode_log(const char *filename, unsigned threads, std::vector<chunk *> *chunks, size_t *bytes)
+{
+  int fd = open(filename, O_RDONLY);
+  struct stat info;
+  if (fd < 0 || fstat(fd, &info) < 0)
+  {
+    perror(filename);
+    return false;
+  }
+  *bytes = info.st_size;
+  if (info.st_size == 0)
+  {
+    close(fd);
+    return true;
+  }
+  const char *data = (const char *)mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    perror(filename);
+    return false;
+  }
+  madvise((void *)data, info.st_size, MADV_SEQUENTIAL);
+  const char *end = data + info.st_size;
+
+  // Header
+  const char *body = (const char *)memchr(data, '\n', info.st_size);
+  body = body ? body + 1 : end;
+  const char *header_end = body > data && body[-1] == '\n' ? body - 1 : body;
+  if (header_end > data && header_end[-1] == '\r')
+  {
+    header_end--;
+  }
+  int raw_column = -1;
+  int count = 0;
+  for (int i = 0;; i++)
+  {
+    const char *field;
+    size_t length;
+    if (!csv_field(data, header_end, i, &field, &length))
+    {
+      break;
+    }
+    if (length == 3 && !memcmp(field, "raw", 3))
+    {
+      raw_column = i;
+    }
+    count++;
+  }
+  if (raw_column < 0)
+  {
+    fprintf(stderr, "%s has no raw column\n", filename);
+    munmap((void *)data, info.st_size);
+    return false;
+  }
+
+  // Equal shares, moved on to the next line break
+  std::vector<chunk *> work;
+  const char *start = body;
+  for (unsigned i = 0; i < threads && start < end; i++)
+  {
+    const char *stop = i + 1 == threads ? end : body + (end - body) * (i + 1) / threads;
+    if (stop < start)
+    {
+      stop = start;
+    }
+    const char *newline = (const char *)memchr(stop, '\n', end - stop);
+    stop = newline ? newline + 1 : end;
+    chunk *c = new chunk();
+    c->start = start;
+    c->end = stop;
+    work.push_back(c);
+    start = stop;
+  }
+
+  std::vector<std::thread> running;
+  for (chunk *c : work)
+  {
+    running.push_back(std::thread(decode_chunk, c, raw_column, raw_column == count - 1));
+  }
+  for (std::thread &t : running)
+  {
+    t.join();
+  }
+  munmap((void *)data, info.st_size);
+  chunks->insert(chunks->end(), work.begin(), work.end());
+  return true;
+}
+
+// Writes each column out, the chunks in order
+static bool write_columns(const std::string &folder, const std::vector<chunk *> &chunks, size_t packets)
+{
+  mkdir(folder.c_str(), 0777);
+  FILE *manifest = fopen((folder + "/columns.txt").c_str(), "w");
+  if (!manifest)
+  {
+    perror(folder.c_str());
+    return false;
+  }
+  fprintf(manifest, "# file type unit, %zu rows, little-endian\n", packets);
+  for (size_t i = 0; i < COLUMNS; i++)
+  {
+    std::string name = folder + "/" + columns[i].name + "." + columns[i].type;
+    FILE *out = fopen(name.c_str(), "wb");
+    if (!out)
+    {
+      perror(name.c_str());
+      fclose(manifest);
+      return false;
+    }
+    for (chunk *c : chunks)
+    {
+      fwrite(c->data[i].data(), 1, c->data[i].size(), out);
+    }
+    if (fclose(out) != 0)
+    {
+      perror(name.c_str());
+      fclose(manifest);
+      return false;
+    }
+    fprintf(manifest, "%s.%s %s %s\n", columns[i].name, columns[i].type, columns[i].type, columns[i].unit);
+  }
+  return fclose(manifest) == 0;
+}
+
+// The SSE2 decoder against the scalar one, on every byte value and on characters that are not hex
+static bool hex_self_test()
+{
+  char hex[PACKET_HEX + 1];
+  uint8_t expected[PACKET_BYTES], got[PACKET_BYTES];
+  for (int round = 0; round < 256; round++)
+  {
+    for (size_t i = 0; i < PACKET_BYTES; i++)
+    {
+      snprintf(hex + 2 * i, 3, (round + i) & 1 ? "%02X" : "%02x", (unsigned)(round * 7 + i) & 0xFF);
+    }
+    if (!hex_decode_scalar(hex, expected) || !hex_decode(hex, got) || memcmp(expected, got, sizeof(got)))
+    {
+      return false;
+    }
+    hex[round % PACKET_HEX] = "g/:@G`\x80 "[round % 8];
+    if (hex_decode(hex, got) || hex_decode_scalar(hex, expected))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  unsigned threads = std::thread::hardware_concurrency();
+  int arg = 1;
+  if (arg + 1 < argc && !strcmp(argv[arg], "-j"))
+  {
+    threads = atoi(argv[arg + 1]);
+    arg += 2;
+  }
+  threads = threads ? threads : 1;
+  if (argc - arg < 2)
+  {
+    fprintf(stderr, "usage: %s [-j threads] out_folder log.csv [log.csv ...]\n", argv[0]);
+    return 1;
+  }
+  hex_init();
+  if (!hex_self_test())
+  {
+    fprintf(stderr, "The hex decoder failed its self test\n");
+    return 1;
+  }
+
+  std::string folder = argv[arg++];
+  std::vector<chunk *> chunks;
+  size_t total_bytes = 0;
+  struct timespec start, stop;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (; arg < argc; arg++)
+  {
+    size_t bytes = 0;
+    if (!decode_log(argv[arg], threads, &chunks, &bytes))
+    {
+      return 1;
+    }
+    total_bytes += bytes;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+  double seconds = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+
+  size_t rows = 0, bad_hex = 0, bad_crc = 0;
+  for (chunk *c : chunks)
+  {
+    rows += c->rows;
+    bad_hex += c->bad_hex;
+    bad_crc += c->bad_crc;
+  }
+  size_t packets = rows - bad_hex - bad_crc;
+  if (!write_columns(folder, chunks, packets))
+  {
+    return 1;
+  }
+  fprintf(stderr, "%zu rows: %zu good, %zu bad CRC, %zu without a packet\n", rows, packets, bad_crc, bad_hex);
+  fprintf(stderr, "Decoded %.1f MB in %.3f s on %u threads (%s): %.0f MB/s\n", total_bytes / 1e6, seconds, threads,
+#ifdef __SSE2__
+          "SSE2",
+#else
+          "scalar",
+#endif
+          total_bytes / 1e6 / seconds);
+  for (chunk *c : chunks)
+  {
+    delete c;
+  }
+  return 0;
+}
@@ -0,0 +1,815 @@
+/*
+replay.cpp, part of Tiny4FSK, for a high-altitude tracker.
+Copyright (C) 2026 Maxwell Kendall
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Flies the tracker firmware through a recorded flight, on a computer, much faster than real time.
+// Each packet received in a horusdemodlib CSV log (Media/Data) is turned back into what the tracker's
+// sensors saw: NMEA sentences for the GPS, register contents for the BME280, and ADC results for the
+// battery. The sketch itself (Tiny4FSK.ino) is built in, with the host stand-ins in hal/ for the parts
+// of the board that are not modelled. It boots, reads the sentences through gpsFeed(), builds each
+// packet with build_horus_binary_packet_v2() and encodes it. The packet is checked against the `raw`
+// column of the log, field by field, and the encoding is checked by decoding it again.
+// Build and run from this folder with:
+//
+//   $ make replay
+//   $ ./replay [-v] [-o seconds] [log.csv ...]
+//
+// With no logs given, the three test flights in Media/Data are replayed. -v shows what the tracker
+// prints over USB.
+// The Makefile switches on store and forward and dead reckoning for the replay. The packets kept for
+// store and forward (backfill.h) are decoded as they come due, and checked for their flag, CRC and
+// counter. The slots they would take are not simulated.
+// -o takes the GPS away for that many seconds out of every 10 minutes of flight, to try the dead
+// reckoning (track.h): the packets built meanwhile are checked against where the log says the tracker
+// really was, next to what holding the last fix would have given.
+// The logged packets came from earlier firmware, so some fields are expected to differ:
+//  - PayloadID is HORUS_ID from config.h. The logged ID is swapped for it, and the CRC redone.
+//  - AscentRate was always 0 in the firmware these flights used.
+//  - The fields after BattVoltage follow whatever layout the tracker flew with. IMUFlightTest.csv used
+//    a different one.
+//  - The simulated BME280 rounds one temperature of TestFlight2-5-21-25.csv the other way.
+//  - The checksum differs wherever another field does.
+// These are listed, with how many packets each differs in, in known_mismatches below. A field that
+// differs in more packets than listed (or at all, if it is not listed) is a change in how the firmware
+// builds packets, and replay exits with 1. Without -o, that is. The positions built through outages
+// are not expected to match.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// Included ahead of the sketch, so the host ADC hook is declared
+#include "voltage.h"
+#include "oled.h"
+#include "packet_schema.h"
+#include "csv_log.h"
+
+// ****************
+// || Simulation ||
+// ****************
+// The firmware runs on simulated time, which only moves when it waits or the replay moves it on
+
+static uint64_t sim_us = 0;
+
+unsigned long millis()
+{
+  return sim_us / 1000;
+}
+
+unsigned long micros()
+{
+  return sim_us;
+}
+
+void delay(unsigned long ms)
+{
+  sim_us += ms * 1000ULL;
+}
+
+// Busy waits spin on yield(), and the gpsFeed task would run meanwhile. A millisecond goes by.
+void yield()
+{
+  sim_us += 1000;
+}
+
+// The sketch, built as the Arduino IDE builds it: ARDUINO set, and its functions declared up front
+#define ARDUINO 10819
+void gpsFeed();
+bool gps_can_rest();
+int build_horus_binary_packet_v2(char *buffer);
+#include "Tiny4FSK.ino"
+
+void golay23_init(void);
+
+// ***********
+// || BME280 ||
+// ***********
+// The sensor on the I2C bus, with typical factory calibration. A forced conversion turns the current
+// target readings into raw ADC values, using the datasheet compensation backwards.
+
+#define BME_T1 27504
+#define BME_T2 26435
+#define BME_T3 -1000
+#define BME_P1 36477
+#define BME_P2 -10685
+#define BME_P3 3024
+#define BME_P4 2855
+#define BME_P5 140
+#define BME_P6 -7
+#define BME_P7 15500
+#define BME_P8 -14600
+#define BME_P9 6000
+#define BME_H1 75
+#define BME_H2 362
+#define BME_H3 0
+#define BME_H4 313
+#define BME_H5 50
+#define BME_H6 30
+
+static uint8_t bme_registers[256];
+static uint8_t bme_pointer = 0;
+static int32_t target_temperature = 2000; // Hundredths of a degree C
+static int32_t target_pressure = 101325;  // Pa
+static int32_t target_humidity = 5000;    // Hundredths of a percent
+
+// Bosch's 32-bit integer compensation, datasheet section 4.2.3
+static int32_t bme_t_fine(int32_t adc_T)
+{
+  int32_t var1 = ((((adc_T >> 3) - ((int32_t)BME_T1 << 1))) * ((int32_t)BME_T2)) >> 11;
+  int32_t var2 = (((((adc_T >> 4) - ((int32_t)BME_T1)) * ((adc_T >> 4) - ((int32_t)BME_T1))) >> 12) * ((int32_t)BME_T3)) >> 14;
+  return var1 + var2;
+}
+
+static int32_t bme_temperature(int32_t adc_T)
+{
+  return (bme_t_fine(adc_T) * 5 + 128) >> 8;
+}
+
+static uint32_t bme_pressure(int32_t adc_P, int32_t t_fine)
+{
+  int32_t var1 = (t_fine >> 1) - 64000;
+  int32_t var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * BME_P6;
+  var2 = var2 + ((var1 * BME_P5) << 1);
+  var2 = (var2 >> 2) + (BME_P4 << 16);
+  var1 = (((BME_P3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) + ((BME_P2 * var1) >> 1)) >> 18;
+  var1 = ((32768 + var1) * BME_P1) >> 15;
+  // Past the lowest pressure the raw value can give, about 1.5 kPa here, the arithmetic wraps around.
+  // Reading 0 Pa there keeps the reading falling all the way, for bme_solve().
+  if (var1 == 0 || 1048576 - adc_P <= (var2 >> 12))
+  {
+    return 0;
+  }
+  uint32_t p = (((uint32_t)(1048576 - adc_P)) - (var2 >> 12)) * 3125;
+  p = p < 0x80000000 ? (p << 1) / (uint32_t)var1 : (p / (uint32_t)var1) * 2;
+  var1 = (BME_P9 * ((int32_t)(((p >> 3) * (p >> 3)) >> 13))) >> 12;
+  var2 = (((int32_t)(p >> 2)) * BME_P8) >> 13;
+  return (uint32_t)((int32_t)p + ((var1 + var2 + BME_P7) >> 4));
+}
+
+static uint32_t bme_humidity(int32_t adc_H, int32_t t_fine)
+{
+  int32_t h = t_fine - 76800;
+  h = (((((adc_H << 14) - (((int32_t)BME_H4) << 20) - (((int32_t)BME_H5) * h)) + 16384) >> 15) *
+       (((((((h * ((int32_t)BME_H6)) >> 10) * (((h * ((int32_t)BME_H3)) >> 11) + 32768)) >> 10) + 2097152) *
+             ((int32_t)BME_H2) +
+         8192) >>
+        14));
+  h = h - (((((h >> 15) * (h >> 15)) >> 7) * ((int32_t)BME_H1)) >> 4);
+  h = h < 0 ? 0 : h;
+  h = h > 419430400 ? 419430400 : h;
+  return ((uint32_t)(h >> 12) * 25) >> 8;
+}
+
+// Smallest raw value in [0, limit] where reading(raw) reaches the target. rising says which way the
+// reading goes as the raw value grows.
+template <typename F>
+static int32_t bme_solve(F reading, int64_t target, int32_t limit, bool rising)
+{
+  int32_t low = 0;
+  int32_t high = limit;
+  while (low < high)
+  {
+    int32_t middle = low + (high - low) / 2;
+    int64_t value = reading(middle);
+    if (rising ? value >= target : value <= target)
+    {
+      high = middle;
+    }
+    else
+    {
+      low = middle + 1;
+    }
+  }
+  return low;
+}
+
+// A forced conversion, leaving its results in the data registers
+static void bme_convert()
+{
+  int32_t adc_T = bme_solve([](int32_t adc) { return (int64_t)bme_temperature(adc); }, target_temperature, 0xFFFFF, true);
+  int32_t t_fine = bme_t_fine(adc_T);
+  int32_t adc_P = bme_solve([t_fine](int32_t adc) { return (int64_t)bme_pressure(adc, t_fine); }, target_pressure, 0xFFFFF, false);
+  int32_t adc_H = bme_solve([t_fine](int32_t adc) { return (int64_t)bme_humidity(adc, t_fine); }, target_humidity, 0xFFFF, true);
+
+  uint8_t *data = bme_registers + 0xF7;
+  data[0] = adc_P >> 12;
+  data[1] = adc_P >> 4;
+  data[2] = adc_P << 4;
+  data[3] = adc_T >> 12;
+  data[4] = adc_T >> 4;
+  data[5] = adc_T << 4;
+  data[6] = adc_H >> 8;
+  data[7] = adc_H;
+}
+
+static void bme_reset()
+{
+  static const int32_t calibration[] = {BME_T1, BME_T2, BME_T3, BME_P1, BME_P2, BME_P3,
+                                        BME_P4, BME_P5, BME_P6, BME_P7, BME_P8, BME_P9};
+  memset(bme_registers, 0, sizeof(bme_registers));
+  for (uint8_t i = 0; i < sizeof(calibration) / sizeof(calibration[0]); i++)
+  {
+    bme_registers[0x88 + 2 * i] = calibration[i] & 0xFF;
+    bme_registers[0x89 + 2 * i] = (calibration[i] >> 8) & 0xFF;
+  }
+  bme_registers[0xA1] = BME_H1;
+  bme_registers[0xD0] = 0x60;
+  bme_registers[0xE1] = BME_H2 & 0xFF;
+  bme_registers[0xE2] = BME_H2 >> 8;
+  bme_registers[0xE3] = BME_H3;
+  bme_registers[0xE4] = BME_H4 >> 4;
+  bme_registers[0xE5] = (BME_H4 & 0x0F) | ((BME_H5 & 0x0F) << 4);
+  bme_registers[0xE6] = BME_H5 >> 4;
+  bme_registers[0xE7] = BME_H6;
+  // Nothing converted yet
+  bme_registers[0xFA] = 0x80;
+}
+
+// The first byte written sets the register pointer, and the rest are written from there
+static void bus_write(uint8_t address, const uint8_t *data, size_t length)
+{
+  if (address != BME_ADDRESS || length == 0)
+  {
+    return;
+  }
+  bme_pointer = data[0];
+  for (size_t i = 1; i < length; i++)
+  {
+    bme_registers[bme_pointer] = data[i];
+    if (bme_pointer == 0xF4 && (data[i] & 0x03) == 0x01)
+    {
+      bme_convert();
+    }
+    bme_pointer++;
+  }
+}
+
+// The BME280 and the OLED answer. The OLED is never read.
+static bool bus_read(uint8_t address, uint8_t *data, size_t length)
+{
+  if (address == SSD1306_I2C_ADDRESS)
+  {
+    return true;
+  }
+  if (address != BME_ADDRESS)
+  {
+    return false;
+  }
+  for (size_t i = 0; i < length; i++)
+  {
+    data[i] = bme_registers[bme_pointer++];
+  }
+  return true;
+}
+
+// *********
+// || ADC ||
+// *********
+// Both inputs are halved and compared with VDDANA / 2, so full scale is the supply
+
+#define ADC_SUPPLY_MV 3300.0
+
+static double battery_mv = 3700;
+
+static uint16_t adc_result(double mv)
+{
+  double result = mv / ADC_SUPPLY_MV * 65536;
+  return result > 65535 ? 65535 : (uint16_t)lround(result);
+}
+
+static uint16_t adc_convert(uint8_t mux)
+{
+  return adc_result(mux == VOLTAGE_MUX_BANDGAP ? VOLTAGE_BANDGAP_MV : battery_mv / VOLTAGE_DIVIDER);
+}
+
+// *********
+// || Log ||
+// *********
+
+struct log_row
+{
+  int64_t seconds; // GPS time, seconds since 1970
+  uint16_t frame;
+  double lat, lon, alt;
+  int sats, speed_kmph;
+  double temp, ext_temperature, ext_humidity, ext_pressure, batt;
+  bool has_ext_temperature;
+  uint8_t raw[sizeof(HorusBinaryPacketV2)];
+};
+
+static bool hex_bytes(const std::string &hex, uint8_t *out, size_t length)
+{
+  if (hex.size() != length * 2)
+  {
+    return false;
+  }
+  for (size_t i = 0; i < length; i++)
+  {
+    unsigned value;
+    if (sscanf(hex.c_str() + 2 * i, "%2x", &value) != 1)
+    {
+      return false;
+    }
+    out[i] = value;
+  }
+  return true;
+}
+
+// Reads a log, keeping one row per packet (every receiver uploads its own copy), in time order.
+// Rows with a bad CRC are dropped.
+static bool log_read(const char *filename, std::vector<log_row> *rows, int *row_count)
+{
+  FILE *file = fopen(filename, "r");
+  if (!file)
+  {
+    fprintf(stderr, "Could not open %s\n", filename);
+    return false;
+  }
+  std::string line;
+  std::vector<std::string> header;
+  int c;
+  *row_count = 0;
+  enum
+  {
+    DATETIME,
+    FRAME,
+    LAT,
+    LON,
+    ALT,
+    SATS,
+    SPEED,
+    TEMP,
+    EXT_TEMPERATURE,
+    EXT_HUMIDITY,
+    EXT_PRESSURE,
+    BATT,
+    RAW,
+    COLUMNS
+  };
+  static const char *names[COLUMNS] = {"datetime", "frame", "lat", "lon", "alt", "sats", "speed", "temp",
+                                       "ext_temperature", "ext_humidity", "ext_pressure", "batt", "raw"};
+  int columns[COLUMNS];
+
+  while ((c = fgetc(file)) != EOF || !line.empty())
+  {
+    if (c != '\n' && c != EOF)
+    {
+      line += (char)c;
+      continue;
+    }
+    std::vector<std::string> fields = csv_split(line);
+    line.clear();
+    if (header.empty())
+    {
+      header = fields;
+      for (int i = 0; i < COLUMNS; i++)
+      {
+        columns[i] = csv_column(header, names[i]);
+        if (columns[i] < 0 && i != EXT_TEMPERATURE)
+        {
+          fprintf(stderr, "%s has no %s column\n", filename, names[i]);
+          fclose(file);
+          return false;
+        }
+      }
+      continue;
+    }
+    if (fields.size() < header.size())
+    {
+      continue;
+    }
+    (*row_count)++;
+
+    log_row row;
+    int year, month, day, hour, minute, second;
+    if (sscanf(fields[columns[DATETIME]].c_str(), "%d-%d-%dT%d:%d:%d", &year, &month, &day, &hour, &minute, &second) != 6 ||
+        !hex_bytes(fields[columns[RAW]], row.raw, sizeof(row.raw)) ||
+        crc16(row.raw, sizeof(row.raw) - 2) != (uint16_t)(row.raw[sizeof(row.raw) - 2] | row.raw[sizeof(row.raw) - 1] << 8))
+    {
+      continue;
+    }
+    row.seconds = days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    row.frame = atoi(fields[columns[FRAME]].c_str());
+    row.lat = atof(fields[columns[LAT]].c_str());
+    row.lon = atof(fields[columns[LON]].c_str());
+    row.alt = atof(fields[columns[ALT]].c_str());
+    row.sats = atoi(fields[columns[SATS]].c_str());
+    row.speed_kmph = atoi(fields[columns[SPEED]].c_str());
+    row.temp = atof(fields[columns[TEMP]].c_str());
+    row.has_ext_temperature = columns[EXT_TEMPERATURE] >= 0;
+    row.ext_temperature = row.has_ext_temperature ? atof(fields[columns[EXT_TEMPERATURE]].c_str()) : 0;
+    row.ext_humidity = atof(fields[columns[EXT_HUMIDITY]].c_str());
+    row.ext_pressure = atof(fields[columns[EXT_PRESSURE]].c_str());
+    row.batt = atof(fields[columns[BATT]].c_str());
+    rows->push_back(row);
+  }
+  fclose(file);
+
+  std::stable_sort(rows->begin(), rows->end(), [](const log_row &a, const log_row &b)
+                   { return a.seconds != b.seconds ? a.seconds < b.seconds : a.frame < b.frame; });
+  rows->erase(std::unique(rows->begin(), rows->end(), [](const log_row &a, const log_row &b)
+                          { return a.frame == b.frame && a.seconds == b.seconds; }),
+              rows->end());
+  return true;
+}
+
+// **********
+// || NMEA ||
+// **********
+
+// ddmm.mmmmmm or dddmm.mmmmmm, then the hemisphere
+static char *nmea_angle(char *out, double angle, int degree_digits, char positive, char negative)
+{
+  int64_t micro_minutes = llround(fabs(angle) * 60e6);
+  return out + sprintf(out, "%0*lld%02lld.%06lld,%c", degree_digits, (long long)(micro_minutes / 60000000),
+                       (long long)(micro_minutes % 60000000 / 1000000), (long long)(micro_minutes % 1000000),
+                       angle < 0 ? negative : positive);
+}
+
+static void nmea_send(char *sentence)
+{
+  uint8_t checksum = 0;
+  for (char *c = sentence + 1; *c; c++)
+  {
+    checksum ^= *c;
+  }
+  sprintf(sentence + strlen(sentence), "*%02X\r\n", checksum);
+  Serial1.host_feed(sentence, strlen(sentence));
+}
+
+// The RMC and GGA sentences the GPS sends for one fix. The logged speed was cut down to whole km/h,
+// so the middle of that km/h is sent.
+static void nmea_fix(const log_row &row)
+{
+  int64_t days = row.seconds / 86400;
+  int seconds = row.seconds % 86400;
+  int64_t z = days + 719468;
+  int64_t era = z / 146097;
+  unsigned doe = z - era * 146097;
+  unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  unsigned mp = (5 * doy + 2) / 153;
+  unsigned day = doy - (153 * mp + 2) / 5 + 1;
+  unsigned month = mp < 10 ? mp + 3 : mp - 9;
+  unsigned year = (yoe + era * 400 + (month <= 2)) % 100;
+
+  char position[48];
+  char *p = nmea_angle(position, row.lat, 2, 'N', 'S');
+  *p++ = ',';
+  nmea_angle(p, row.lon, 3, 'E', 'W');
+
+  char sentence[128];
+  sprintf(sentence, "$GPRMC,%02d%02d%02d.00,A,%s,%.3f,0.0,%02u%02u%02u,,,A", seconds / 3600, seconds / 60 % 60,
+          seconds % 60, position, (row.speed_kmph + 0.5) / 1.852, day, month, year);
+  nmea_send(sentence);
+  sprintf(sentence, "$GPGGA,%02d%02d%02d.00,%s,1,%02d,0.8,%.1f,M,0.0,M,,", seconds / 3600, seconds / 60 % 60,
+          seconds % 60, position, row.sats, row.alt);
+  nmea_send(sentence);
+}
+
+// ************
+// || Replay ||
+// ************
+
+// The schema's fields, and the CRC after them
+static const packet_field fields[] = {HORUS_PACKET_FIELDS_FIXED(PACKET_FIELD_FIXED) HORUS_PACKET_FIELDS_CUSTOM(PACKET_FIELD_CUSTOM)
+                                          PACKET_FIELD_ENTRY(Checksum, uint16_t, NONE, "-", checksum, false)};
+#define FIELDS (sizeof(fields) / sizeof(fields[0]))
+
+static void field_text(char *out, const packet_field &field, const uint8_t *packet)
+{
+  double value = packet_raw(packet, field);
+  sprintf(out, field.kind == 'f' ? "%.7f" : "%.0f", value);
+}
+
+// Sets the sensors up for a logged packet. The log gives the packet's rounded values, so each reading
+// is put in the middle of the range that rounds to it.
+static void sensors_set(const log_row &row)
+{
+  int32_t tenths = row.has_ext_temperature ? lround(row.ext_temperature * 10) : lround(row.temp) * 10;
+  target_temperature = tenths * 10 + (tenths < 0 ? -5 : 5);
+  target_humidity = lround(row.ext_humidity) * 100 + 50;
+  target_pressure = lround(row.ext_pressure * 10) * 10 + 5;
+  battery_mv = (lround(row.batt * 51) + 0.5) * 1000 / 51;
+}
+
+#define OUTAGE_EVERY_S 600
+
+// Seconds of GPS outage at the start of every OUTAGE_EVERY_S, from -o
+static int outage_s = 0;
+
+// Error of the positions given during outages, against the logged ones
+struct position_error
+{
+  double horizontal_sum, horizontal_max; // m
+  double vertical_sum, vertical_max;
+};
+
+static void position_error_add(position_error *error, double lat, double lon, double alt, const log_row &truth)
+{
+  double north = (lat - truth.lat) * 111320;
+  double east = (lon - truth.lon) * 111320 * cos(truth.lat * M_PI / 180);
+  double horizontal = sqrt(north * north + east * east);
+  double vertical = fabs(alt - truth.alt);
+  error->horizontal_sum += horizontal;
+  error->horizontal_max = std::max(error->horizontal_max, horizontal);
+  error->vertical_sum += vertical;
+  error->vertical_max = std::max(error->vertical_max, vertical);
+}
+
+static void position_error_print(const char *name, const position_error &error, uint32_t packets)
+{
+  printf("    %-14s horizontal mean %7.1f m, max %7.1f m; vertical mean %6.1f m, max %6.1f m\n", name,
+         error.horizontal_sum / packets, error.horizontal_max, error.vertical_sum / packets, error.vertical_max);
+}
+
+struct replay_result
+{
+  uint32_t packets;
+  uint32_t outage_packets;
+  uint32_t dead_reckoned;
+  position_error reckoned_error; // Of the dead reckoned packets
+  position_error held_error;     // Of the last fix, for the same packets
+  uint32_t exact;
+  uint32_t decode_errors;
+  uint32_t backfilled;
+  uint32_t backfill_errors;
+  uint32_t mismatches[FIELDS];
+  int64_t flight_seconds;
+  double wall_seconds;
+};
+
+// Boots the tracker on the first fix of the log, then builds every logged packet at its GPS time
+static void replay(const std::vector<log_row> &rows, replay_result *result)
+{
+  static char first_mismatch[FIELDS][96];
+  memset(result, 0, sizeof(*result));
+  memset(first_mismatch, 0, sizeof(first_mismatch));
+  if (rows.empty())
+  {
+    return;
+  }
+  clock_t start = clock();
+
+  // A fresh GPS, and one packet without a fix, so nothing is left over from the last flight
+  gps = TinyGPSPlus();
+  build_horus_binary_packet_v2(arena.raw);
+  bme_reset();
+  sensors_set(rows[0]);
+  nmea_fix(rows[0]);
+  setup();
+  uint64_t start_us = sim_us + 1000000;
+  const log_row *last_fix = &rows[0];
+
+  for (const log_row &row : rows)
+  {
+    uint64_t at_us = start_us + (uint64_t)(row.seconds - rows[0].seconds) * 1000000;
+    if (sim_us < at_us)
+    {
+      sim_us = at_us;
+    }
+    sensors_set(row);
+    bool outage = (row.seconds - rows[0].seconds) % OUTAGE_EVERY_S < outage_s;
+    if (!outage)
+    {
+      nmea_fix(row);
+      last_fix = &row;
+    }
+    gpsFeed();
+
+    // The start of loop()
+    packet_count = row.frame;
+    bme280_start();
+    int pkt_len = build_horus_binary_packet_v2(arena.raw);
+    int coded_len = horus_l2_encode_tx_packet((unsigned char *)arena.coded, (unsigned char *)arena.raw, pkt_len);
+
+    uint8_t decoded[sizeof(HorusBinaryPacketV2)];
+    horus_l2_decode_rx_packet(decoded, (unsigned char *)arena.coded, pkt_len);
+    if (coded_len != horus_l2_get_num_tx_data_bytes(pkt_len) || memcmp(decoded, arena.raw, pkt_len))
+    {
+      result->decode_errors++;
+    }
+
+    // A kept packet that has come due goes out as it was stored, so it has to decode to a packet sent
+    // before, flagged, with a good CRC
+    backfill_store(arena.raw, pkt_len, millis());
+    if (backfill_due(millis()))
+    {
+      char *frame;
+      int frame_len = backfill_take(&frame);
+      HorusBinaryPacketV2 kept;
+      horus_l2_decode_rx_packet((uint8_t *)&kept, (unsigned char *)frame, sizeof(kept));
+      result->backfilled++;
+      if (frame_len != coded_len || !(kept.dummy2 & PACKET_FLAG_BACKFILL) || kept.Counter >= row.frame ||
+          kept.Checksum != crc16((unsigned char *)&kept, sizeof(kept) - 2))
+      {
+        result->backfill_errors++;
+      }
+    }
+
+    // This build's ID in the logged packet
+    HorusBinaryPacketV2 expected;
+    memcpy(&expected, row.raw, sizeof(expected));
+    expected.PayloadID = HORUS_ID;
+    expected.Checksum = crc16((unsigned char *)&expected, sizeof(expected) - 2);
+
+    result->packets++;
+    if (outage)
+    {
+      const HorusBinaryPacketV2 *built = (const HorusBinaryPacketV2 *)arena.raw;
+      result->outage_packets++;
+      if (built->dummy2 & PACKET_FLAG_DEAD_RECKONED)
+      {
+        result->dead_reckoned++;
+        position_error_add(&result->reckoned_error, built->Latitude, built->Longitude, built->Altitude, row);
+        position_error_add(&result->held_error, last_fix->lat, last_fix->lon, last_fix->alt, row);
+      }
+    }
+
+    bool exact = true;
+    for (size_t i = 0; i < FIELDS; i++)
+    {
+      const uint8_t *want = (const uint8_t *)&expected + fields[i].offset;
+      const uint8_t *got = (const uint8_t *)arena.raw + fields[i].offset;
+      if (memcmp(want, got, fields[i].size))
+      {
+        exact = false;
+        if (result->mismatches[i]++ == 0)
+        {
+          char logged[24], built[24];
+          field_text(logged, fields[i], (const uint8_t *)&expected);
+          field_text(built, fields[i], (const uint8_t *)arena.raw);
+          snprintf(first_mismatch[i], sizeof(first_mismatch[i]), "first at frame %u: log %s, tracker %s", row.frame, logged, built);
+        }
+      }
+    }
+    result->exact += exact;
+  }
+
+  result->wall_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  result->flight_seconds = rows.back().seconds - rows[0].seconds;
+
+  for (size_t i = 0; i < FIELDS; i++)
+  {
+    if (result->mismatches[i])
+    {
+      printf("    %-12s %5u  %s\n", fields[i].name, result->mismatches[i], first_mismatch[i]);
+    }
+  }
+}
+
+// The fields each bundled log is known to differ in, and in how many packets. Any other field has to
+// match in every packet, and these in no fewer than listed, or the replay fails.
+struct known_mismatch
+{
+  const char *log;
+  const char *field;
+  uint32_t packets;
+};
+
+static const known_mismatch known_mismatches[] = {
+    // AscentRate was always 0 when these flew, and the checksum covers it
+    {"TestFlight6-21-25.csv", "AscentRate", 778},
+    {"TestFlight6-21-25.csv", "Checksum", 778},
+    {"TestFlight2-5-21-25.csv", "AscentRate", 1267},
+    {"TestFlight2-5-21-25.csv", "Checksum", 1267},
+    // The simulated BME280 lands on the other side of a whole degree once
+    {"TestFlight2-5-21-25.csv", "Temp", 1},
+    // This flight used another layout after BattVoltage
+    {"IMUFlightTest.csv", "AscentRate", 1159},
+    {"IMUFlightTest.csv", "ExtTemp", 1154},
+    {"IMUFlightTest.csv", "Humidity", 1159},
+    {"IMUFlightTest.csv", "ExtPress", 1159},
+    {"IMUFlightTest.csv", "dummy1", 1003},
+    {"IMUFlightTest.csv", "dummy2", 1159},
+    {"IMUFlightTest.csv", "Checksum", 1159},
+};
+
+// False if a field of a bundled log differs in more packets than it is known to. Other logs are only
+// reported.
+static bool mismatches_known(const char *name, const replay_result &result)
+{
+  bool bundled = false;
+  for (const known_mismatch &known : known_mismatches)
+  {
+    bundled = bundled || !strcmp(known.log, name);
+  }
+  if (!bundled)
+  {
+    printf("  No known mismatches for this log, so they are not checked\n");
+    return true;
+  }
+  bool ok = true;
+  for (size_t i = 0; i < FIELDS; i++)
+  {
+    uint32_t allowed = 0;
+    for (const known_mismatch &known : known_mismatches)
+    {
+      if (!strcmp(known.log, name) && !strcmp(known.field, fields[i].name))
+      {
+        allowed = known.packets;
+      }
+    }
+    if (result.mismatches[i] > allowed)
+    {
+      printf("  %s differs in %u packets, %u known: the firmware builds packets differently\n", fields[i].name,
+             result.mismatches[i], allowed);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+int main(int argc, char **argv)
+{
+  static const char *default_logs[] = {"../Media/Data/TestFlight6-21-25.csv", "../Media/Data/TestFlight2-5-21-25.csv",
+                                       "../Media/Data/IMUFlightTest.csv"};
+  std::vector<const char *> logs;
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "-v"))
+    {
+      SerialUSB.host_echo = stdout;
+    }
+    else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+    {
+      outage_s = atoi(argv[++i]);
+    }
+    else
+    {
+      logs.push_back(argv[i]);
+    }
+  }
+  if (logs.empty())
+  {
+    logs.assign(default_logs, default_logs + sizeof(default_logs) / sizeof(default_logs[0]));
+  }
+
+  golay23_init();
+  wire_host_on_write = bus_write;
+  wire_host_on_read = bus_read;
+  voltage_host_adc = adc_convert;
+
+  bool ok = true;
+  for (const char *filename : logs)
+  {
+    std::vector<log_row> rows;
+    int row_count;
+    if (!log_read(filename, &rows, &row_count))
+    {
+      ok = false;
+      continue;
+    }
+    const char *name = strrchr(filename, '/') ? strrchr(filename, '/') + 1 : filename;
+    printf("%s: %zu packets from %d rows\n", name, rows.size(), row_count);
+
+    replay_result result;
+    replay(rows, &result);
+    printf("  %u of %u packets match the log, field by field above\n", result.exact, result.packets);
+    // Positions built through simulated outages are not the logged ones
+    if (!outage_s)
+    {
+      ok = mismatches_known(name, result) && ok;
+    }
+    if (result.decode_errors)
+    {
+      printf("  %u packets did not decode back to what was encoded\n", result.decode_errors);
+      ok = false;
+    }
+    printf("  %u kept packets sent again, %u of them wrong\n", result.backfilled, result.backfill_errors);
+    ok = ok && result.backfill_errors == 0;
+    if (outage_s)
+    {
+      printf("  %u packets built during %d s GPS outages, %u dead reckoned\n", result.outage_packets, outage_s,
+             result.dead_reckoned);
+      if (result.dead_reckoned)
+      {
+        position_error_print("dead reckoned", result.reckoned_error, result.dead_reckoned);
+        position_error_print("last fix", result.held_error, result.dead_reckoned);
+      }
+    }
+    printf("  %lld s of flight replayed in %.3f s: %.0fx real time, %.0f packets/s\n", (long long)result.flight_seconds,
+           result.wall_seconds, result.flight_seconds / result.wall_seconds, result.packets / result.wall_seconds);
+  }
+  return ok ? 0 : 1;
+}